@@ -1,32 +1,38 @@
 #include "game.h"
-#include "memory.h"
 
-struct Asteroid*
-asteroid_new(float x, float y, float xvel, float yvel, float rot_speed)
-{
-	struct Asteroid *ast = make(struct Asteroid);
+Entity
+asteroid_spawn(
+	struct World *world,
+	float x,
+	float y,
+	float xvel,
+	float yvel,
+	float rot_speed
+) {
+	struct Body body = {
+		.x = scalar_from_float(x),
+		.y = scalar_from_float(y),
+		.xvel = scalar_from_float(xvel),
+		.yvel = scalar_from_float(yvel),
+		.radius = scalar_from_float(13),
+		.type = BODY_TYPE_ASTEROID,
+		.collision_mask = BODY_TYPE_PLAYER,
+	};
+	Entity ast = world_spawn(
+		world,
+		ECS_BIT(COMPONENT_TRANSFORM) |
+		ECS_BIT(COMPONENT_BODY) |
+		ECS_BIT(COMPONENT_TTL) |
+		ECS_BIT(COMPONENT_SPIN) |
+		ECS_BIT(COMPONENT_SPRITE) |
+		ECS_BIT(COMPONENT_SCROLL),
+		&body
+	);
 	if (!ast) {
-		return NULL;
+		return 0;
 	}
-	ast->x = x;
-	ast->y = y;
-	ast->rot_speed = rot_speed;
-	ast->ttl = ENTITY_TTL;
-	ast->body.xvel = xvel;
-	ast->body.yvel = yvel;
-	ast->body.x = x;
-	ast->body.y = y;
-	ast->body.radius = 13;
-	ast->body.type = BODY_TYPE_ASTEROID;
-	ast->body.collision_mask = BODY_TYPE_PLAYER;
-	ast->body.userdata = ast;
+	*(float*)ecs_get(world->ecs, ast, COMPONENT_TTL) = ENTITY_TTL;
+	*(float*)ecs_get(world->ecs, ast, COMPONENT_SPIN) = rot_speed;
+	*(int*)ecs_get(world->ecs, ast, COMPONENT_SPRITE) = SPRITE_ASTEROID;
 	return ast;
 }
-
-void
-asteroid_destroy(struct Asteroid *ast)
-{
-	if (ast) {
-		destroy(ast);
-	}
-}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "bitstream.h"
+#include <assert.h>
+#include <string.h>
+
+void
+bit_writer_init(struct BitWriter *w, void *data, size_t size)
+{
+	w->data = data;
+	w->size = size;
+	w->bit = 0;
+	w->overflow = 0;
+	memset(data, 0, size);
+}
+
+void
+bit_write(struct BitWriter *w, uint32_t value, unsigned bits)
+{
+	assert(bits > 0 && bits <= 32);
+
+	if (w->overflow || w->bit + bits > w->size * 8) {
+		w->overflow = 1;
+		return;
+	}
+
+	for (unsigned i = 0; i < bits; i++, w->bit++) {
+		if (value & ((uint32_t)1 << i)) {
+			w->data[w->bit / 8] |= 1 << (w->bit % 8);
+		}
+	}
+}
+
+size_t
+bit_writer_bytes(const struct BitWriter *w)
+{
+	return (w->bit + 7) / 8;
+}
+
+void
+bit_reader_init(struct BitReader *r, const void *data, size_t size)
+{
+	r->data = data;
+	r->size = size;
+	r->bit = 0;
+	r->overflow = 0;
+}
+
+uint32_t
+bit_read(struct BitReader *r, unsigned bits)
+{
+	assert(bits > 0 && bits <= 32);
+
+	if (r->overflow || r->bit + bits > r->size * 8) {
+		r->overflow = 1;
+		return 0;
+	}
+
+	uint32_t value = 0;
+	for (unsigned i = 0; i < bits; i++, r->bit++) {
+		if (r->data[r->bit / 8] & (1 << (r->bit % 8))) {
+			value |= (uint32_t)1 << i;
+		}
+	}
+	return value;
+}
+
+int32_t
+bit_read_signed(struct BitReader *r, unsigned bits)
+{
+	uint32_t value = bit_read(r, bits);
+	if (bits < 32 && value & ((uint32_t)1 << (bits - 1))) {
+		value |= ~(uint32_t)0 << bits;
+	}
+	return (int32_t)value;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Bit-packed stream writer.
+ *
+ * Values are written LSB first into a fixed size buffer. Writing past the end
+ * of the buffer sets the overflow flag and is otherwise ignored, so that a
+ * sequence of writes can be checked once at the end.
+ */
+struct BitWriter {
+	uint8_t *data;
+	size_t size;       // buffer size, in bytes
+	size_t bit;        // write position, in bits
+	int overflow;
+};
+
+/**
+ * Bit-packed stream reader.
+ *
+ * Reading past the end of the buffer sets the overflow flag and yields
+ * zeroes.
+ */
+struct BitReader {
+	const uint8_t *data;
+	size_t size;
+	size_t bit;
+	int overflow;
+};
+
+void
+bit_writer_init(struct BitWriter *w, void *data, size_t size);
+
+/**
+ * Write the lowest `bits` (1 to 32) bits of given value.
+ */
+void
+bit_write(struct BitWriter *w, uint32_t value, unsigned bits);
+
+/**
+ * Get the number of bytes written so far, including the partial last one.
+ */
+size_t
+bit_writer_bytes(const struct BitWriter *w);
+
+void
+bit_reader_init(struct BitReader *r, const void *data, size_t size);
+
+/**
+ * Read `bits` (1 to 32) bits as an unsigned value.
+ */
+uint32_t
+bit_read(struct BitReader *r, unsigned bits);
+
+/**
+ * Read `bits` bits as a two's complement signed value.
+ */
+int32_t
+bit_read_signed(struct BitReader *r, unsigned bits);
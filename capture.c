@@ -0,0 +1,350 @@
+#include "capture.h"
+#include "error.h"
+#include "image.h"
+#include "memory.h"
+#include "strutils.h"
+#include <GL/glew.h>
+#include <SDL.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_BUFFERS 3   // frames in flight between readback and mapping
+#define CAPTURE_QUEUE 4     // frames waiting to be encoded
+
+/**
+ * Frame queued for encoding, bottom row first as read back.
+ */
+struct CaptureJob {
+	unsigned long frame;
+	uint8_t *pixels;
+};
+
+struct Capture {
+	unsigned width, height;
+	size_t size;
+	char *prefix;
+	int format;
+	unsigned long frame;
+
+	// ring of pixel buffers being read back, the pending ones end at
+	// `next`
+	GLuint buffers[CAPTURE_BUFFERS];
+	GLsync fences[CAPTURE_BUFFERS];
+	unsigned long frames[CAPTURE_BUFFERS];
+	unsigned next;
+	unsigned pending;
+
+	// encoder thread and its queue, the queued jobs start at `head`; the
+	// one at `head` is left in the queue until it's encoded
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *cond;
+	struct CaptureJob queue[CAPTURE_QUEUE];
+	unsigned head;
+	unsigned len;
+	int quit;
+	int ok;
+};
+
+/**
+ * Flag the capture as failed, from the rendering thread.
+ */
+static void
+fail(struct Capture *capture)
+{
+	error(ERR_OPENGL);
+	SDL_LockMutex(capture->lock);
+	capture->ok = 0;
+	SDL_UnlockMutex(capture->lock);
+}
+
+/**
+ * Write a captured frame into a file.
+ */
+static int
+encode(const struct Capture *capture, struct CaptureJob *job)
+{
+	// flip the rows, for the top one to come first, and make the frame
+	// opaque, as it is on the screen
+	size_t pitch = capture->width * 4;
+	uint8_t *top = job->pixels;
+	uint8_t *bottom = job->pixels + pitch * (capture->height - 1);
+	for (; top < bottom; top += pitch, bottom -= pitch) {
+		for (size_t i = 0; i < pitch; i++) {
+			uint8_t tmp = top[i];
+			top[i] = bottom[i];
+			bottom[i] = tmp;
+		}
+	}
+	for (size_t i = 3; i < capture->size; i += 4) {
+		job->pixels[i] = 0xff;
+	}
+
+	struct Image image = {
+		.width = capture->width,
+		.height = capture->height,
+	};
+	image.pixels[IMAGE_FORMAT_RGBA8] = job->pixels;
+	image.sizes[IMAGE_FORMAT_RGBA8] = capture->size;
+
+	int png = capture->format == CAPTURE_FORMAT_PNG;
+	char *filename = string_fmt(
+		"%s%06lu%s",
+		capture->prefix,
+		job->frame,
+		png ? ".png" : IMAGE_FILE_EXT
+	);
+	if (!filename) {
+		return 0;
+	}
+	int ok = (
+		png ?
+		image_write_png(&image, filename) :
+		image_write(&image, filename)
+	);
+	free(filename);
+	return ok;
+}
+
+static int
+run(void *capture_ptr)
+{
+	struct Capture *capture = capture_ptr;
+	SDL_LockMutex(capture->lock);
+	for (;;) {
+		while (capture->len == 0 && !capture->quit) {
+			SDL_CondWait(capture->cond, capture->lock);
+		}
+		if (capture->len == 0) {
+			break;
+		}
+
+		// encode outside of the lock, the job stays reserved meanwhile
+		struct CaptureJob *job = &capture->queue[capture->head];
+		SDL_UnlockMutex(capture->lock);
+		int ok = encode(capture, job);
+		SDL_LockMutex(capture->lock);
+
+		capture->ok &= ok;
+		capture->head = (capture->head + 1) % CAPTURE_QUEUE;
+		capture->len--;
+		SDL_CondBroadcast(capture->cond);
+	}
+	SDL_UnlockMutex(capture->lock);
+	return 0;
+}
+
+struct Capture*
+capture_new(unsigned width, unsigned height, const char *prefix, int format)
+{
+	assert(prefix != NULL);
+
+	struct Capture *capture = make(struct Capture);
+	if (!capture) {
+		return NULL;
+	}
+	capture->width = width;
+	capture->height = height;
+	capture->size = (size_t)width * height * 4;
+	capture->format = format;
+	capture->ok = 1;
+	if (!(capture->prefix = string_fmt("%s", prefix))) {
+		goto error;
+	}
+
+	for (unsigned i = 0; i < CAPTURE_QUEUE; i++) {
+		if (!(capture->queue[i].pixels = malloc(capture->size))) {
+			error(ERR_NO_MEM);
+			goto error;
+		}
+	}
+
+	// allocate the pixel buffers, to be read back into by the GPU and read
+	// by the CPU
+	glGenBuffers(CAPTURE_BUFFERS, capture->buffers);
+	for (unsigned i = 0; i < CAPTURE_BUFFERS; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[i]);
+		glBufferData(
+			GL_PIXEL_PACK_BUFFER,
+			capture->size,
+			NULL,
+			GL_STREAM_READ
+		);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (glGetError() != GL_NO_ERROR) {
+		error(ERR_OPENGL);
+		goto error;
+	}
+
+	capture->lock = SDL_CreateMutex();
+	capture->cond = SDL_CreateCond();
+	if (!capture->lock || !capture->cond) {
+		fprintf(stderr, "failed to create mutex: %s\n", SDL_GetError());
+		error(ERR_SDL);
+		goto error;
+	}
+
+	capture->thread = SDL_CreateThread(run, "capture", capture);
+	if (!capture->thread) {
+		fprintf(stderr, "failed to create thread: %s\n", SDL_GetError());
+		error(ERR_SDL);
+		goto error;
+	}
+
+	return capture;
+
+error:
+	capture_destroy(capture);
+	return NULL;
+}
+
+/**
+ * Queue the oldest pending pixel buffer for encoding.
+ *
+ * Unless forced, gives up if the GPU is not done with the buffer yet or the
+ * encoder is behind, instead of waiting for them.
+ */
+static int
+queue_pending(struct Capture *capture, int force)
+{
+	assert(capture->pending > 0);
+
+	unsigned i = (
+		capture->next + CAPTURE_BUFFERS - capture->pending
+	) % CAPTURE_BUFFERS;
+	GLenum status = glClientWaitSync(
+		capture->fences[i],
+		GL_SYNC_FLUSH_COMMANDS_BIT,
+		force ? UINT64_MAX : 0
+	);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		return 0;
+	} else if (status == GL_WAIT_FAILED) {
+		fail(capture);
+		return 0;
+	}
+
+	SDL_LockMutex(capture->lock);
+	while (force && capture->len == CAPTURE_QUEUE) {
+		SDL_CondWait(capture->cond, capture->lock);
+	}
+	int full = capture->len == CAPTURE_QUEUE;
+	SDL_UnlockMutex(capture->lock);
+	if (full) {
+		return 0;
+	}
+
+	// the job after the queued ones isn't touched by the encoder
+	struct CaptureJob *job = &capture->queue[
+		(capture->head + capture->len) % CAPTURE_QUEUE
+	];
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[i]);
+	void *pixels = glMapBufferRange(
+		GL_PIXEL_PACK_BUFFER,
+		0,
+		capture->size,
+		GL_MAP_READ_BIT
+	);
+	if (pixels) {
+		memcpy(job->pixels, pixels, capture->size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteSync(capture->fences[i]);
+	capture->fences[i] = NULL;
+	capture->pending--;
+	if (!pixels) {
+		fail(capture);
+		return 0;
+	}
+	job->frame = capture->frames[i];
+
+	SDL_LockMutex(capture->lock);
+	capture->len++;
+	SDL_CondBroadcast(capture->cond);
+	SDL_UnlockMutex(capture->lock);
+	return 1;
+}
+
+void
+capture_destroy(struct Capture *capture)
+{
+	if (capture) {
+		if (capture->thread) {
+			// write all the frames read back so far
+			while (capture->pending > 0 && queue_pending(capture, 1));
+
+			SDL_LockMutex(capture->lock);
+			capture->quit = 1;
+			SDL_CondBroadcast(capture->cond);
+			SDL_UnlockMutex(capture->lock);
+			SDL_WaitThread(capture->thread, NULL);
+		}
+		if (capture->lock) {
+			SDL_DestroyMutex(capture->lock);
+		}
+		if (capture->cond) {
+			SDL_DestroyCond(capture->cond);
+		}
+		for (unsigned i = 0; i < CAPTURE_BUFFERS; i++) {
+			if (capture->fences[i]) {
+				glDeleteSync(capture->fences[i]);
+			}
+		}
+		glDeleteBuffers(CAPTURE_BUFFERS, capture->buffers);
+		for (unsigned i = 0; i < CAPTURE_QUEUE; i++) {
+			free(capture->queue[i].pixels);
+		}
+		free(capture->prefix);
+		destroy(capture);
+	}
+}
+
+int
+capture_frame(struct Capture *capture)
+{
+	assert(capture != NULL);
+
+	// hand the frames the GPU is done with over to the encoder, waiting
+	// only if the ring is full
+	while (capture->pending > 0 && queue_pending(capture, 0));
+	if (capture->pending == CAPTURE_BUFFERS) {
+		queue_pending(capture, 1);
+	}
+
+	// read the frame back into the next buffer; the read is only queued,
+	// for it's done into a buffer object
+	if (capture->pending < CAPTURE_BUFFERS) {
+		unsigned i = capture->next;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[i]);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(
+			0,
+			0,
+			capture->width,
+			capture->height,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			NULL
+		);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		capture->fences[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		capture->frames[i] = capture->frame;
+		capture->next = (i + 1) % CAPTURE_BUFFERS;
+		capture->pending++;
+	}
+	capture->frame++;
+
+	if (glGetError() != GL_NO_ERROR) {
+		fail(capture);
+	}
+
+	SDL_LockMutex(capture->lock);
+	int ok = capture->ok;
+	SDL_UnlockMutex(capture->lock);
+	return ok;
+}
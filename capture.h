@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * Capture file formats.
+ */
+enum {
+	CAPTURE_FORMAT_PNG,
+	CAPTURE_FORMAT_RAW,   // image container, see `image_write()`
+};
+
+/**
+ * Asynchronous frame capture.
+ *
+ * Frames are read back into a ring of pixel buffers, which are mapped a few
+ * frames later, when the GPU is done with them, and encoded into numbered
+ * files on a worker thread. Thus, capturing every frame doesn't stall the
+ * rendering.
+ */
+struct Capture;
+
+/**
+ * Create a capture of frames of given size in pixels.
+ *
+ * Files are named by the prefix followed by the frame number and the
+ * extension of the format.
+ */
+struct Capture*
+capture_new(unsigned width, unsigned height, const char *prefix, int format);
+
+/**
+ * Destroy a capture, waiting for all captured frames to be written.
+ */
+void
+capture_destroy(struct Capture *capture);
+
+/**
+ * Capture the frame rendered on the screen, before it's presented.
+ *
+ * Returns 0 if capturing or writing any of the previous frames failed.
+ */
+int
+capture_frame(struct Capture *capture);
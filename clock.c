@@ -0,0 +1,58 @@
+#include "clock.h"
+#include <SDL.h>
+#include <assert.h>
+
+#define CLOCK_MAX_DT 0.25f          // seconds
+#define CLOCK_SMOOTH_FACTOR 0.1f    // weight of the newest sample
+
+double
+clock_now(void)
+{
+	// counting from the first call keeps timestamps small, so that double
+	// precision is never lost on machines with a long uptime
+	static Uint64 base = 0;
+	static double period = 0;
+	if (period == 0) {
+		base = SDL_GetPerformanceCounter();
+		period = 1.0 / SDL_GetPerformanceFrequency();
+	}
+	return (SDL_GetPerformanceCounter() - base) * period;
+}
+
+void
+clock_init(struct Clock *clock)
+{
+	assert(clock != NULL);
+
+	clock->start = clock->last = clock_now();
+	clock->dt = clock->smooth_dt = 0;
+	clock->frame = 0;
+}
+
+float
+clock_tick(struct Clock *clock)
+{
+	assert(clock != NULL);
+
+	double now = clock_now();
+	float dt = now - clock->last;
+	clock->last = now;
+	if (dt > CLOCK_MAX_DT) {
+		dt = CLOCK_MAX_DT;
+	}
+
+	clock->dt = dt;
+	if (clock->frame++ == 0) {
+		clock->smooth_dt = dt;
+	} else {
+		clock->smooth_dt += (dt - clock->smooth_dt) * CLOCK_SMOOTH_FACTOR;
+	}
+	return dt;
+}
+
+double
+clock_elapsed(const struct Clock *clock)
+{
+	assert(clock != NULL);
+	return clock_now() - clock->start;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * Frame clock.
+ *
+ * Measures frame delta time with the resolution of the platform's
+ * high-performance monotonic counter.
+ */
+struct Clock {
+	double start;      // timestamp of clock initialization
+	double last;       // timestamp of the last tick
+	float dt;          // last frame delta time, in seconds
+	float smooth_dt;   // exponentially smoothed delta time, in seconds
+	unsigned long frame;
+};
+
+/**
+ * Get a monotonic timestamp, in seconds.
+ *
+ * Timestamps have sub-microsecond resolution on all supported platforms and
+ * are meant to be compared only with each other.
+ */
+double
+clock_now(void);
+
+/**
+ * Initialize a frame clock.
+ */
+void
+clock_init(struct Clock *clock);
+
+/**
+ * Advance the clock by one frame.
+ *
+ * Returns the delta time since the previous tick, clamped to
+ * `CLOCK_MAX_DT` so that a stall (debugger break, window drag) doesn't make
+ * the simulation catch up with hundreds of steps at once.
+ */
+float
+clock_tick(struct Clock *clock);
+
+/**
+ * Get the time elapsed since clock initialization, in seconds.
+ */
+double
+clock_elapsed(const struct Clock *clock);
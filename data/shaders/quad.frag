@@ -0,0 +1,82 @@
+#version 330 core
+
+in vec2 uv;
+flat in vec2 size;
+flat in vec2 origin;
+flat in uvec2 border;
+flat in uint kind;
+flat in uint slot;
+flat in uint layer;
+out vec4 out_color;
+
+// kinds of quads, matching those in renderer.c
+const uint SPRITE = 0u;   // layer of a texture array
+const uint WIDGET = 1u;   // texture with its middle columns repeated
+const uint GLYPH = 2u;    // character of a font atlas
+
+uniform sampler2DArray textures[4];
+uniform int pass;   // 0 - opaque texels, 1 - translucent ones
+
+vec4
+sample_layer(sampler2DArray tex, vec2 texel, vec2 dx, vec2 dy)
+{
+	vec2 tex_size = textureSize(tex, 0).xy;
+	return textureGrad(
+		tex,
+		vec3(texel / tex_size, layer),
+		dx / tex_size,
+		dy / tex_size
+	);
+}
+
+// NOTE: GLSL 3.30 indexes arrays of samplers by constants only
+vec4
+sample(vec2 texel, vec2 dx, vec2 dy)
+{
+	switch (slot) {
+	case 0u: return sample_layer(textures[0], texel, dx, dy);
+	case 1u: return sample_layer(textures[1], texel, dx, dy);
+	case 2u: return sample_layer(textures[2], texel, dx, dy);
+	default: return sample_layer(textures[3], texel, dx, dy);
+	}
+}
+
+vec2
+widget_texel()
+{
+	uint left = border.x;
+	uint right = border.y;
+	uint middle = right - left;
+	vec2 texel = uv;
+	if (uv.x > left && uv.x < size.x - right) {
+		texel.x = left + uint(uv.x) % middle;
+	} else if (uv.x > left + middle && uv.x >= size.x - right) {
+		texel.x = size.x - uv.x;
+	}
+	return texel;
+}
+
+void
+main()
+{
+	// texture coordinates are in texels; their derivatives are taken
+	// before any branching, and before widgets wrap them around
+	vec2 dx = dFdx(uv);
+	vec2 dy = dFdy(uv);
+
+	// all kinds sample the same way, only the coordinates and the use of
+	// the texel differ
+	vec2 texel = origin + (kind == WIDGET ? widget_texel() : uv);
+	vec4 color = sample(texel, dx, dy);
+	if (kind == GLYPH) {
+		color = vec4(color.r);
+	}
+
+	// the opaque pass draws only fully opaque texels, the translucent
+	// pass the rest, skipping those which wouldn't change anything
+	if (pass == 0 && color.a < 1.0 ||
+	    pass == 1 && (color.a == 0.0 || color.a == 1.0)) {
+		discard;
+	}
+	out_color = color;
+}
@@ -0,0 +1,55 @@
+#version 330 core
+
+// rows of the 2x3 affine transform of the instance
+layout(location=0) in vec3 in_transform_x;
+layout(location=1) in vec3 in_transform_y;
+layout(location=2) in vec2 in_size;
+layout(location=3) in vec2 in_origin;
+layout(location=4) in uvec2 in_border;
+layout(location=5) in float in_depth;
+layout(location=6) in uint in_kind;
+layout(location=7) in uint in_slot;
+layout(location=8) in uint in_layer;
+
+uniform mat4 projection;
+
+out vec2 uv;
+flat out vec2 size;
+flat out vec2 origin;
+flat out uvec2 border;
+flat out uint kind;
+flat out uint slot;
+flat out uint layer;
+
+// corners of the quad, from the top-left one
+const vec2 corners[4] = vec2[]
+(
+	vec2(0, 0),
+	vec2(0, 1),
+	vec2(1, 0),
+	vec2(1, 1)
+);
+
+void
+main()
+{
+	// compute vertex coordinate, the quad extends downwards
+	vec2 corner = corners[gl_VertexID];
+	vec3 pos = vec3(corner.x * in_size.x, -corner.y * in_size.y, 1);
+	gl_Position = projection * vec4(
+		dot(in_transform_x, pos),
+		dot(in_transform_y, pos),
+		0,
+		1
+	);
+	gl_Position.z = in_depth;
+
+	// compute texture coordinate, in texels from the origin
+	uv = corner * in_size;
+	size = in_size;
+	origin = in_origin;
+	border = in_border;
+	kind = in_kind;
+	slot = in_slot;
+	layer = in_layer;
+}
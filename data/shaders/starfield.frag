@@ -0,0 +1,52 @@
+#version 330 core
+
+in vec2 coord;
+out vec4 out_color;
+
+uniform float scroll;
+
+// layers from the farthest to the nearest; nearer stars are bigger,
+// brighter, sparser and scroll faster
+const int LAYERS = 3;
+const float CELL_SIZE[LAYERS] = float[](24.0, 48.0, 96.0);
+const float SPEED[LAYERS] = float[](0.2, 0.5, 1.0);
+const float RADIUS[LAYERS] = float[](0.5, 0.9, 1.4);
+const float BRIGHTNESS[LAYERS] = float[](0.35, 0.6, 1.0);
+
+uint
+hash(uvec3 v)
+{
+	uint h = v.x * 0x8da6b343u ^ v.y * 0xd8163841u ^ v.z * 0xcb1ab31fu;
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+	h *= 0x846ca68bu;
+	h ^= h >> 16;
+	return h;
+}
+
+void
+main()
+{
+	vec3 color = vec3(0);
+	for (int l = 0; l < LAYERS; l++) {
+		// each cell of the layer grid has at most a star, at a random
+		// position away from the cell edges
+		float size = CELL_SIZE[l];
+		vec2 p = coord + vec2(0, scroll * SPEED[l]);
+		vec2 cell = floor(p / size);
+		uint h = hash(uvec3(ivec2(cell), l));
+		if ((h & 3u) != 0u) {
+			continue;
+		}
+		vec2 offset = vec2((h >> 8) & 255u, (h >> 16) & 255u) / 255.0;
+		vec2 center = (cell + 0.2 + 0.6 * offset) * size;
+
+		// antialiased disc, slightly tinted either blue or yellow
+		float d = length(p - center);
+		float intensity = clamp(RADIUS[l] + 0.5 - d, 0.0, 1.0) * BRIGHTNESS[l];
+		float tint = float(h >> 24) / 255.0;
+		color += intensity * mix(vec3(0.8, 0.9, 1), vec3(1, 0.95, 0.8), tint);
+	}
+	out_color = vec4(color, 1);
+}
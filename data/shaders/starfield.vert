@@ -0,0 +1,22 @@
+#version 330 core
+
+// scale and offset from clip space to world space
+uniform vec4 unproject;
+
+out vec2 coord;
+
+// a single triangle covering the whole screen
+const vec2 positions[3] = vec2[]
+(
+	vec2(-1, -1),
+	vec2(3, -1),
+	vec2(-1, 3)
+);
+
+void
+main()
+{
+	vec2 pos = positions[gl_VertexID];
+	gl_Position = vec4(pos, 0, 1);
+	coord = pos * unproject.xy + unproject.zw;
+}
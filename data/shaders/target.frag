@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 uv;
+flat in uint layer;
+out vec4 out_color;
+
+uniform sampler2DArray tex;
+
+void
+main()
+{
+	// texture coordinates are in texels
+	out_color = texture(tex, vec3(uv / textureSize(tex, 0).xy, layer));
+}
@@ -0,0 +1,188 @@
+#include "dynres.h"
+#include "error.h"
+#include "memory.h"
+#include "renderer.h"
+#include <GL/glew.h>
+#include <assert.h>
+#include <math.h>
+
+#define DYNRES_QUERIES 4          // timer queries in flight
+#define DYNRES_SMOOTHING 0.1f     // weight of new measurements in the average
+#define DYNRES_HEADROOM 0.8f      // fraction of budget below which to scale up
+#define DYNRES_STEP (1.0f / 32)   // granularity of the scale
+
+struct DynRes {
+	unsigned width, height;
+	float budget;
+	float min_scale;
+	float scale;
+	float gpu_time;                   // smoothed, in seconds
+	struct RenderTarget *target;
+
+	// ring of timer queries, the pending ones end at `next`
+	GLuint queries[DYNRES_QUERIES];
+	unsigned next;
+	unsigned pending;
+	unsigned stale;                   // pending ones issued at another scale
+};
+
+struct DynRes*
+dynres_new(unsigned width, unsigned height, float budget, float min_scale)
+{
+	assert(budget > 0);
+	assert(min_scale > 0 && min_scale <= 1);
+
+	struct DynRes *dynres = make(struct DynRes);
+	if (!dynres) {
+		return NULL;
+	}
+	dynres->width = width;
+	dynres->height = height;
+	dynres->budget = budget;
+	dynres->min_scale = min_scale;
+	dynres->scale = 1.0f;
+	dynres->gpu_time = budget;
+
+	glGenQueries(DYNRES_QUERIES, dynres->queries);
+	if (glGetError() != GL_NO_ERROR) {
+		error(ERR_OPENGL);
+		dynres_destroy(dynres);
+		return NULL;
+	}
+
+	if (!(dynres->target = render_target_new(width, height))) {
+		dynres_destroy(dynres);
+		return NULL;
+	}
+
+	return dynres;
+}
+
+void
+dynres_destroy(struct DynRes *dynres)
+{
+	if (dynres) {
+		render_target_destroy(dynres->target);
+		glDeleteQueries(DYNRES_QUERIES, dynres->queries);
+		destroy(dynres);
+	}
+}
+
+/**
+ * Read the results of finished queries into the smoothed GPU time.
+ *
+ * Returns the number of fresh results read.
+ */
+static unsigned
+read_queries(struct DynRes *dynres)
+{
+	unsigned count = 0;
+	while (dynres->pending > 0) {
+		unsigned i = (
+			dynres->next + DYNRES_QUERIES - dynres->pending
+		) % DYNRES_QUERIES;
+		GLint available = 0;
+		glGetQueryObjectiv(
+			dynres->queries[i],
+			GL_QUERY_RESULT_AVAILABLE,
+			&available
+		);
+		if (!available) {
+			break;
+		}
+		GLuint64 elapsed;
+		glGetQueryObjectui64v(
+			dynres->queries[i],
+			GL_QUERY_RESULT,
+			&elapsed
+		);
+		dynres->pending--;
+
+		// results rendered at a previous scale say nothing of this one
+		if (dynres->stale > 0) {
+			dynres->stale--;
+			continue;
+		}
+		dynres->gpu_time += (
+			elapsed / 1e9f - dynres->gpu_time
+		) * DYNRES_SMOOTHING;
+		count++;
+	}
+	return count;
+}
+
+/**
+ * Pick the scale for the GPU time to fit the budget.
+ */
+static void
+update_scale(struct DynRes *dynres)
+{
+	if (read_queries(dynres) == 0) {
+		return;
+	}
+
+	// leave the scale alone while the time is within budget, but not so
+	// far below it the GPU idles
+	float ratio = dynres->budget / dynres->gpu_time;
+	if (ratio >= 1.0f && ratio <= 1.0f / DYNRES_HEADROOM) {
+		return;
+	}
+
+	// the time is mostly spent filling pixels, whose number is square of
+	// the scale; aim at the middle of the range, stepping halfway there,
+	// for the estimate is rough
+	float target = ratio * (1.0f + DYNRES_HEADROOM) / 2;
+	float ideal = dynres->scale * sqrtf(target);
+	float scale = dynres->scale + (ideal - dynres->scale) / 2;
+	scale = roundf(scale / DYNRES_STEP) * DYNRES_STEP;
+	if (scale < dynres->min_scale) {
+		scale = dynres->min_scale;
+	} else if (scale > 1.0f) {
+		scale = 1.0f;
+	}
+	if (scale == dynres->scale) {
+		return;
+	}
+
+	// estimate the time at the new scale, until it's measured
+	dynres->gpu_time *= (scale * scale) / (dynres->scale * dynres->scale);
+	dynres->scale = scale;
+	dynres->stale = dynres->pending;
+}
+
+int
+dynres_render(struct DynRes *dynres, struct RenderList *list)
+{
+	update_scale(dynres);
+	render_target_set_scale(dynres->target, dynres->scale);
+
+	// the query of the oldest frame is reused if it's still not done,
+	// dropping its result
+	if (dynres->pending == DYNRES_QUERIES) {
+		dynres->pending--;
+		if (dynres->stale > 0) {
+			dynres->stale--;
+		}
+	}
+	// at full resolution, render right on the screen, not to pay for the
+	// copy; the offscreen target is blitted, for it's drawn before anything
+	// else
+	int native = dynres->scale == 1.0f;
+	glBeginQuery(GL_TIME_ELAPSED, dynres->queries[dynres->next]);
+	int ok = (
+		native ?
+		render_list_exec(list) :
+		render_list_exec_target(list, dynres->target)
+	);
+	glEndQuery(GL_TIME_ELAPSED);
+	dynres->next = (dynres->next + 1) % DYNRES_QUERIES;
+	dynres->pending++;
+
+	return ok && (native || render_target_blit(dynres->target));
+}
+
+float
+dynres_get_scale(const struct DynRes *dynres)
+{
+	return dynres->scale;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+struct RenderList;
+
+/**
+ * Dynamic resolution renderer.
+ *
+ * Executes render lists into an offscreen target, whose resolution is scaled
+ * down when the GPU takes longer than the budget to render them and back up
+ * when it has time to spare, then stretches the target over the screen. At
+ * full resolution, lists are executed right on the screen.
+ * GPU time is measured with timer queries, read a few frames later not to
+ * stall the pipeline.
+ */
+struct DynRes;
+
+/**
+ * Create a dynamic resolution renderer of given size in pixels.
+ *
+ * The budget is the GPU time in seconds to hold, and the minimum scale is
+ * the fraction of the size the resolution is never scaled below.
+ */
+struct DynRes*
+dynres_new(unsigned width, unsigned height, float budget, float min_scale);
+
+void
+dynres_destroy(struct DynRes *dynres);
+
+/**
+ * Render a list at the current resolution and copy it on the screen, over
+ * its previous contents; must be the first thing rendered in a frame.
+ */
+int
+dynres_render(struct DynRes *dynres, struct RenderList *list);
+
+/**
+ * Get the current resolution scale.
+ */
+float
+dynres_get_scale(const struct DynRes *dynres);
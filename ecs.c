@@ -0,0 +1,596 @@
+#include "ecs.h"
+#include "error.h"
+#include "memory.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ECS_INDEX_BITS 20
+#define ECS_INDEX_MASK ((1u << ECS_INDEX_BITS) - 1)
+#define ECS_GENERATION_MASK ((1u << (32 - ECS_INDEX_BITS)) - 1)
+#define ECS_COLUMN_ALIGN 16
+#define ECS_BASE_SIZE 64
+
+struct Chunk {
+	Entity entities[ECS_CHUNK_SIZE];
+	unsigned char *columns[ECS_MAX_COMPONENTS];
+	// column data follows the header
+};
+
+struct Archetype {
+	uint32_t mask;
+	size_t count;
+	struct Chunk **chunks;
+	size_t chunk_count;
+};
+
+struct Slot {
+	uint32_t generation;
+	int alive;
+	struct Archetype *archetype;
+	size_t row;
+	size_t next_free;  // index of the next free slot + 1, 0 if none
+};
+
+struct Ecs {
+	struct EcsComponent components[ECS_MAX_COMPONENTS];
+	unsigned component_count;
+
+	struct Archetype **archetypes;
+	size_t archetype_count;
+
+	struct Slot *slots;
+	size_t slot_count;
+	size_t slot_capacity;
+	size_t free_slot;  // index of the first free slot + 1, 0 if none
+
+	Entity *pending;
+	size_t pending_count;
+	size_t pending_capacity;
+};
+
+static inline Entity
+make_entity(size_t index, uint32_t generation)
+{
+	return (generation & ECS_GENERATION_MASK) << ECS_INDEX_BITS | (index + 1);
+}
+
+static inline struct Slot*
+get_slot(const struct Ecs *ecs, Entity e)
+{
+	size_t index = (e & ECS_INDEX_MASK);
+	if (index == 0 || index > ecs->slot_count) {
+		return NULL;
+	}
+	struct Slot *slot = &ecs->slots[index - 1];
+	if (!slot->alive ||
+	    (slot->generation & ECS_GENERATION_MASK) != e >> ECS_INDEX_BITS) {
+		return NULL;
+	}
+	return slot;
+}
+
+static inline void*
+get_component(
+	const struct Ecs *ecs,
+	struct Archetype *arch,
+	size_t row,
+	unsigned c
+) {
+	struct Chunk *chunk = arch->chunks[row / ECS_CHUNK_SIZE];
+	return chunk->columns[c] + ecs->components[c].size * (row % ECS_CHUNK_SIZE);
+}
+
+static inline size_t
+align_size(size_t size)
+{
+	return (size + ECS_COLUMN_ALIGN - 1) & ~(size_t)(ECS_COLUMN_ALIGN - 1);
+}
+
+static struct Chunk*
+chunk_new(struct Ecs *ecs, uint32_t mask)
+{
+	// compute the size of the chunk with all its columns
+	size_t size = align_size(sizeof(struct Chunk));
+	for (unsigned c = 0; c < ecs->component_count; c++) {
+		if (mask & ECS_BIT(c)) {
+			size += align_size(ecs->components[c].size * ECS_CHUNK_SIZE);
+		}
+	}
+
+	// NOTE: malloc() alignment is enough for ECS_COLUMN_ALIGN on all
+	// supported platforms
+	unsigned char *data = malloc(size);
+	if (!data) {
+		error(ERR_NO_MEM);
+		return NULL;
+	}
+	memset(data, 0, sizeof(struct Chunk));
+
+	// lay out the columns one after another
+	struct Chunk *chunk = (struct Chunk*)data;
+	size_t offset = align_size(sizeof(struct Chunk));
+	for (unsigned c = 0; c < ecs->component_count; c++) {
+		if (mask & ECS_BIT(c) && ecs->components[c].size > 0) {
+			chunk->columns[c] = data + offset;
+			offset += align_size(ecs->components[c].size * ECS_CHUNK_SIZE);
+		}
+	}
+	return chunk;
+}
+
+static struct Archetype*
+get_archetype(struct Ecs *ecs, uint32_t mask)
+{
+	for (size_t i = 0; i < ecs->archetype_count; i++) {
+		if (ecs->archetypes[i]->mask == mask) {
+			return ecs->archetypes[i];
+		}
+	}
+
+	// create a new archetype
+	struct Archetype **archetypes = realloc(
+		ecs->archetypes,
+		sizeof(struct Archetype*) * (ecs->archetype_count + 1)
+	);
+	if (!archetypes) {
+		error(ERR_NO_MEM);
+		return NULL;
+	}
+	ecs->archetypes = archetypes;
+
+	struct Archetype *arch = make(struct Archetype);
+	if (!arch) {
+		return NULL;
+	}
+	arch->mask = mask;
+	ecs->archetypes[ecs->archetype_count++] = arch;
+	return arch;
+}
+
+static int
+reserve_row(struct Ecs *ecs, struct Archetype *arch)
+{
+	if (arch->count < arch->chunk_count * ECS_CHUNK_SIZE) {
+		return 1;
+	}
+
+	struct Chunk **chunks = realloc(
+		arch->chunks,
+		sizeof(struct Chunk*) * (arch->chunk_count + 1)
+	);
+	if (!chunks) {
+		error(ERR_NO_MEM);
+		return 0;
+	}
+	arch->chunks = chunks;
+
+	if (!(chunks[arch->chunk_count] = chunk_new(ecs, arch->mask))) {
+		return 0;
+	}
+	arch->chunk_count++;
+	return 1;
+}
+
+static struct Slot*
+alloc_slot(struct Ecs *ecs)
+{
+	if (ecs->free_slot) {
+		struct Slot *slot = &ecs->slots[ecs->free_slot - 1];
+		ecs->free_slot = slot->next_free;
+		return slot;
+	}
+
+	if (ecs->slot_count == ECS_INDEX_MASK) {
+		return NULL;  // out of entity handles
+	}
+	if (ecs->slot_count == ecs->slot_capacity) {
+		size_t capacity = ecs->slot_capacity + ECS_BASE_SIZE;
+		struct Slot *slots = realloc(
+			ecs->slots,
+			sizeof(struct Slot) * capacity
+		);
+		if (!slots) {
+			error(ERR_NO_MEM);
+			return NULL;
+		}
+		ecs->slots = slots;
+		ecs->slot_capacity = capacity;
+	}
+
+	struct Slot *slot = &ecs->slots[ecs->slot_count++];
+	memset(slot, 0, sizeof(struct Slot));
+	return slot;
+}
+
+static void
+destroy_row(struct Ecs *ecs, struct Archetype *arch, size_t row)
+{
+	// destruct components
+	for (unsigned c = 0; c < ecs->component_count; c++) {
+		const struct EcsComponent *comp = &ecs->components[c];
+		if (arch->mask & ECS_BIT(c) && comp->destroy) {
+			comp->destroy(
+				comp->size ? get_component(ecs, arch, row, c) : NULL,
+				comp->userdata
+			);
+		}
+	}
+
+	// move the last row in place of the removed one to keep the storage
+	// tightly packed
+	size_t last = arch->count - 1;
+	if (row != last) {
+		for (unsigned c = 0; c < ecs->component_count; c++) {
+			size_t size = ecs->components[c].size;
+			if (arch->mask & ECS_BIT(c) && size > 0) {
+				memcpy(
+					get_component(ecs, arch, row, c),
+					get_component(ecs, arch, last, c),
+					size
+				);
+			}
+		}
+
+		struct Chunk *dst = arch->chunks[row / ECS_CHUNK_SIZE];
+		struct Chunk *src = arch->chunks[last / ECS_CHUNK_SIZE];
+		Entity moved = src->entities[last % ECS_CHUNK_SIZE];
+		dst->entities[row % ECS_CHUNK_SIZE] = moved;
+		ecs->slots[(moved & ECS_INDEX_MASK) - 1].row = row;
+	}
+	arch->count--;
+}
+
+struct Ecs*
+ecs_new(const struct EcsComponent *components, unsigned count)
+{
+	assert(components != NULL);
+	assert(count <= ECS_MAX_COMPONENTS);
+
+	struct Ecs *ecs = make(struct Ecs);
+	if (!ecs) {
+		return NULL;
+	}
+	memcpy(ecs->components, components, sizeof(struct EcsComponent) * count);
+	ecs->component_count = count;
+	return ecs;
+}
+
+void
+ecs_destroy(struct Ecs *ecs)
+{
+	if (ecs) {
+		for (size_t i = 0; i < ecs->archetype_count; i++) {
+			struct Archetype *arch = ecs->archetypes[i];
+			while (arch->count > 0) {
+				destroy_row(ecs, arch, arch->count - 1);
+			}
+			for (size_t c = 0; c < arch->chunk_count; c++) {
+				free(arch->chunks[c]);
+			}
+			free(arch->chunks);
+			destroy(arch);
+		}
+		free(ecs->archetypes);
+		free(ecs->slots);
+		free(ecs->pending);
+		destroy(ecs);
+	}
+}
+
+Entity
+ecs_create(struct Ecs *ecs, uint32_t mask)
+{
+	assert(ecs != NULL);
+	assert(mask < ECS_BIT(ecs->component_count) || ecs->component_count == 32);
+
+	struct Archetype *arch = get_archetype(ecs, mask);
+	if (!arch || !reserve_row(ecs, arch)) {
+		return 0;
+	}
+
+	struct Slot *slot = alloc_slot(ecs);
+	if (!slot) {
+		return 0;
+	}
+	slot->alive = 1;
+	slot->archetype = arch;
+	slot->row = arch->count++;
+	Entity e = make_entity(slot - ecs->slots, slot->generation);
+
+	// initialize the row
+	struct Chunk *chunk = arch->chunks[slot->row / ECS_CHUNK_SIZE];
+	chunk->entities[slot->row % ECS_CHUNK_SIZE] = e;
+	for (unsigned c = 0; c < ecs->component_count; c++) {
+		size_t size = ecs->components[c].size;
+		if (mask & ECS_BIT(c) && size > 0) {
+			memset(get_component(ecs, arch, slot->row, c), 0, size);
+		}
+	}
+
+	return e;
+}
+
+void
+ecs_kill(struct Ecs *ecs, Entity e)
+{
+	assert(ecs != NULL);
+
+	if (!get_slot(ecs, e)) {
+		return;
+	}
+
+	if (ecs->pending_count == ecs->pending_capacity) {
+		size_t capacity = ecs->pending_capacity + ECS_BASE_SIZE;
+		Entity *pending = realloc(ecs->pending, sizeof(Entity) * capacity);
+		if (!pending) {
+			error(ERR_NO_MEM);
+			return;
+		}
+		ecs->pending = pending;
+		ecs->pending_capacity = capacity;
+	}
+	ecs->pending[ecs->pending_count++] = e;
+}
+
+void
+ecs_flush(struct Ecs *ecs)
+{
+	assert(ecs != NULL);
+
+	for (size_t i = 0; i < ecs->pending_count; i++) {
+		// an entity may be killed more than once, the stale handle
+		// makes the following attempts no-ops
+		struct Slot *slot = get_slot(ecs, ecs->pending[i]);
+		if (!slot) {
+			continue;
+		}
+		destroy_row(ecs, slot->archetype, slot->row);
+
+		slot->alive = 0;
+		slot->generation++;
+		slot->next_free = ecs->free_slot;
+		ecs->free_slot = slot - ecs->slots + 1;
+	}
+	ecs->pending_count = 0;
+}
+
+int
+ecs_alive(const struct Ecs *ecs, Entity e)
+{
+	assert(ecs != NULL);
+	return get_slot(ecs, e) != NULL;
+}
+
+void*
+ecs_get(struct Ecs *ecs, Entity e, unsigned component)
+{
+	assert(ecs != NULL);
+	assert(component < ecs->component_count);
+
+	struct Slot *slot = get_slot(ecs, e);
+	if (!slot ||
+	    !(slot->archetype->mask & ECS_BIT(component)) ||
+	    ecs->components[component].size == 0) {
+		return NULL;
+	}
+	return get_component(ecs, slot->archetype, slot->row, component);
+}
+
+int
+ecs_foreach(struct Ecs *ecs, uint32_t mask, EcsSystem system, void *userdata)
+{
+	assert(ecs != NULL);
+	assert(system != NULL);
+
+	for (size_t i = 0; i < ecs->archetype_count; i++) {
+		struct Archetype *arch = ecs->archetypes[i];
+		if ((arch->mask & mask) != mask) {
+			continue;
+		}
+
+		for (size_t row = 0; row < arch->count; row += ECS_CHUNK_SIZE) {
+			struct Chunk *chunk = arch->chunks[row / ECS_CHUNK_SIZE];
+			struct EcsView view;
+			view.count = arch->count - row;
+			if (view.count > ECS_CHUNK_SIZE) {
+				view.count = ECS_CHUNK_SIZE;
+			}
+			view.entities = chunk->entities;
+			memcpy(view.columns, chunk->columns, sizeof(view.columns));
+
+			if (!system(&view, userdata)) {
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+size_t
+ecs_count(const struct Ecs *ecs, uint32_t mask)
+{
+	assert(ecs != NULL);
+
+	size_t count = 0;
+	for (size_t i = 0; i < ecs->archetype_count; i++) {
+		if ((ecs->archetypes[i]->mask & mask) == mask) {
+			count += ecs->archetypes[i]->count;
+		}
+	}
+	return count;
+}
+
+/**
+ * Snapshot layout: storage counters, slots, pending kills, then the rows of
+ * each archetype, chunk by chunk: entity handles followed by each column.
+ * Archetypes and chunks are never freed, thus, those a snapshot refers to
+ * still exist when it is restored.
+ */
+struct SnapshotHeader {
+	size_t archetype_count;
+	size_t slot_count;
+	size_t free_slot;
+	size_t pending_count;
+};
+
+static size_t
+snapshot_size(const struct Ecs *ecs)
+{
+	size_t size = (
+		sizeof(struct SnapshotHeader) +
+		sizeof(struct Slot) * ecs->slot_count +
+		sizeof(Entity) * ecs->pending_count
+	);
+	for (size_t i = 0; i < ecs->archetype_count; i++) {
+		const struct Archetype *arch = ecs->archetypes[i];
+		size_t row_size = sizeof(Entity);
+		for (unsigned c = 0; c < ecs->component_count; c++) {
+			if (arch->mask & ECS_BIT(c)) {
+				row_size += ecs->components[c].size;
+			}
+		}
+		size += sizeof(size_t) + row_size * arch->count;
+	}
+	return size;
+}
+
+/**
+ * Copy rows of an archetype to or from a snapshot buffer.
+ */
+static size_t
+copy_rows(
+	const struct Ecs *ecs,
+	const struct Archetype *arch,
+	unsigned char *data,
+	int save
+) {
+	size_t offset = 0;
+	for (size_t row = 0; row < arch->count; row += ECS_CHUNK_SIZE) {
+		struct Chunk *chunk = arch->chunks[row / ECS_CHUNK_SIZE];
+		size_t count = arch->count - row;
+		if (count > ECS_CHUNK_SIZE) {
+			count = ECS_CHUNK_SIZE;
+		}
+
+		size_t size = sizeof(Entity) * count;
+		if (save) {
+			memcpy(data + offset, chunk->entities, size);
+		} else {
+			memcpy(chunk->entities, data + offset, size);
+		}
+		offset += size;
+
+		for (unsigned c = 0; c < ecs->component_count; c++) {
+			size = ecs->components[c].size * count;
+			if (!(arch->mask & ECS_BIT(c)) || size == 0) {
+				continue;
+			}
+			if (save) {
+				memcpy(data + offset, chunk->columns[c], size);
+			} else {
+				memcpy(chunk->columns[c], data + offset, size);
+			}
+			offset += size;
+		}
+	}
+	return offset;
+}
+
+int
+ecs_save(const struct Ecs *ecs, struct EcsSnapshot *snap)
+{
+	assert(ecs != NULL);
+	assert(snap != NULL);
+
+	size_t size = snapshot_size(ecs);
+	if (size > snap->capacity) {
+		unsigned char *data = realloc(snap->data, size);
+		if (!data) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		snap->data = data;
+		snap->capacity = size;
+	}
+	snap->size = size;
+
+	unsigned char *data = snap->data;
+	struct SnapshotHeader header = {
+		ecs->archetype_count,
+		ecs->slot_count,
+		ecs->free_slot,
+		ecs->pending_count
+	};
+	memcpy(data, &header, sizeof(header));
+	data += sizeof(header);
+
+	if (ecs->slot_count) {
+		memcpy(data, ecs->slots, sizeof(struct Slot) * ecs->slot_count);
+		data += sizeof(struct Slot) * ecs->slot_count;
+	}
+	if (ecs->pending_count) {
+		memcpy(data, ecs->pending, sizeof(Entity) * ecs->pending_count);
+		data += sizeof(Entity) * ecs->pending_count;
+	}
+
+	for (size_t i = 0; i < ecs->archetype_count; i++) {
+		const struct Archetype *arch = ecs->archetypes[i];
+		memcpy(data, &arch->count, sizeof(size_t));
+		data += sizeof(size_t);
+		data += copy_rows(ecs, arch, data, 1);
+	}
+	assert(data == snap->data + snap->size);
+	return 1;
+}
+
+void
+ecs_restore(struct Ecs *ecs, const struct EcsSnapshot *snap)
+{
+	assert(ecs != NULL);
+	assert(snap != NULL && snap->size > 0);
+
+	unsigned char *data = snap->data;
+	struct SnapshotHeader header;
+	memcpy(&header, data, sizeof(header));
+	data += sizeof(header);
+	assert(header.archetype_count <= ecs->archetype_count);
+	assert(header.slot_count <= ecs->slot_capacity);
+	assert(header.pending_count <= ecs->pending_capacity);
+
+	ecs->slot_count = header.slot_count;
+	ecs->free_slot = header.free_slot;
+	ecs->pending_count = header.pending_count;
+	if (header.slot_count) {
+		memcpy(ecs->slots, data, sizeof(struct Slot) * header.slot_count);
+		data += sizeof(struct Slot) * header.slot_count;
+	}
+	if (header.pending_count) {
+		memcpy(ecs->pending, data, sizeof(Entity) * header.pending_count);
+		data += sizeof(Entity) * header.pending_count;
+	}
+
+	for (size_t i = 0; i < ecs->archetype_count; i++) {
+		struct Archetype *arch = ecs->archetypes[i];
+		if (i >= header.archetype_count) {
+			// created after the snapshot was taken
+			arch->count = 0;
+			continue;
+		}
+		memcpy(&arch->count, data, sizeof(size_t));
+		data += sizeof(size_t);
+		assert(arch->count <= arch->chunk_count * ECS_CHUNK_SIZE);
+		data += copy_rows(ecs, arch, data, 0);
+	}
+	assert(data == snap->data + snap->size);
+}
+
+void
+ecs_snapshot_release(struct EcsSnapshot *snap)
+{
+	if (snap) {
+		free(snap->data);
+		snap->data = NULL;
+		snap->size = snap->capacity = 0;
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ECS_MAX_COMPONENTS 32
+#define ECS_CHUNK_SIZE 64  // entities per chunk
+
+/**
+ * Component bit in archetype masks.
+ */
+#define ECS_BIT(c) (1u << (c))
+
+/**
+ * Entity handle.
+ *
+ * Handles embed a generation counter, thus, a handle of a destroyed entity
+ * never refers to an entity created later. Zero is never a valid handle.
+ */
+typedef uint32_t Entity;
+
+typedef void (*EcsDestructor)(void *component, void *userdata);
+
+/**
+ * Component type description.
+ *
+ * Size may be zero for tag components, which have no data and are only used
+ * to select entities. The optional destructor is called for each component
+ * instance when its entity is destroyed.
+ */
+struct EcsComponent {
+	size_t size;
+	EcsDestructor destroy;
+	void *userdata;
+};
+
+/**
+ * View of a single chunk of entities.
+ *
+ * Columns are indexed by component identifier and hold `count` tightly
+ * packed component instances each; columns of components missing in the
+ * chunk's archetype and of tag components are NULL.
+ */
+struct EcsView {
+	size_t count;
+	const Entity *entities;
+	void *columns[ECS_MAX_COMPONENTS];
+};
+
+/**
+ * System function, called for each chunk matching system's mask.
+ */
+typedef int (*EcsSystem)(struct EcsView *view, void *userdata);
+
+/**
+ * Entity-component storage.
+ *
+ * Entities with the same set of components (archetype) are stored in
+ * fixed-size chunks, with each component in a separate contiguous column,
+ * so that systems iterate over them linearly.
+ */
+struct Ecs;
+
+/**
+ * Saved storage state.
+ *
+ * Must be zero-initialized before first use. The buffer is reused by
+ * subsequent saves and grows only when the storage does, thus, saving
+ * repeatedly into the same snapshot doesn't allocate.
+ */
+struct EcsSnapshot {
+	unsigned char *data;
+	size_t size;
+	size_t capacity;
+};
+
+/**
+ * Create an entity-component storage for given component types.
+ *
+ * Component identifiers are indices into `components` array.
+ */
+struct Ecs*
+ecs_new(const struct EcsComponent *components, unsigned count);
+
+void
+ecs_destroy(struct Ecs *ecs);
+
+/**
+ * Create an entity having components given by `mask`.
+ *
+ * Components are zero-initialized. Returns 0 on failure.
+ */
+Entity
+ecs_create(struct Ecs *ecs, uint32_t mask);
+
+/**
+ * Mark an entity for destruction.
+ *
+ * The entity stays alive until `ecs_flush()` is called, so it's safe to
+ * kill entities from within systems.
+ */
+void
+ecs_kill(struct Ecs *ecs, Entity e);
+
+/**
+ * Destroy all entities marked for destruction.
+ */
+void
+ecs_flush(struct Ecs *ecs);
+
+int
+ecs_alive(const struct Ecs *ecs, Entity e);
+
+/**
+ * Get entity's component data.
+ *
+ * Returns NULL if the entity is not alive or has no such component. The
+ * pointer is valid until the next `ecs_create()` or `ecs_flush()` call.
+ */
+void*
+ecs_get(struct Ecs *ecs, Entity e, unsigned component);
+
+/**
+ * Run a system over all entities having at least components in `mask`.
+ *
+ * Stops and returns 0 as soon as the system does.
+ */
+int
+ecs_foreach(struct Ecs *ecs, uint32_t mask, EcsSystem system, void *userdata);
+
+/**
+ * Count entities having at least components in `mask`.
+ */
+size_t
+ecs_count(const struct Ecs *ecs, uint32_t mask);
+
+/**
+ * Save the state of all entities and their components.
+ */
+int
+ecs_save(const struct Ecs *ecs, struct EcsSnapshot *snap);
+
+/**
+ * Restore the state saved from the same storage.
+ *
+ * Entities are restored along with their handles, component destructors of
+ * the entities being replaced are not called.
+ */
+void
+ecs_restore(struct Ecs *ecs, const struct EcsSnapshot *snap);
+
+void
+ecs_snapshot_release(struct EcsSnapshot *snap);
@@ -1,30 +1,30 @@
 #include "game.h"
-#include "memory.h"
 
-struct Enemy*
-enemy_new(float x, float y)
+Entity
+enemy_spawn(struct World *world, float x, float y)
 {
-	struct Enemy *enemy = make(struct Enemy);
+	struct Body body = {
+		.x = scalar_from_float(x),
+		.y = scalar_from_float(y),
+		.radius = scalar_from_float(48),
+		.type = BODY_TYPE_ENEMY,
+		.collision_mask = BODY_TYPE_PLAYER | BODY_TYPE_PROJECTILE,
+	};
+	Entity enemy = world_spawn(
+		world,
+		ECS_BIT(COMPONENT_TRANSFORM) |
+		ECS_BIT(COMPONENT_BODY) |
+		ECS_BIT(COMPONENT_TTL) |
+		ECS_BIT(COMPONENT_HEALTH) |
+		ECS_BIT(COMPONENT_SPRITE) |
+		ECS_BIT(COMPONENT_SCROLL),
+		&body
+	);
 	if (!enemy) {
-		return NULL;
+		return 0;
 	}
-	enemy->x = x;
-	enemy->y = y;
-	enemy->hitpoints = ENEMY_INITIAL_HITPOINTS;
-	enemy->ttl = ENTITY_TTL;
-	enemy->body.x = x;
-	enemy->body.y = y;
-	enemy->body.radius = 48;
-	enemy->body.type = BODY_TYPE_ENEMY;
-	enemy->body.collision_mask = BODY_TYPE_PLAYER | BODY_TYPE_PROJECTILE;
-	enemy->body.userdata = enemy;
+	*(float*)ecs_get(world->ecs, enemy, COMPONENT_TTL) = ENTITY_TTL;
+	*(float*)ecs_get(world->ecs, enemy, COMPONENT_HEALTH) = ENEMY_INITIAL_HITPOINTS;
+	*(int*)ecs_get(world->ecs, enemy, COMPONENT_SPRITE) = SPRITE_ENEMY;
 	return enemy;
 }
-
-void
-enemy_destroy(struct Enemy *enemy)
-{
-	if (enemy) {
-		destroy(enemy);
-	}
-}
\ No newline at end of file
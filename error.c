@@ -31,6 +31,10 @@ static const char *err_msgs[] = {
 	"script file load failure",
 	// ERR_SCRIPT_CALL
 	"script function call failure",
+	// ERR_NET
+	"network error",
+	// ERR_THREAD
+	"thread error",
 };
 
 void
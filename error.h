@@ -12,6 +12,8 @@ enum {
 	ERR_SCRIPT_INIT,
 	ERR_SCRIPT_LOAD,
 	ERR_SCRIPT_CALL,
+	ERR_NET,
+	ERR_THREAD,
 	ERR_MAX
 };
 
@@ -3,6 +3,7 @@
 #include FT_GLYPH_H
 
 #include "font.h"
+#include "texture.h"
 #include <assert.h>
 #include <stdlib.h>
 
@@ -11,7 +12,6 @@ static FT_Library ft;
 
 struct Font {
 	struct Character charmap[128];
-	GLuint tex_glyph;
 	GLuint tex_atlas;
 	unsigned tex_atlas_offset;
 };
@@ -34,49 +34,6 @@ init_freetype(void)
 	return 1;
 }
 
-static int
-init_glyph_texture(struct Font *font, FT_Glyph *glyphs)
-{
-	glGenTextures(1, &font->tex_glyph);
-	if (!font->tex_glyph) {
-		return 0;
-	}
-
-	GLubyte data[128][2];
-	for (unsigned char c = 0; c < 128; c++) {
-		struct Character *ch = &font->charmap[c];
-		data[c][0] = ch->size[0];
-		data[c][1] = ch->size[1];
-	}
-
-	glBindTexture(GL_TEXTURE_1D, font->tex_glyph);
-	// NOTE: `GL_NEAREST` is *mandatory* with integer textures.
-	// http://stackoverflow.com/a/39578132/324790
-	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_BASE_LEVEL, 0);
-	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAX_LEVEL, 0);
-	glTexImage1D(
-		GL_TEXTURE_1D,
-		0,
-		GL_RG16UI,
-		128,
-		0,
-		GL_RG_INTEGER,
-		GL_UNSIGNED_BYTE,
-		data
-	);
-	glBindTexture(GL_TEXTURE_1D, 0);
-
-	if (glGetError() != GL_NO_ERROR) {
-		glDeleteTextures(1, &font->tex_glyph);
-		font->tex_glyph = 0;
-		return 0;
-	}
-
-	return 1;
-}
-
 static int
 init_atlas_texture(struct Font *font, FT_Glyph *glyphs)
 {
@@ -104,11 +61,11 @@ init_atlas_texture(struct Font *font, FT_Glyph *glyphs)
 	for (unsigned c = 0; c < 128; c++) {
 		FT_Bitmap *bmp = &((FT_BitmapGlyph)glyphs[c])->bitmap;
 		for (unsigned row = 0; row < bmp->rows; row++) {
-			// NOTE: both FreeType and OpenGL assume the origin in
-			// lower-left corner, thus, when copying the rows we
-			// start from lower one and go up
+			// NOTE: rows are copied top one first, as the other
+			// textures' are, the glyphs are thus aligned to the top
+			// of the atlas
 			memcpy(
-				data + (bmp->rows - row - 1) * atlas_w + c * atlas_s,
+				data + row * atlas_w + c * atlas_s,
 				bmp->buffer + row * bmp->pitch,
 				abs(bmp->pitch)  // NOTE: pitch can be negative
 			);
@@ -121,32 +78,31 @@ init_atlas_texture(struct Font *font, FT_Glyph *glyphs)
 		return 0;
 	}
 
-	// setup the texture as single-component with no mipmaps
-	glBindTexture(GL_TEXTURE_RECTANGLE, font->tex_atlas);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_BASE_LEVEL, 0);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAX_LEVEL, 0);
+	// setup the texture as single-component, filtered like the others; it
+	// is a single layer array, sampled the same way as those
+	glBindTexture(GL_TEXTURE_2D_ARRAY, font->tex_atlas);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glTexImage2D(
-		GL_TEXTURE_RECTANGLE,
+	glTexImage3D(
+		GL_TEXTURE_2D_ARRAY,
 		0,
 		GL_R8,
 		atlas_w,
 		atlas_h,
+		1,
 		0,
 		GL_RED,
 		GL_UNSIGNED_BYTE,
 		data
 	);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-	glBindTexture(GL_TEXTURE_RECTANGLE, 0);
+	texture_apply_filter(GL_TEXTURE_2D_ARRAY);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
 	if (glGetError() != GL_NO_ERROR) {
-		glDeleteTextures(1, &font->tex_glyph);
-		font->tex_glyph = 0;
+		glDeleteTextures(1, &font->tex_atlas);
+		font->tex_atlas = 0;
 		return 0;
 	}
 
@@ -176,10 +132,7 @@ init_font(struct Font *font, FT_Face face)
 		ch->advance = face->glyph->advance.x;
 	}
 
-	int ok = (
-		init_glyph_texture(font, glyphs) &&
-		init_atlas_texture(font, glyphs)
-	);
+	int ok = init_atlas_texture(font, glyphs);
 
 	for (unsigned char c = 0; c < 128; c++) {
 		FT_Done_Glyph(glyphs[c]);
@@ -220,13 +173,6 @@ font_get_char(struct Font *font, char c)
 	return &font->charmap[(int)c];
 }
 
-GLuint
-font_get_glyph_texture(struct Font *font)
-{
-	assert(font != NULL);
-	return font->tex_glyph;
-}
-
 GLuint
 font_get_atlas_texture(struct Font *font)
 {
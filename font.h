@@ -16,9 +16,6 @@ font_from_file(const char *filename, unsigned size);
 const struct Character*
 font_get_char(struct Font *font, char c);
 
-GLuint
-font_get_glyph_texture(struct Font *font);
-
 GLuint
 font_get_atlas_texture(struct Font *font);
 
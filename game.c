@@ -2,19 +2,22 @@
 #include "game.h"
 #include "matlib.h"
 #include "memory.h"
-#include "utils.h"
+#include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 struct UpdateContext {
 	struct World *world;
 	float dt;
 };
 
-struct Entity {
-	float x, y;
-	struct Body body;
-};
+static inline Entity
+body_entity(const struct Body *body)
+{
+	return (Entity)(uintptr_t)body->userdata;
+}
 
 static int
 add_event(struct World *world, const struct Event *evt)
@@ -47,8 +50,8 @@ handle_player_collision(struct Body *a, struct Body *b, void *userdata)
 		struct Event evt = {
 			.type = EVENT_PLAYER_COLLISION,
 			.collision = {
-				.first = a,
-				.second = b
+				.other = body_entity(b),
+				.other_type = b->type
 			}
 		};
 		struct World *world = userdata;
@@ -64,8 +67,8 @@ handle_enemy_hit(struct Body *a, struct Body *b, void *userdata)
 		struct Event evt = {
 			.type = EVENT_ENEMY_HIT,
 			.hit = {
-				.target = a->userdata,
-				.projectile = b->userdata
+				.target = body_entity(a),
+				.projectile = body_entity(b)
 			}
 
 		};
@@ -75,6 +78,15 @@ handle_enemy_hit(struct Body *a, struct Body *b, void *userdata)
 	return 1;
 }
 
+static void
+destroy_body(void *body_ptr, void *sim)
+{
+	BodyID id = *(BodyID*)body_ptr;
+	if (id) {
+		sim_remove_body(sim, id);
+	}
+}
+
 struct World*
 world_new(void)
 {
@@ -83,17 +95,6 @@ world_new(void)
 		return NULL;
 	}
 
-	// initialize entity lists
-	w->asteroid_list = list_new();
-	w->projectile_list = list_new();
-	w->enemy_list = list_new();
-	if (!w->asteroid_list ||
-	    !w->projectile_list ||
-	    !w->enemy_list) {
-		error(ERR_NO_MEM);
-		goto error;
-	}
-
 	// initialize simulation system and register collision callbacks
 	w->sim = sim_new();
 	if (!w->sim) {
@@ -123,6 +124,21 @@ world_new(void)
 		}
 	}
 
+	// initialize entity storage
+	const struct EcsComponent components[COMPONENT_COUNT] = {
+		[COMPONENT_TRANSFORM] = { sizeof(struct Transform) },
+		[COMPONENT_BODY] = { sizeof(BodyID), destroy_body, w->sim },
+		[COMPONENT_TTL] = { sizeof(float) },
+		[COMPONENT_HEALTH] = { sizeof(float) },
+		[COMPONENT_SPIN] = { sizeof(float) },
+		[COMPONENT_SPRITE] = { sizeof(int) },
+		[COMPONENT_SCROLL] = { 0 },
+	};
+	w->ecs = ecs_new(components, COMPONENT_COUNT);
+	if (!w->ecs) {
+		goto error;
+	}
+
 	// initialize event queue
 	w->event_queue = malloc(sizeof(struct Event) * EVENT_QUEUE_BASE_SIZE);
 	if (!w->event_queue) {
@@ -135,16 +151,13 @@ world_new(void)
 	w->player.y = SCREEN_HEIGHT / 2 - 50;
 	w->player.speed = PLAYER_INITIAL_SPEED;
 	struct Body player_body = {
-		.x = w->player.x,
-		.y = w->player.y,
-		.radius = 40,
+		.x = scalar_from_float(w->player.x),
+		.y = scalar_from_float(w->player.y),
+		.radius = scalar_from_float(40),
 		.type = BODY_TYPE_PLAYER,
 		.collision_mask = BODY_TYPE_ENEMY | BODY_TYPE_ASTEROID,
-		.userdata = &w->player
 	};
-	w->player.body = player_body;
-
-	if (!sim_add_body(w->sim, &w->player.body)) {
+	if (!(w->player.body = sim_add_body(w->sim, &player_body))) {
 		goto error;
 	}
 
@@ -155,160 +168,443 @@ error:
 	return NULL;
 }
 
-static void
-destroy_entity(void *entity_ptr, void *type)
-{
-	switch ((long)type) {
-	case 0:  // enemy
-		enemy_destroy(entity_ptr);
-		break;
-	case 1:  // projectile
-		projectile_destroy(entity_ptr);
-		break;
-	case 2:  // asteroid
-		asteroid_destroy(entity_ptr);
-		break;
-	}
-}
-
 void
 world_destroy(struct World *w)
 {
 	if (w) {
 		free(w->event_queue);
+		ecs_destroy(w->ecs);
 		sim_destroy(w->sim);
+		destroy(w);
+	}
+}
 
-		// destroy entities
-		struct List *lists[] = {
-			w->enemy_list,
-			w->projectile_list,
-			w->asteroid_list,
-			NULL,
-		};
-		for (long i = 0; lists[i] != NULL; i++) {
-			list_foreach(lists[i], destroy_entity, (void*)i);
-			list_destroy(lists[i]);
+int
+world_save(const struct World *world, struct WorldSnapshot *snap)
+{
+	// events raised by systems are processed by the next update
+	if (world->event_count > snap->event_capacity) {
+		void *events = realloc(
+			snap->events,
+			sizeof(struct Event) * world->event_queue_size
+		);
+		if (!events) {
+			error(ERR_NO_MEM);
+			return 0;
 		}
+		snap->events = events;
+		snap->event_capacity = world->event_queue_size;
+	}
+	if (world->event_count) {
+		memcpy(
+			snap->events,
+			world->event_queue,
+			sizeof(struct Event) * world->event_count
+		);
+	}
+	snap->event_count = world->event_count;
+
+	snap->player = world->player;
+	snap->time = world->time;
+	snap->sim_acc = world->sim_acc;
+	memcpy(snap->input_queue, world->input_queue, sizeof(snap->input_queue));
+	snap->input_head = world->input_head;
+	snap->input_count = world->input_count;
+	return ecs_save(world->ecs, &snap->ecs) && sim_save(world->sim, &snap->sim);
+}
 
-		destroy(w);
+void
+world_restore(struct World *world, const struct WorldSnapshot *snap)
+{
+	world->player = snap->player;
+	world->time = snap->time;
+	world->sim_acc = snap->sim_acc;
+	memcpy(world->input_queue, snap->input_queue, sizeof(world->input_queue));
+	world->input_head = snap->input_head;
+	world->input_count = snap->input_count;
+
+	// the queue never shrinks, thus, saved events always fit
+	assert(snap->event_count <= world->event_queue_size);
+	if (snap->event_count) {
+		memcpy(
+			world->event_queue,
+			snap->events,
+			sizeof(struct Event) * snap->event_count
+		);
 	}
+	world->event_count = snap->event_count;
+
+	ecs_restore(world->ecs, &snap->ecs);
+	sim_restore(world->sim, &snap->sim);
 }
 
-int
-world_add_asteroid(struct World *world, struct Asteroid *ast)
+void
+world_snapshot_release(struct WorldSnapshot *snap)
 {
-	if (!list_add(world->asteroid_list, ast)) {
-		error(ERR_NO_MEM);
-		return 0;
-	} else if (!sim_add_body(world->sim, &ast->body)) {
-		list_remove(world->asteroid_list, ast, ptr_cmp);
-		return 0;
+	if (snap) {
+		free(snap->events);
+		snap->events = NULL;
+		snap->event_count = snap->event_capacity = 0;
+		ecs_snapshot_release(&snap->ecs);
+		sim_snapshot_release(&snap->sim);
 	}
-	return 1;
 }
 
-int
-world_add_enemy(struct World *world, struct Enemy *enemy)
+static int
+log_spawn(struct SpawnLog *log, const struct SpawnRequest *req)
 {
-	if (!list_add(world->enemy_list, enemy)) {
-		error(ERR_NO_MEM);
-		return 0;
-	} else if (!sim_add_body(world->sim, &enemy->body)) {
-		list_remove(world->enemy_list, enemy, ptr_cmp);
-		return 0;
+	if (log->count == log->capacity) {
+		size_t capacity = log->capacity + EVENT_QUEUE_BASE_SIZE;
+		void *requests = realloc(
+			log->requests,
+			sizeof(struct SpawnRequest) * capacity
+		);
+		if (!requests) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		log->requests = requests;
+		log->capacity = capacity;
 	}
+	log->requests[log->count++] = *req;
 	return 1;
 }
 
-int
-world_add_projectile(struct World *world, struct Projectile *projectile)
+Entity
+world_request_spawn(struct World *world, const struct SpawnRequest *req)
 {
-	if (!list_add(world->projectile_list, projectile)) {
-		error(ERR_NO_MEM);
+	if (world->spawn_log && !log_spawn(world->spawn_log, req)) {
 		return 0;
-	} else if (!sim_add_body(world->sim, &projectile->body)) {
-		list_remove(world->projectile_list, projectile, ptr_cmp);
+	}
+
+	switch (req->kind) {
+	case SPAWN_ENEMY:
+		return enemy_spawn(world, req->x, req->y);
+	case SPAWN_ASTEROID:
+		return asteroid_spawn(
+			world,
+			req->x,
+			req->y,
+			req->xvel,
+			req->yvel,
+			req->rot_speed
+		);
+	}
+	return 0;
+}
+
+void
+spawn_log_release(struct SpawnLog *log)
+{
+	if (log) {
+		free(log->requests);
+		log->requests = NULL;
+		log->count = log->capacity = 0;
+	}
+}
+
+Entity
+world_spawn(struct World *world, uint32_t mask, const struct Body *body)
+{
+	Entity e = ecs_create(world->ecs, mask);
+	if (!e) {
 		return 0;
 	}
-	return 1;
+
+	if (body) {
+		assert(mask & ECS_BIT(COMPONENT_BODY));
+
+		struct Transform *t = ecs_get(world->ecs, e, COMPONENT_TRANSFORM);
+		if (t) {
+			t->x = scalar_to_float(body->x);
+			t->y = scalar_to_float(body->y);
+		}
+
+		// make the body refer back to its entity
+		struct Body b = *body;
+		b.userdata = (void*)(uintptr_t)e;
+		BodyID id = sim_add_body(world->sim, &b);
+		if (!id) {
+			ecs_kill(world->ecs, e);
+			ecs_flush(world->ecs);
+			return 0;
+		}
+		*(BodyID*)ecs_get(world->ecs, e, COMPONENT_BODY) = id;
+	}
+
+	return e;
 }
 
+/**
+ * Destroy entities which ran out of hitpoints.
+ */
 static int
-update_enemy(void *enemy_ptr, void *ctx_ptr)
+health_system(struct EcsView *view, void *ctx_ptr)
 {
-	struct Enemy *enemy = enemy_ptr;
 	struct UpdateContext *ctx = ctx_ptr;
+	float *health = view->columns[COMPONENT_HEALTH];
+	for (size_t i = 0; i < view->count; i++) {
+		if (health[i] <= 0) {
+			struct Event evt = { EVENT_ENEMY_KILL };
+			add_event(ctx->world, &evt);
+			ecs_kill(ctx->world->ecs, view->entities[i]);
+		}
+	}
+	return 1;
+}
 
-	// check enemy conditions and TTL and if not satisfied, destroy it and
-	// remove from the list
-	int destroy = 0;
-	if (enemy->hitpoints <= 0) {
-		destroy = 1;
-		struct Event evt = { EVENT_ENEMY_KILL };
-		add_event(ctx->world, &evt);
-	} else if ((enemy->ttl -= ctx->dt) <= 0) {
-		destroy = 1;
+/**
+ * Destroy entities whose time to live expired.
+ */
+static int
+ttl_system(struct EcsView *view, void *ctx_ptr)
+{
+	struct UpdateContext *ctx = ctx_ptr;
+	float *ttl = view->columns[COMPONENT_TTL];
+	for (size_t i = 0; i < view->count; i++) {
+		if ((ttl[i] -= ctx->dt) <= 0) {
+			ecs_kill(ctx->world->ecs, view->entities[i]);
+		}
 	}
+	return 1;
+}
 
-	if (destroy) {
-		sim_remove_body(ctx->world->sim, &enemy->body);
-		enemy_destroy(enemy);
-		return 0;
+/**
+ * Rotate spinning entities.
+ */
+static int
+spin_system(struct EcsView *view, void *ctx_ptr)
+{
+	struct UpdateContext *ctx = ctx_ptr;
+	struct Transform *t = view->columns[COMPONENT_TRANSFORM];
+	float *spin = view->columns[COMPONENT_SPIN];
+	for (size_t i = 0; i < view->count; i++) {
+		t[i].rot += spin[i] * ctx->dt;
+		if (t[i].rot >= M_PI * 2) {
+			t[i].rot -= M_PI * 2;
+		}
 	}
+	return 1;
+}
 
+/**
+ * Scroll entities down along with the screen.
+ */
+static int
+scroll_system(struct EcsView *view, void *ctx_ptr)
+{
+	struct UpdateContext *ctx = ctx_ptr;
+	BodyID *bodies = view->columns[COMPONENT_BODY];
+	Scalar distance = scalar_from_float(SCROLL_SPEED * ctx->dt);
+	for (size_t i = 0; i < view->count; i++) {
+		sim_get_body(ctx->world->sim, bodies[i])->y += distance;
+	}
 	return 1;
 }
 
+/**
+ * Copy body positions to entity transforms.
+ */
 static int
-update_asteroid(void *ast_ptr, void *ctx_ptr)
+body_sync_system(struct EcsView *view, void *ctx_ptr)
 {
-	struct Asteroid *ast = ast_ptr;
 	struct UpdateContext *ctx = ctx_ptr;
+	struct Transform *t = view->columns[COMPONENT_TRANSFORM];
+	BodyID *bodies = view->columns[COMPONENT_BODY];
+	for (size_t i = 0; i < view->count; i++) {
+		const struct Body *body = sim_get_body(ctx->world->sim, bodies[i]);
+		t[i].x = scalar_to_float(body->x);
+		t[i].y = scalar_to_float(body->y);
+	}
+	return 1;
+}
 
-	// destroy and filter out the asteroid from list if its TTL expired
-	if ((ast->ttl -= ctx->dt) <= 0) {
-		sim_remove_body(ctx->world->sim, &ast->body);
-		asteroid_destroy(ast);
+static int
+extract_renderables(struct EcsView *view, void *frame_ptr)
+{
+	struct WorldFrame *frame = frame_ptr;
+	size_t count = frame->renderable_count + view->count;
+	if (!world_frame_reserve(frame, count)) {
 		return 0;
 	}
 
-	// update position
-	ast->x = ast->body.x;
-	ast->y = ast->body.y;
-
-	// update rotation
-	ast->rot += ast->rot_speed * ctx->dt;
-	if (ast->rot >= M_PI * 2) {
-		ast->rot -= M_PI * 2;
+	struct Transform *t = view->columns[COMPONENT_TRANSFORM];
+	int *sprite = view->columns[COMPONENT_SPRITE];
+	struct Renderable *r = frame->renderables + frame->renderable_count;
+	for (size_t i = 0; i < view->count; i++) {
+		r[i].entity = view->entities[i];
+		r[i].x = t[i].x;
+		r[i].y = t[i].y;
+		r[i].rot = t[i].rot;
+		r[i].sprite = sprite[i];
 	}
-
+	frame->renderable_count = count;
 	return 1;
 }
 
-static int
-update_projectile(void *prj_ptr, void *ctx_ptr)
+int
+world_extract(struct World *world, struct WorldFrame *frame)
 {
-	struct Projectile *prj = prj_ptr;
-	struct UpdateContext *ctx = ctx_ptr;
-	if ((prj->ttl -= ctx->dt) <= 0) {
-		sim_remove_body(ctx->world->sim, &prj->body);
-		projectile_destroy(prj);
+	frame->hitpoints = world->player.hitpoints;
+	frame->credits = world->player.credits;
+
+	// player comes first
+	struct Transform player = { world->player.x, world->player.y, 0 };
+	int player_sprite = SPRITE_PLAYER;
+	Entity player_entity = 0;
+	struct EcsView view = { 1, &player_entity };
+	view.columns[COMPONENT_TRANSFORM] = &player;
+	view.columns[COMPONENT_SPRITE] = &player_sprite;
+	frame->renderable_count = 0;
+	if (!extract_renderables(&view, frame)) {
 		return 0;
 	}
 
-	// update position
-	prj->x = prj->body.x;
-	prj->y = prj->body.y;
+	return ecs_foreach(
+		world->ecs,
+		ECS_BIT(COMPONENT_TRANSFORM) | ECS_BIT(COMPONENT_SPRITE),
+		extract_renderables,
+		frame
+	);
+}
 
+int
+world_frame_reserve(struct WorldFrame *frame, size_t count)
+{
+	if (count > frame->renderable_capacity) {
+		size_t capacity = count + ECS_CHUNK_SIZE;
+		void *renderables = realloc(
+			frame->renderables,
+			sizeof(struct Renderable) * capacity
+		);
+		if (!renderables) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		frame->renderables = renderables;
+		frame->renderable_capacity = capacity;
+	}
 	return 1;
 }
 
+void
+world_frame_release(struct WorldFrame *frame)
+{
+	if (frame) {
+		free(frame->renderables);
+		frame->renderables = NULL;
+		frame->renderable_count = frame->renderable_capacity = 0;
+	}
+}
+
 static void
-scroll_entity(void *entity_ptr, void *ctx_ptr)
+apply_input_event(struct Player *plr, const struct InputEvent *evt)
 {
-	struct Entity *entity = entity_ptr;
-	struct UpdateContext *ctx = ctx_ptr;
-	entity->y = entity->body.y += SCROLL_SPEED * ctx->dt;
+	if (evt->pressed) {
+		plr->actions |= evt->action;
+		plr->latched_actions |= evt->action;
+	} else {
+		plr->actions &= ~evt->action;
+	}
+}
+
+static void
+pop_input_event(struct World *world)
+{
+	apply_input_event(
+		&world->player,
+		&world->input_queue[world->input_head]
+	);
+	world->input_head = (world->input_head + 1) % INPUT_QUEUE_SIZE;
+	world->input_count--;
+}
+
+void
+world_push_input(struct World *world, double time, int action, int pressed)
+{
+	// when the queue is full, apply the oldest event right away
+	if (world->input_count == INPUT_QUEUE_SIZE) {
+		pop_input_event(world);
+	}
+
+	size_t tail = (world->input_head + world->input_count) % INPUT_QUEUE_SIZE;
+	struct InputEvent *evt = &world->input_queue[tail];
+	evt->time = time;
+	evt->action = action;
+	evt->pressed = pressed;
+	world->input_count++;
+}
+
+void
+world_set_actions(struct World *world, int actions)
+{
+	// actions of queued events are yet to be applied
+	int current = world->player.actions;
+	for (size_t i = 0; i < world->input_count; i++) {
+		const struct InputEvent *evt = &world->input_queue[
+			(world->input_head + i) % INPUT_QUEUE_SIZE
+		];
+		if (evt->pressed) {
+			current |= evt->action;
+		} else {
+			current &= ~evt->action;
+		}
+	}
+
+	int changed = current ^ actions;
+	for (int act = ACTION_MOVE_LEFT; act <= ACTION_SHOOT; act <<= 1) {
+		if (changed & act) {
+			world_push_input(world, world->time, act, actions & act);
+		}
+	}
+}
+
+/**
+ * Print a gameplay message, unless the world is quiet.
+ */
+static void
+print_event(const struct World *world, const char *msg)
+{
+	if (!world->quiet) {
+		puts(msg);
+	}
+}
+
+static int
+step_player(struct World *world, float dt)
+{
+	struct Player *plr = &world->player;
+
+	// actions pressed and released within the step still count once
+	int actions = plr->actions | plr->latched_actions;
+	plr->latched_actions = 0;
+
+	// update player position
+	float distance = dt * plr->speed;
+	int dir = 0;
+	if (actions & ACTION_MOVE_LEFT) {
+		dir = -1;
+	} else if (actions & ACTION_MOVE_RIGHT) {
+		dir = 1;
+	}
+	struct Body *body = sim_get_body(world->sim, plr->body);
+	body->x += scalar_from_float(dir * distance);
+	plr->x = scalar_to_float(body->x);
+
+	// handle shooting
+	plr->shoot_cooldown -= dt;
+	if (actions & ACTION_SHOOT &&
+	    plr->shoot_cooldown <= 0) {
+		// reset cooldown timer
+		plr->shoot_cooldown = 1.0 / PLAYER_ACTION_SHOOT_RATE;
+
+		// shoot a projectile
+		if (!projectile_spawn(world, plr->x, plr->y)) {
+			return 0;
+		}
+	}
+
+	return 1;
 }
 
 int
@@ -316,49 +612,68 @@ world_update(struct World *world, float dt)
 {
 	struct Player *plr = &world->player;
 
-	// update physics
-	static float sim_acc = 0;
-	sim_acc += dt;
-	while (sim_acc >= SIMULATION_STEP) {
-		if (!sim_step(world->sim, SIMULATION_STEP)) {
+	// update player and physics in fixed steps, applying each input event
+	// right before the step it falls within
+	world->time += dt;
+	world->sim_acc += dt;
+	while (world->sim_acc >= SIMULATION_STEP) {
+		double step_end = world->time - world->sim_acc + SIMULATION_STEP;
+		while (world->input_count > 0 &&
+		       world->input_queue[world->input_head].time < step_end) {
+			pop_input_event(world);
+		}
+
+		if (!step_player(world, SIMULATION_STEP) ||
+		    !sim_step(world->sim, SIMULATION_STEP)) {
 			return 0;
 		}
-		sim_acc -= SIMULATION_STEP;
+		world->sim_acc -= SIMULATION_STEP;
 	}
 
 	// process events
 	for (size_t i = 0; i < world->event_count; i++) {
 		struct Event *evt = &world->event_queue[i];
-		struct Enemy *enemy;
-		struct Projectile *prj = NULL;
-		struct Asteroid *ast = NULL;
+		float *hitpoints, *ttl;
 
 		switch (evt->type) {
 		case EVENT_ENEMY_HIT:
-			printf("enemy hit by player!\n");
-			enemy = evt->hit.target;
-			enemy->hitpoints -= PLAYER_INITIAL_DAMAGE;
-			prj = evt->hit.projectile;
-			prj->ttl = 0;
+			print_event(world, "enemy hit by player!");
+			hitpoints = ecs_get(world->ecs, evt->hit.target, COMPONENT_HEALTH);
+			if (hitpoints) {
+				*hitpoints -= PLAYER_INITIAL_DAMAGE;
+			}
+			ecs_kill(world->ecs, evt->hit.projectile);
 			break;
 		case EVENT_PLAYER_COLLISION:
-			switch (evt->collision.second->type) {
+			switch (evt->collision.other_type) {
 			case BODY_TYPE_ENEMY:
-				printf("player collided with an enemy!\n");
+				print_event(world, "player collided with an enemy!");
 				plr->hitpoints -= ENEMY_COLLISION_DAMAGE;
-				enemy = evt->collision.second->userdata;
-				enemy->hitpoints = 0;
+				hitpoints = ecs_get(
+					world->ecs,
+					evt->collision.other,
+					COMPONENT_HEALTH
+				);
+				if (hitpoints) {
+					*hitpoints = 0;
+				}
 				break;
 			case BODY_TYPE_ASTEROID:
-				printf("player collided with an asteroid!\n");
+				print_event(world, "player collided with an asteroid!");
 				plr->hitpoints -= ASTEROID_COLLISION_DAMAGE;
-				ast = evt->collision.second->userdata;
-				ast->ttl = 0;
+				ttl = ecs_get(
+					world->ecs,
+					evt->collision.other,
+					COMPONENT_TTL
+				);
+				if (ttl) {
+					*ttl = 0;
+				}
 				break;
 			}
 			break;
 		case EVENT_ENEMY_KILL:
-			printf("enemy killed!\n");
+			print_event(world, "enemy killed!");
 			plr->credits += ENEMY_CREDIT_YIELD;
 			break;
 		}
@@ -371,48 +686,46 @@ world_update(struct World *world, float dt)
 		return 0;
 	}
 
-	// update player position
-	float distance = dt * plr->speed;
-	int dir = 0;
-	if (plr->actions & ACTION_MOVE_LEFT) {
-		dir = -1;
-	} else if (plr->actions & ACTION_MOVE_RIGHT) {
-		dir = 1;
-	}
-	plr->x = plr->body.x += (dir * distance);
-
-	// handle shooting
-	plr->shoot_cooldown -= dt;
-	if (plr->actions & ACTION_SHOOT &&
-	    plr->shoot_cooldown <= 0) {
-		// reset cooldown timer
-		plr->shoot_cooldown = 1.0 / PLAYER_ACTION_SHOOT_RATE;
-
-		// shoot a projectile
-		struct Projectile *prj = projectile_new(plr->x, plr->y);
-		if (!prj || !world_add_projectile(world, prj)) {
-			projectile_destroy(prj);
-			return 0;
-		}
-	}
-
 	struct UpdateContext ctx = {
 		world,
 		dt
 	};
 
-	// update enemies
-	list_filter(world->enemy_list, update_enemy, &ctx);
-
-	// update asteroids
-	list_filter(world->asteroid_list, update_asteroid, &ctx);
-
-	// update projectiles
-	list_filter(world->projectile_list, update_projectile, &ctx);
+	// run entity systems
+	static const struct {
+		EcsSystem system;
+		uint32_t mask;
+	} systems[] = {
+		{
+			health_system,
+			ECS_BIT(COMPONENT_HEALTH)
+		},
+		{
+			ttl_system,
+			ECS_BIT(COMPONENT_TTL)
+		},
+		{
+			spin_system,
+			ECS_BIT(COMPONENT_TRANSFORM) | ECS_BIT(COMPONENT_SPIN)
+		},
+		{
+			scroll_system,
+			ECS_BIT(COMPONENT_BODY) | ECS_BIT(COMPONENT_SCROLL)
+		},
+		{
+			body_sync_system,
+			ECS_BIT(COMPONENT_TRANSFORM) | ECS_BIT(COMPONENT_BODY)
+		},
+		{ NULL }
+	};
+	for (int i = 0; systems[i].system; i++) {
+		if (!ecs_foreach(world->ecs, systems[i].mask, systems[i].system, &ctx)) {
+			return 0;
+		}
+	}
 
-	// scroll entities down
-	list_foreach(world->enemy_list, scroll_entity, &ctx);
-	list_foreach(world->asteroid_list, scroll_entity, &ctx);
+	// destroy entities killed during this update
+	ecs_flush(world->ecs);
 
 	return 1;
-}
\ No newline at end of file
+}
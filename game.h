@@ -1,14 +1,16 @@
 #pragma once
 
-#include "list.h"
+#include "ecs.h"
 #include "physics.h"
 
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 800
 #define SCROLL_SPEED 30.0 // units / second
-#define SIMULATION_STEP 1.0 / 30
+#define SIMULATION_STEP (1.0 / 30)
 #define TICK 1.0 // seconds
+#define STEPS_PER_TICK ((unsigned long)(TICK / SIMULATION_STEP + 0.5))
 #define EVENT_QUEUE_BASE_SIZE 20
+#define INPUT_QUEUE_SIZE 64
 
 #define ENTITY_TTL (SCREEN_HEIGHT / SCROLL_SPEED) * 2.0 + 3.0 // seconds
 
@@ -33,6 +35,8 @@ enum {
 	ACTION_SHOOT = 1 << 2,
 };
 
+#define ACTION_BITS 8  // bits of action bitmasks sent over the network
+
 /**
  * Enumeration of body type bits.
  */
@@ -54,46 +58,53 @@ enum {
 };
 
 /**
- * Player.
+ * Entity component identifiers.
  */
-struct Player {
-	float x, y;
-	struct Body body;
-	float hitpoints;
-	int credits;
-	int actions;
-	float speed;
-	float shoot_cooldown;
+enum {
+	COMPONENT_TRANSFORM,  // struct Transform
+	COMPONENT_BODY,       // BodyID
+	COMPONENT_TTL,        // float, seconds
+	COMPONENT_HEALTH,     // float, hitpoints
+	COMPONENT_SPIN,       // float, rotation speed in rad/s
+	COMPONENT_SPRITE,     // int, one of SPRITE_* identifiers
+	COMPONENT_SCROLL,     // tag, scrolled down with the screen
+	COMPONENT_COUNT
 };
 
 /**
- * Enemy.
+ * Entity sprite identifiers.
+ *
+ * The game has no knowledge of how the sprites look like, it's up to the
+ * renderer to map these to actual images.
  */
-struct Enemy {
-	float x, y;
-	struct Body body;
-	float hitpoints;
-	float ttl;
+enum {
+	SPRITE_PLAYER,
+	SPRITE_ENEMY,
+	SPRITE_ASTEROID,
+	SPRITE_PROJECTILE,
+	SPRITE_COUNT
 };
 
 /**
- * Asteroid.
+ * Entity transform component.
  */
-struct Asteroid {
+struct Transform {
 	float x, y;
-	struct Body body;
 	float rot;
-	float rot_speed;
-	float ttl;
 };
 
 /**
- * Projectile.
+ * Player.
  */
-struct Projectile {
+struct Player {
 	float x, y;
-	struct Body body;
-	float ttl;
+	BodyID body;
+	float hitpoints;
+	int credits;
+	int actions;
+	int latched_actions;  // actions pressed during current step
+	float speed;
+	float shoot_cooldown;
 };
 
 /**
@@ -103,16 +114,80 @@ struct Event {
 	int type;
 	union {
 		struct CollisionEvent {
-			struct Body *first;
-			struct Body *second;
+			Entity other;
+			int other_type;
 		} collision;
 		struct HitEvent {
-			void *target;
-			struct Projectile *projectile;
+			Entity target;
+			Entity projectile;
 		} hit;
 	};
 };
 
+/**
+ * Input event.
+ *
+ * Timestamped change of player action state, the timestamp is in world time.
+ */
+struct InputEvent {
+	double time;
+	int action;
+	int pressed;
+};
+
+/**
+ * Renderable object of an extracted frame.
+ */
+struct Renderable {
+	Entity entity;  // 0 for the player
+	float x, y;
+	float rot;
+	int sprite;
+};
+
+/**
+ * Extracted frame.
+ *
+ * Copy of the world state needed to render a frame, which can be read while
+ * the world itself is being updated.
+ */
+struct WorldFrame {
+	struct Renderable *renderables;
+	size_t renderable_count;
+	size_t renderable_capacity;
+	float hitpoints;
+	int credits;
+};
+
+/**
+ * Spawn request kinds.
+ */
+enum {
+	SPAWN_ENEMY,
+	SPAWN_ASTEROID,
+};
+
+/**
+ * Spawn request, as made by scripts.
+ */
+struct SpawnRequest {
+	int kind;
+	float x, y;
+	float xvel, yvel;
+	float rot_speed;
+};
+
+/**
+ * Log of spawn requests.
+ *
+ * Must be zero-initialized before first use.
+ */
+struct SpawnLog {
+	struct SpawnRequest *requests;
+	size_t count;
+	size_t capacity;
+};
+
 /**
  * World container.
  *
@@ -120,15 +195,42 @@ struct Event {
  */
 struct World {
 	struct Player player;
-	struct List *asteroid_list;
-	struct List *projectile_list;
-	struct List *enemy_list;
+	struct Ecs *ecs;
 
 	struct SimulationSystem *sim;
+	double time;     // world time, advanced by each update
+	float sim_acc;   // time not yet consumed by simulation steps
+
+	struct InputEvent input_queue[INPUT_QUEUE_SIZE];
+	size_t input_head;
+	size_t input_count;
 
 	struct Event *event_queue;
 	size_t event_queue_size;
 	size_t event_count;
+
+	struct SpawnLog *spawn_log;  // if set, spawn requests are logged into it
+	int quiet;                   // if set, gameplay messages aren't printed
+};
+
+/**
+ * Saved world state.
+ *
+ * Must be zero-initialized before first use. Saving into the same snapshot
+ * again reuses its buffers, thus, doesn't allocate unless the world grew.
+ */
+struct WorldSnapshot {
+	struct Player player;
+	double time;
+	float sim_acc;
+	struct InputEvent input_queue[INPUT_QUEUE_SIZE];
+	size_t input_head;
+	size_t input_count;
+	struct Event *events;
+	size_t event_count;
+	size_t event_capacity;
+	struct EcsSnapshot ecs;
+	struct SimSnapshot sim;
 };
 
 /**
@@ -144,77 +246,113 @@ void
 world_destroy(struct World *w);
 
 /**
- * Add an anemy to the world.
+ * Queue a player input event.
  *
- * NOTE: This function takes the ownership of the object.
+ * Events are applied by `world_update()` right before the first simulation
+ * step which ends after event's time, thus, an action pressed and released
+ * within a single frame is not lost. Timestamps are in world time and must
+ * be non-decreasing.
+ */
+void
+world_push_input(struct World *world, double time, int action, int pressed);
+
+/**
+ * Queue input events which change player actions to given ones, at current
+ * world time.
+ */
+void
+world_set_actions(struct World *world, int actions);
+
+/**
+ * Update the world by given delta time.
  */
 int
-world_add_enemy(struct World *world, struct Enemy *enemy);
+world_update(struct World *world, float dt);
 
 /**
- * Add an asteroid to the world.
+ * Extract the world state needed for rendering into given frame.
  *
- * NOTE: This function takes the ownership of the object.
+ * The frame must be zero-initialized before first use and released with
+ * `world_frame_release()`.
  */
 int
-world_add_asteroid(struct World *world, struct Asteroid *ast);
+world_extract(struct World *world, struct WorldFrame *frame);
 
 /**
- * Add a projectile to the world.
- *
- * NOTE: This function takes the ownership of the object.
+ * Make room for given total number of renderables in a frame.
  */
 int
-world_add_projectile(struct World *world, struct Projectile *projectile);
+world_frame_reserve(struct WorldFrame *frame, size_t count);
+
+void
+world_frame_release(struct WorldFrame *frame);
 
 /**
- * Update the world by given delta time.
+ * Save the state of the world.
+ *
+ * Must be called between updates.
  */
 int
-world_update(struct World *world, float dt);
+world_save(const struct World *world, struct WorldSnapshot *snap);
 
 /**
- * Create an enemy.
+ * Restore a state saved from the same world.
  */
-struct Enemy*
-enemy_new(float x, float y);
+void
+world_restore(struct World *world, const struct WorldSnapshot *snap);
+
+void
+world_snapshot_release(struct WorldSnapshot *snap);
 
 /**
- * Destroy an enemy.
+ * Spawn an entity as requested, logging the request into world's spawn log,
+ * if any.
  *
- * NOTE: Do not attempt to destroy an object owned by the world.
+ * Returns the entity handle or 0 on failure.
  */
+Entity
+world_request_spawn(struct World *world, const struct SpawnRequest *req);
+
 void
-enemy_destroy(struct Enemy *enemy);
+spawn_log_release(struct SpawnLog *log);
 
 /**
- * Create an asteroid.
+ * Spawn an entity with given components and a physics body.
  *
- * NOTE: Do not attempt to destroy an object owned by the world.
+ * The body, if any, is owned by the entity and removed along with it.
+ * Transform is initialized from body position, other components are zeroed.
+ * Returns the entity handle or 0 on failure.
  */
-struct Asteroid*
-asteroid_new(float x, float y, float xvel, float yvel, float rot_speed);
+Entity
+world_spawn(struct World *world, uint32_t mask, const struct Body *body);
 
 /**
- * Destroy an asteroid.
+ * Spawn an enemy.
  *
- * NOTE: Do not attempt to destroy an object owned by the world.
+ * Returns the entity handle or 0 on failure.
  */
-void
-asteroid_destroy(struct Asteroid *ast);
+Entity
+enemy_spawn(struct World *world, float x, float y);
 
 /**
- * Create a projectile.
+ * Spawn an asteroid.
  *
- * NOTE: Do not attempt to destroy an object owned by the world.
+ * Returns the entity handle or 0 on failure.
  */
-struct Projectile*
-projectile_new(float x, float y);
+Entity
+asteroid_spawn(
+	struct World *world,
+	float x,
+	float y,
+	float xvel,
+	float yvel,
+	float rot_speed
+);
 
 /**
- * Destroy a projectile.
+ * Spawn a projectile.
  *
- * NOTE: Do not attempt to destroy an object owned by the world.
+ * Returns the entity handle or 0 on failure.
  */
-void
-projectile_destroy(struct Projectile *prj);
\ No newline at end of file
+Entity
+projectile_spawn(struct World *world, float x, float y);
@@ -0,0 +1,219 @@
+#include "hud.h"
+#include "memory.h"
+#include "strutils.h"
+#include "text.h"
+#include "widget.h"
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HUD_MAX_NODES 32
+#define HUD_TEXT_SIZE 128
+
+enum {
+	HUD_NODE_WIDGET,
+	HUD_NODE_TEXT,
+};
+
+struct HudNode {
+	int type;
+	struct HudNode *parent;
+	float x, y;                   // relative to the parent
+	float abs_x, abs_y;           // computed by layout
+	union {
+		struct Widget *widget;
+		struct Text *text;
+	};
+	char string[HUD_TEXT_SIZE];   // current string of text nodes
+};
+
+struct Hud {
+	unsigned width, height;
+	struct RenderTarget *target;
+	struct RenderList *list;
+	int dirty;
+
+	// parents always precede their children
+	struct HudNode nodes[HUD_MAX_NODES];
+	size_t node_count;
+};
+
+struct Hud*
+hud_new(unsigned width, unsigned height)
+{
+	struct Hud *hud = make(struct Hud);
+	if (!hud) {
+		return NULL;
+	}
+	hud->width = width;
+	hud->height = height;
+	hud->dirty = 1;
+
+	if (!(hud->target = render_target_new(width, height)) ||
+	    !(hud->list = render_list_new())) {
+		hud_destroy(hud);
+		return NULL;
+	}
+
+	return hud;
+}
+
+void
+hud_destroy(struct Hud *hud)
+{
+	if (hud) {
+		render_list_destroy(hud->list);
+		render_target_destroy(hud->target);
+		destroy(hud);
+	}
+}
+
+static struct HudNode*
+add_node(struct Hud *hud, struct HudNode *parent, int type, float x, float y)
+{
+	assert(hud->node_count < HUD_MAX_NODES);
+
+	struct HudNode *node = &hud->nodes[hud->node_count++];
+	memset(node, 0, sizeof(struct HudNode));
+	node->type = type;
+	node->parent = parent;
+	node->x = x;
+	node->y = y;
+	hud->dirty = 1;
+	return node;
+}
+
+struct HudNode*
+hud_add_widget(
+	struct Hud *hud,
+	struct HudNode *parent,
+	struct Widget *widget,
+	float x,
+	float y
+) {
+	assert(widget != NULL);
+	struct HudNode *node = add_node(hud, parent, HUD_NODE_WIDGET, x, y);
+	node->widget = widget;
+	return node;
+}
+
+struct HudNode*
+hud_add_text(
+	struct Hud *hud,
+	struct HudNode *parent,
+	struct Text *text,
+	float x,
+	float y
+) {
+	assert(text != NULL);
+	struct HudNode *node = add_node(hud, parent, HUD_NODE_TEXT, x, y);
+	node->text = text;
+	return node;
+}
+
+void
+hud_set_position(struct Hud *hud, struct HudNode *node, float x, float y)
+{
+	if (node->x != x || node->y != y) {
+		node->x = x;
+		node->y = y;
+		hud->dirty = 1;
+	}
+}
+
+void
+hud_set_size(struct Hud *hud, struct HudNode *node, unsigned width, unsigned height)
+{
+	assert(node->type == HUD_NODE_WIDGET);
+	struct Widget *widget = node->widget;
+	if (widget->width != width || widget->height != height) {
+		widget->width = width;
+		widget->height = height;
+		hud->dirty = 1;
+	}
+}
+
+int
+hud_set_text_fmt(struct Hud *hud, struct HudNode *node, const char *fmt, ...)
+{
+	assert(node->type == HUD_NODE_TEXT);
+
+	char buf[HUD_TEXT_SIZE];
+	va_list ap;
+	va_start(ap, fmt);
+	size_t len = string_vfmt_buf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	// strings too long to be kept are always considered changed
+	if (len < sizeof(buf) && strcmp(buf, node->string) == 0) {
+		return 1;
+	}
+	memcpy(node->string, buf, sizeof(buf));
+	hud->dirty = 1;
+
+	if (len < sizeof(buf)) {
+		return text_set_string(node->text, buf);
+	}
+	va_start(ap, fmt);
+	char *str = string_vfmt(fmt, ap);
+	va_end(ap);
+	if (!str) {
+		return 0;
+	}
+	int ok = text_set_string(node->text, str);
+	free(str);
+	return ok;
+}
+
+static void
+layout(struct Hud *hud)
+{
+	for (size_t i = 0; i < hud->node_count; i++) {
+		struct HudNode *node = &hud->nodes[i];
+		node->abs_x = node->x;
+		node->abs_y = node->y;
+		if (node->parent) {
+			node->abs_x += node->parent->abs_x;
+			node->abs_y += node->parent->abs_y;
+		}
+	}
+}
+
+int
+hud_render(struct Hud *hud)
+{
+	if (hud->dirty) {
+		layout(hud);
+
+		// widgets are placed by their top-left corner, while texts are
+		// relative to the center of the screen
+		for (size_t i = 0; i < hud->node_count; i++) {
+			struct HudNode *node = &hud->nodes[i];
+			switch (node->type) {
+			case HUD_NODE_WIDGET:
+				render_list_add_widget(
+					hud->list,
+					node->widget,
+					node->abs_x,
+					node->abs_y
+				);
+				break;
+			case HUD_NODE_TEXT:
+				render_list_add_text(
+					hud->list,
+					node->text,
+					node->abs_x - hud->width / 2.0f,
+					node->abs_y - hud->height / 2.0f
+				);
+				break;
+			}
+		}
+		if (!render_list_exec_target(hud->list, hud->target)) {
+			return 0;
+		}
+		hud->dirty = 0;
+	}
+
+	return render_target_draw(hud->target, 0, 0, hud->width, hud->height);
+}
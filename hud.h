@@ -0,0 +1,78 @@
+#pragma once
+
+#include "renderer.h"
+
+struct Text;
+struct Widget;
+
+/**
+ * Retained-mode heads-up display.
+ *
+ * A tree of widgets and texts positioned relative to their parents, in
+ * screen pixels from the top-left corner. The HUD is laid out and rendered
+ * into an offscreen target only when some of its properties change, thus,
+ * otherwise it costs a single draw per frame.
+ */
+struct Hud;
+
+/**
+ * HUD node handle.
+ */
+struct HudNode;
+
+struct Hud*
+hud_new(unsigned width, unsigned height);
+
+void
+hud_destroy(struct Hud *hud);
+
+/**
+ * Add a widget, positioned relative to the parent node, or to the HUD if
+ * the parent is NULL.
+ *
+ * The widget must outlive the HUD and be changed only through the HUD.
+ */
+struct HudNode*
+hud_add_widget(
+	struct Hud *hud,
+	struct HudNode *parent,
+	struct Widget *widget,
+	float x,
+	float y
+);
+
+/**
+ * Add a text, positioned relative to the parent node, or to the HUD if the
+ * parent is NULL.
+ *
+ * The text must outlive the HUD and be changed only through the HUD.
+ */
+struct HudNode*
+hud_add_text(
+	struct Hud *hud,
+	struct HudNode *parent,
+	struct Text *text,
+	float x,
+	float y
+);
+
+void
+hud_set_position(struct Hud *hud, struct HudNode *node, float x, float y);
+
+/**
+ * Set the size of a widget node.
+ */
+void
+hud_set_size(struct Hud *hud, struct HudNode *node, unsigned width, unsigned height);
+
+/**
+ * Set the string of a text node; setting the same one again is a no-op.
+ */
+int
+hud_set_text_fmt(struct Hud *hud, struct HudNode *node, const char *fmt, ...);
+
+/**
+ * Draw the HUD on the screen, rendering it anew if anything changed.
+ */
+int
+hud_render(struct Hud *hud);
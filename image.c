@@ -0,0 +1,609 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "error.h"
+#include "image.h"
+#include "memory.h"
+#include "strutils.h"
+#include <assert.h>
+#include <png.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#define CONTAINER_MAGIC "YTEX"
+#define CONTAINER_VERSION 1
+
+static void*
+read_png(const char *filename, unsigned int *r_width, unsigned int *r_height)
+{
+	assert(filename != NULL);
+
+	void *data = NULL;
+	png_structp png_ptr = NULL;
+	png_infop info_ptr = NULL;
+	png_bytepp rows = NULL;
+
+	// open the given file
+	FILE *fp = fopen(filename, "rb");
+	if (!fp) {
+		error(ERR_FILE_READ);
+		return NULL;
+	}
+
+	// attempt to read 8 bytes and check whether we're reading a PNG file
+	size_t hdr_size = 8;
+	unsigned char hdr[hdr_size];
+	if (fread(hdr, 1, hdr_size, fp) < hdr_size ||
+	    png_sig_cmp(hdr, 0, hdr_size) != 0) {
+		error(ERR_FILE_BAD);
+		goto error;
+	}
+
+	// allocate libpng structs
+	png_ptr = png_create_read_struct(
+		PNG_LIBPNG_VER_STRING,
+		NULL,
+		NULL,
+		NULL
+	);
+	if (!png_ptr) {
+		error(ERR_LIBPNG);
+		goto error;
+	}
+
+	info_ptr = png_create_info_struct(png_ptr);
+	if (!info_ptr) {
+		error(ERR_LIBPNG);
+		goto error;
+	}
+
+	// set the error handling longjmp point
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		error(ERR_FILE_BAD);
+		goto error;
+	}
+
+	// init file reading IO
+	png_init_io(png_ptr, fp);
+	png_set_sig_bytes(png_ptr, hdr_size);
+
+	// read image information
+	png_read_info(png_ptr, info_ptr);
+
+	// get image info
+	int color_type = png_get_color_type(png_ptr, info_ptr);
+	int bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+
+	// transform paletted images to RGB
+	if (color_type == PNG_COLOR_TYPE_PALETTE) {
+		png_set_palette_to_rgb(png_ptr);
+	}
+
+	// transform packed grayscale images to 8bit
+	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
+		png_set_expand_gray_1_2_4_to_8(png_ptr);
+	}
+	if (color_type == PNG_COLOR_TYPE_GRAY ||
+	    color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+		png_set_gray_to_rgb(png_ptr);
+	}
+
+	// strip 16bit images down to 8bit
+	if (bit_depth == 16) {
+		png_set_strip_16(png_ptr);
+	}
+
+	// add full alpha channel, either from transparency chunk or opaque
+	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+		png_set_tRNS_to_alpha(png_ptr);
+	} else if (!(color_type & PNG_COLOR_MASK_ALPHA)) {
+		png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
+	}
+	png_read_update_info(png_ptr, info_ptr);
+
+	// retrieve image size
+	unsigned width = png_get_image_width(png_ptr, info_ptr);
+	unsigned height = png_get_image_height(png_ptr, info_ptr);
+
+	if (r_width) {
+		*r_width = width;
+	}
+	if (r_height) {
+		*r_height = height;
+	}
+
+	// allocate space for image data
+	size_t rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+	assert(rowbytes == width * 4);
+	data = malloc(height * rowbytes);
+	if (!data) {
+		error(ERR_NO_MEM);
+		goto error;
+	}
+
+	// setup an array of image row pointers
+	rows = malloc(height * sizeof(png_bytep));
+	if (!rows) {
+		error(ERR_NO_MEM);
+		goto error;
+	}
+	for (size_t r = 0; r < height; r++) {
+		rows[r] = (png_bytep)data + rowbytes * r;
+	}
+
+	// read image data
+	png_read_image(png_ptr, rows);
+
+cleanup:
+	free(rows);
+	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+	fclose(fp);
+	return data;
+
+error:
+	free(data);
+	data = NULL;
+	goto cleanup;
+}
+
+struct Image*
+image_from_png(const char *filename)
+{
+	struct Image *image = make(struct Image);
+	if (!image) {
+		return NULL;
+	}
+
+	uint8_t *px = read_png(filename, &image->width, &image->height);
+	if (!px) {
+		image_destroy(image);
+		return NULL;
+	}
+	image->pixels[IMAGE_FORMAT_RGBA8] = px;
+	image->sizes[IMAGE_FORMAT_RGBA8] = image->width * image->height * 4;
+
+	// premultiply colors, for filtering and blending not to bleed colors of
+	// transparent texels
+	for (size_t i = 0; i < image->sizes[IMAGE_FORMAT_RGBA8]; i += 4) {
+		unsigned a = px[i + 3];
+		px[i + 0] = (px[i + 0] * a + 127) / 255;
+		px[i + 1] = (px[i + 1] * a + 127) / 255;
+		px[i + 2] = (px[i + 2] * a + 127) / 255;
+	}
+
+	return image;
+}
+
+struct Image*
+image_load(const char *filename)
+{
+	const char *ext = strrchr(filename, '.');
+	if (!ext || strchr(ext, '/')) {
+		ext = filename + strlen(filename);
+	}
+	char *baked = string_fmt(
+		"%.*s" IMAGE_FILE_EXT,
+		(int)(ext - filename),
+		filename
+	);
+	if (!baked) {
+		return NULL;
+	}
+
+	// baked images older than their source are stale, and skipped
+	struct Image *image;
+	struct stat src_stat, baked_stat;
+	if (strcmp(ext, IMAGE_FILE_EXT) != 0 &&
+	    stat(baked, &baked_stat) == 0 &&
+	    (stat(filename, &src_stat) != 0 ||
+	     baked_stat.st_mtime >= src_stat.st_mtime)) {
+		image = image_from_file(baked);
+	} else {
+		image = image_from_png(filename);
+	}
+	free(baked);
+	return image;
+}
+
+static void
+write_u32(uint8_t *buf, uint32_t v)
+{
+	buf[0] = v;
+	buf[1] = v >> 8;
+	buf[2] = v >> 16;
+	buf[3] = v >> 24;
+}
+
+static uint32_t
+read_u32(const uint8_t *buf)
+{
+	return buf[0] | buf[1] << 8 | buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+/**
+ * Size of given format pixels of an image, for validation of containers.
+ */
+static size_t
+format_size(int format, unsigned width, unsigned height)
+{
+	switch (format) {
+	case IMAGE_FORMAT_RGBA8:
+		return (size_t)width * height * 4;
+	case IMAGE_FORMAT_BC3:
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+	}
+	return 0;
+}
+
+struct Image*
+image_from_file(const char *filename)
+{
+	assert(filename != NULL);
+
+	FILE *fp = fopen(filename, "rb");
+	if (!fp) {
+		error(ERR_FILE_READ);
+		return NULL;
+	}
+
+	struct Image *image = make(struct Image);
+	if (!image) {
+		fclose(fp);
+		return NULL;
+	}
+
+	// header: magic, version, size and number of formats
+	uint8_t hdr[20];
+	if (fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr) ||
+	    memcmp(hdr, CONTAINER_MAGIC, 4) != 0 ||
+	    read_u32(hdr + 4) != CONTAINER_VERSION) {
+		error(ERR_FILE_BAD);
+		goto error;
+	}
+	image->width = read_u32(hdr + 8);
+	image->height = read_u32(hdr + 12);
+	uint32_t count = read_u32(hdr + 16);
+
+	// each format: identifier, size and pixels
+	for (uint32_t i = 0; i < count; i++) {
+		uint8_t fmt_hdr[8];
+		if (fread(fmt_hdr, 1, sizeof(fmt_hdr), fp) != sizeof(fmt_hdr)) {
+			error(ERR_FILE_BAD);
+			goto error;
+		}
+		uint32_t format = read_u32(fmt_hdr);
+		uint32_t size = read_u32(fmt_hdr + 4);
+		if (format >= IMAGE_FORMAT_COUNT ||
+		    image->pixels[format] ||
+		    size != format_size(format, image->width, image->height)) {
+			error(ERR_FILE_BAD);
+			goto error;
+		}
+		if (!(image->pixels[format] = malloc(size))) {
+			error(ERR_NO_MEM);
+			goto error;
+		}
+		image->sizes[format] = size;
+		if (fread(image->pixels[format], 1, size, fp) != size) {
+			error(ERR_FILE_BAD);
+			goto error;
+		}
+	}
+
+	fclose(fp);
+	return image;
+
+error:
+	fclose(fp);
+	image_destroy(image);
+	return NULL;
+}
+
+int
+image_write(const struct Image *image, const char *filename)
+{
+	assert(image != NULL);
+	assert(filename != NULL);
+
+	FILE *fp = fopen(filename, "wb");
+	if (!fp) {
+		error(ERR_FILE_READ);
+		return 0;
+	}
+
+	uint32_t count = 0;
+	for (int f = 0; f < IMAGE_FORMAT_COUNT; f++) {
+		count += image->pixels[f] != NULL;
+	}
+
+	uint8_t hdr[20];
+	memcpy(hdr, CONTAINER_MAGIC, 4);
+	write_u32(hdr + 4, CONTAINER_VERSION);
+	write_u32(hdr + 8, image->width);
+	write_u32(hdr + 12, image->height);
+	write_u32(hdr + 16, count);
+	int ok = fwrite(hdr, 1, sizeof(hdr), fp) == sizeof(hdr);
+
+	for (int f = 0; ok && f < IMAGE_FORMAT_COUNT; f++) {
+		if (!image->pixels[f]) {
+			continue;
+		}
+		uint8_t fmt_hdr[8];
+		write_u32(fmt_hdr, f);
+		write_u32(fmt_hdr + 4, image->sizes[f]);
+		ok = (
+			fwrite(fmt_hdr, 1, sizeof(fmt_hdr), fp) == sizeof(fmt_hdr) &&
+			fwrite(image->pixels[f], 1, image->sizes[f], fp) == image->sizes[f]
+		);
+	}
+
+	ok &= fclose(fp) == 0;
+	if (!ok) {
+		error(ERR_FILE_READ);
+	}
+	return ok;
+}
+
+int
+image_write_png(const struct Image *image, const char *filename)
+{
+	assert(image != NULL);
+	assert(image->pixels[IMAGE_FORMAT_RGBA8] != NULL);
+	assert(filename != NULL);
+
+	int ok = 0;
+	png_structp png_ptr = NULL;
+	png_infop info_ptr = NULL;
+	uint8_t *row = NULL;
+
+	FILE *fp = fopen(filename, "wb");
+	if (!fp) {
+		error(ERR_FILE_READ);
+		return 0;
+	}
+
+	// allocate libpng structs and the row to unpremultiply colors into
+	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (!png_ptr || !(info_ptr = png_create_info_struct(png_ptr))) {
+		error(ERR_LIBPNG);
+		goto cleanup;
+	}
+	if (!(row = malloc(image->width * 4))) {
+		error(ERR_NO_MEM);
+		goto cleanup;
+	}
+
+	// set the error handling longjmp point
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		error(ERR_LIBPNG);
+		goto cleanup;
+	}
+
+	png_init_io(png_ptr, fp);
+	png_set_IHDR(
+		png_ptr,
+		info_ptr,
+		image->width,
+		image->height,
+		8,
+		PNG_COLOR_TYPE_RGBA,
+		PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT,
+		PNG_FILTER_TYPE_DEFAULT
+	);
+	// favor speed over size, for frame captures to keep up
+	png_set_compression_level(png_ptr, Z_BEST_SPEED);
+	png_write_info(png_ptr, info_ptr);
+
+	const uint8_t *px = image->pixels[IMAGE_FORMAT_RGBA8];
+	for (unsigned y = 0; y < image->height; y++) {
+		for (unsigned x = 0; x < image->width * 4; x += 4) {
+			unsigned a = px[x + 3];
+			for (int c = 0; c < 3; c++) {
+				unsigned v = a ? (px[x + c] * 255 + a / 2) / a : 0;
+				row[x + c] = v < 255 ? v : 255;
+			}
+			row[x + 3] = a;
+		}
+		png_write_row(png_ptr, row);
+		px += image->width * 4;
+	}
+	png_write_end(png_ptr, NULL);
+	ok = 1;
+
+cleanup:
+	free(row);
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	if (fclose(fp) != 0 && ok) {
+		error(ERR_FILE_READ);
+		ok = 0;
+	}
+	return ok;
+}
+
+static uint16_t
+pack_565(const uint8_t *c)
+{
+	return (
+		(c[0] * 31 + 127) / 255 << 11 |
+		(c[1] * 63 + 127) / 255 << 5 |
+		(c[2] * 31 + 127) / 255
+	);
+}
+
+static void
+unpack_565(uint16_t v, int *c)
+{
+	int r = v >> 11, g = v >> 5 & 63, b = v & 31;
+	c[0] = r << 3 | r >> 2;
+	c[1] = g << 2 | g >> 4;
+	c[2] = b << 3 | b >> 2;
+}
+
+/**
+ * Encode a block of 16 RGBA pixels.
+ */
+static void
+encode_bc3_block(const uint8_t px[16][4], uint8_t *out)
+{
+	// alpha: endpoints are the extremes, with 6 values interpolated
+	// between them
+	int a_max = 0, a_min = 255;
+	for (int i = 0; i < 16; i++) {
+		a_max = px[i][3] > a_max ? px[i][3] : a_max;
+		a_min = px[i][3] < a_min ? px[i][3] : a_min;
+	}
+	int alphas[8] = { a_max, a_min };
+	for (int i = 2; i < 8; i++) {
+		alphas[i] = ((8 - i) * a_max + (i - 1) * a_min) / 7;
+	}
+	uint64_t a_bits = 0;
+	for (int i = 0; i < 16; i++) {
+		int best = 0, best_err = 256;
+		for (int j = 0; j < 8 && a_max != a_min; j++) {
+			int err = abs(alphas[j] - px[i][3]);
+			if (err < best_err) {
+				best = j;
+				best_err = err;
+			}
+		}
+		a_bits |= (uint64_t)best << (3 * i);
+	}
+	out[0] = a_max;
+	out[1] = a_min;
+	for (int i = 0; i < 6; i++) {
+		out[2 + i] = a_bits >> (8 * i);
+	}
+
+	// color: endpoints are the corners of the bounding box, inset a bit to
+	// reduce the error of the rest, with 2 colors interpolated in between
+	uint8_t lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			lo[c] = px[i][c] < lo[c] ? px[i][c] : lo[c];
+			hi[c] = px[i][c] > hi[c] ? px[i][c] : hi[c];
+		}
+	}
+	for (int c = 0; c < 3; c++) {
+		int inset = (hi[c] - lo[c]) / 16;
+		lo[c] += inset;
+		hi[c] -= inset;
+	}
+
+	// pick the diagonal of the box the colors actually lie along, by
+	// flipping the channels which vary opposite to the one varying most;
+	// deviations are taken from the mean, times 16 to stay integral, with
+	// their products well within the range of int
+	int sum[3] = { 0 }, dev[16][3], var[3] = { 0 };
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			sum[c] += px[i][c];
+		}
+	}
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			dev[i][c] = 16 * px[i][c] - sum[c];
+			var[c] += dev[i][c] * dev[i][c];
+		}
+	}
+	int ref = 1;
+	for (int c = 0; c < 3; c++) {
+		ref = var[c] > var[ref] ? c : ref;
+	}
+	for (int c = 0; c < 3; c++) {
+		int cov = 0;
+		for (int i = 0; i < 16; i++) {
+			cov += dev[i][c] * dev[i][ref];
+		}
+		if (cov < 0) {
+			uint8_t tmp = lo[c];
+			lo[c] = hi[c];
+			hi[c] = tmp;
+		}
+	}
+	// the first endpoint must be the greater one to interpolate 2 colors,
+	// instead of a single one and black
+	uint16_t c0 = pack_565(hi), c1 = pack_565(lo);
+	if (c0 < c1) {
+		uint16_t tmp = c0;
+		c0 = c1;
+		c1 = tmp;
+	}
+	int colors[4][3];
+	unpack_565(c0, colors[0]);
+	unpack_565(c1, colors[1]);
+	for (int c = 0; c < 3; c++) {
+		colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+		colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+	}
+	uint32_t c_bits = 0;
+	for (int i = 0; i < 16; i++) {
+		int best = 0, best_err = 1 << 30;
+		for (int j = 0; j < 4; j++) {
+			int dr = colors[j][0] - px[i][0];
+			int dg = colors[j][1] - px[i][1];
+			int db = colors[j][2] - px[i][2];
+			int err = dr * dr + dg * dg + db * db;
+			if (err < best_err) {
+				best = j;
+				best_err = err;
+			}
+		}
+		c_bits |= (uint32_t)best << (2 * i);
+	}
+	out[8] = c0;
+	out[9] = c0 >> 8;
+	out[10] = c1;
+	out[11] = c1 >> 8;
+	write_u32(out + 12, c_bits);
+}
+
+int
+image_compress_bc3(struct Image *image)
+{
+	const uint8_t *src = image->pixels[IMAGE_FORMAT_RGBA8];
+	assert(src != NULL);
+
+	size_t size = format_size(IMAGE_FORMAT_BC3, image->width, image->height);
+	uint8_t *out = malloc(size);
+	if (!out) {
+		error(ERR_NO_MEM);
+		return 0;
+	}
+
+	// blocks past the edges repeat the last row and column
+	uint8_t *block_out = out;
+	for (unsigned by = 0; by < image->height; by += 4) {
+		for (unsigned bx = 0; bx < image->width; bx += 4) {
+			uint8_t px[16][4];
+			for (unsigned i = 0; i < 16; i++) {
+				unsigned x = bx + i % 4, y = by + i / 4;
+				x = x < image->width ? x : image->width - 1;
+				y = y < image->height ? y : image->height - 1;
+				memcpy(px[i], src + (y * image->width + x) * 4, 4);
+			}
+			encode_bc3_block((const uint8_t (*)[4])px, block_out);
+			block_out += 16;
+		}
+	}
+
+	free(image->pixels[IMAGE_FORMAT_BC3]);
+	image->pixels[IMAGE_FORMAT_BC3] = out;
+	image->sizes[IMAGE_FORMAT_BC3] = size;
+	return 1;
+}
+
+void
+image_destroy(struct Image *image)
+{
+	if (image) {
+		for (int f = 0; f < IMAGE_FORMAT_COUNT; f++) {
+			free(image->pixels[f]);
+		}
+		destroy(image);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+
+#define IMAGE_FILE_EXT ".tex"
+
+/**
+ * Image pixel formats.
+ *
+ * Colors are always premultiplied by alpha.
+ */
+enum {
+	IMAGE_FORMAT_RGBA8,   // 4 bytes per pixel, top row first
+	IMAGE_FORMAT_BC3,     // 16 bytes per 4x4 block, also known as DXT5
+	IMAGE_FORMAT_COUNT
+};
+
+/**
+ * Image, with pixels in one or more formats.
+ */
+struct Image {
+	unsigned width, height;
+	void *pixels[IMAGE_FORMAT_COUNT];   // NULL for missing formats
+	size_t sizes[IMAGE_FORMAT_COUNT];
+};
+
+/**
+ * Read a PNG image, converting it to premultiplied RGBA8.
+ */
+struct Image*
+image_from_png(const char *filename);
+
+/**
+ * Read an image baked by `image_write()`.
+ */
+struct Image*
+image_from_file(const char *filename);
+
+/**
+ * Read an image, or its baked counterpart if there's one next to it, not
+ * older than the image.
+ */
+struct Image*
+image_load(const char *filename);
+
+/**
+ * Write an image into a raw container file, along with all formats it has.
+ *
+ * The container is read without decoding, thus, loads much faster than PNG.
+ */
+int
+image_write(const struct Image *image, const char *filename);
+
+/**
+ * Write the RGBA8 pixels of an image into a PNG file, with colors
+ * unpremultiplied.
+ */
+int
+image_write_png(const struct Image *image, const char *filename);
+
+/**
+ * Add a BC3 compressed copy of RGBA8 pixels.
+ */
+int
+image_compress_bc3(struct Image *image);
+
+void
+image_destroy(struct Image *image);
@@ -1,11 +1,19 @@
+#include "capture.h"
+#include "clock.h"
+#include "dynres.h"
 #include "error.h"
 #include "font.h"
 #include "game.h"
+#include "hud.h"
 #include "matlib.h"
 #include "memory.h"
+#include "netgame.h"
+#include "pacer.h"
 #include "renderer.h"
+#include "rollback.h"
 #include "script.h"
 #include "shader.h"
+#include "simthread.h"
 #include "sprite.h"
 #include "strutils.h"
 #include "text.h"
@@ -15,8 +23,37 @@
 #include <SDL.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_FPS 60
+#define DEFAULT_PORT 7777
+#define COOP_SEED 1             // seed of co-op scripts, the same on both peers
+#define STARFIELD_SPEED 60.0f   // pixels per second of the nearest stars
+#define GPU_BUDGET_SHARE 0.75f  // default share of the frame to render world in
+#define MIN_RESOLUTION_SCALE 0.5f
+
+/**
+ * Command line options.
+ */
+struct Options {
+	int pace_mode;
+	float fps;
+	int texture_filter;
+	float gpu_budget;              // seconds to render world in, 0 for native
+	const char *capture;           // prefix of captured frame files, if any
+	int capture_format;
+	int headless;                  // render offscreen, without a window
+	unsigned long frames;          // number of frames to run, 0 for no limit
+	int server;                    // run headless server
+	uint16_t port;                 // server or local co-op port
+	const char *connect;           // server address to connect to, if any
+	const char *peer;              // co-op peer address, if any
+	int player;                    // co-op player number
+	struct NetConditions net;      // simulated network conditions
+};
 
 /*** RESOURCES ***/
+static struct SpriteSet *sprite_set = NULL;
 static struct Sprite *spr_player = NULL;
 static struct Sprite *spr_enemy_01 = NULL;
 static struct Sprite *spr_asteroid_01 = NULL;
@@ -26,10 +63,17 @@ static struct Font *font_hud = NULL;
 static struct Text *fps_text = NULL;
 static struct Text *render_time_text = NULL;
 static struct Text *credits_text = NULL;
+static struct Text *rollback_text = NULL;
 static struct Widget *hp_bar = NULL;
 static struct Widget *hp_bar_bg = NULL;
 static struct Texture *tex_hp_bar_green = NULL;
 static struct Texture *tex_hp_bar_bg = NULL;
+static struct Hud *hud = NULL;
+static struct HudNode *fps_node = NULL;
+static struct HudNode *render_time_node = NULL;
+static struct HudNode *rollback_node = NULL;
+static struct HudNode *credits_node = NULL;
+static struct HudNode *hp_bar_node = NULL;
 
 // TEXTURES
 static const struct TextureRes {
@@ -53,6 +97,14 @@ static const struct {
 	{ NULL }
 };
 
+// ENTITY SPRITES
+static struct Sprite **entity_sprites[SPRITE_COUNT] = {
+	[SPRITE_PLAYER] = &spr_player,
+	[SPRITE_ENEMY] = &spr_enemy_01,
+	[SPRITE_ASTEROID] = &spr_asteroid_01,
+	[SPRITE_PROJECTILE] = &spr_projectile_01,
+};
+
 // FONTS
 static const struct {
 	const char *file;
@@ -81,16 +133,18 @@ load_resources(void)
 		printf("loaded texure `%s`\n", res.file);
 	}
 
-	// load sprites
-	for (unsigned i = 0; sprites[i].file != NULL; i++) {
-		if (!(*sprites[i].var = sprite_from_file(sprites[i].file))) {
-			fprintf(
-				stderr,
-				"failed to load sprite `%s`\n",
-				sprites[i].file
-			);
-			return 0;
-		}
+	// load sprites all at once, for same size ones to share textures
+	const size_t sprite_count = sizeof(sprites) / sizeof(sprites[0]) - 1;
+	const char *sprite_files[sprite_count];
+	for (unsigned i = 0; i < sprite_count; i++) {
+		sprite_files[i] = sprites[i].file;
+	}
+	if (!(sprite_set = sprite_set_from_files(sprite_files, sprite_count))) {
+		fprintf(stderr, "failed to load sprites\n");
+		return 0;
+	}
+	for (unsigned i = 0; i < sprite_count; i++) {
+		*sprites[i].var = sprite_set_get(sprite_set, i);
 		printf("loaded sprite `%s`\n", sprites[i].file);
 	}
 
@@ -111,7 +165,8 @@ load_resources(void)
 	fps_text = text_new(font_dbg);
 	render_time_text = text_new(font_dbg);
 	credits_text = text_new(font_hud);
-	if (!fps_text || !render_time_text || !credits_text) {
+	rollback_text = text_new(font_dbg);
+	if (!fps_text || !render_time_text || !credits_text || !rollback_text) {
 		return 0;
 	}
 
@@ -136,17 +191,36 @@ load_resources(void)
 	hp_bar_bg->border.left = 6;
 	hp_bar_bg->border.right = 6;
 
+	// lay out the HUD
+	if (!(hud = hud_new(SCREEN_WIDTH, SCREEN_HEIGHT))) {
+		return 0;
+	}
+	fps_node = hud_add_text(hud, NULL, fps_text, 0, 60);
+	render_time_node = hud_add_text(hud, NULL, render_time_text, 0, 80);
+	rollback_node = hud_add_text(hud, NULL, rollback_text, 0, 100);
+	credits_node = hud_add_text(hud, NULL, credits_text, SCREEN_WIDTH - 150, 20);
+	struct HudNode *hp_bar_bg_node = hud_add_widget(
+		hud,
+		NULL,
+		hp_bar_bg,
+		20,
+		25 - hp_bar_bg->height / 2
+	);
+	hp_bar_node = hud_add_widget(hud, hp_bar_bg_node, hp_bar, 0, 0);
+
 	return 1;
 }
 
 static void
 cleanup_resources(void)
 {
+	hud_destroy(hud);
 	widget_destroy(hp_bar_bg);
 	widget_destroy(hp_bar);
 	text_destroy(fps_text);
 	text_destroy(render_time_text);
 	text_destroy(credits_text);
+	text_destroy(rollback_text);
 
 	// destroy fonts
 	for (unsigned i = 0; fonts[i].file; i++) {
@@ -154,9 +228,7 @@ cleanup_resources(void)
 	}
 
 	// destroy sprites
-	for (unsigned i = 0; sprites[i].file; i++) {
-		sprite_destroy(*sprites[i].var);
-	}
+	sprite_set_destroy(sprite_set);
 
 	// destroy textures
 	for (unsigned i = 0; textures[i].file; i++) {
@@ -165,123 +237,219 @@ cleanup_resources(void)
 }
 
 static void
-render_world(struct RenderList *rndr_list, struct World *world)
+render_world(struct RenderList *rndr_list, const struct WorldFrame *frame)
 {
-	render_list_add_sprite(
-		rndr_list,
-		spr_player,
-		world->player.x,
-		world->player.y,
-		0.0f
-	);
-
-	struct ListNode *ast_node = world->asteroid_list->head;
-	while (ast_node) {
-		struct Asteroid *ast = ast_node->data;
+	for (size_t i = 0; i < frame->renderable_count; i++) {
+		const struct Renderable *r = &frame->renderables[i];
 		render_list_add_sprite(
 			rndr_list,
-			spr_asteroid_01,
-			ast->x,
-			ast->y,
-			ast->rot
+			*entity_sprites[r->sprite],
+			r->x,
+			r->y,
+			r->rot
 		);
-		ast_node = ast_node->next;
-	}
-
-	struct ListNode *prj_node = world->projectile_list->head;
-	while (prj_node) {
-		struct Projectile *prj = prj_node->data;
-		if (prj->ttl > 0) {
-			render_list_add_sprite(
-				rndr_list,
-				spr_projectile_01,
-				prj->x,
-				prj->y,
-				0
-			);
-		}
-		prj_node = prj_node->next;
 	}
+}
 
-	struct ListNode *enemy_node = world->enemy_list->head;
-	while (enemy_node) {
-		struct Enemy *enemy = enemy_node->data;
-		render_list_add_sprite(
-			rndr_list,
-			spr_enemy_01,
-			enemy->x,
-			enemy->y,
-			0
-		);
-		enemy_node = enemy_node->next;
+static int
+key_action(const SDL_Event *key_evt)
+{
+	switch (key_evt->key.keysym.sym) {
+	case SDLK_a:
+	case SDLK_LEFT:
+		return ACTION_MOVE_LEFT;
+	case SDLK_d:
+	case SDLK_RIGHT:
+		return ACTION_MOVE_RIGHT;
+	case SDLK_SPACE:
+		return ACTION_SHOOT;
 	}
+	return 0;
 }
 
-static void
-render_ui(struct RenderList *rndr_list)
-{
-	// render FPS indicator
-	render_list_add_text(
-		rndr_list,
-		fps_text,
-		-SCREEN_WIDTH / 2,
-		-SCREEN_HEIGHT / 2 + 60
-	);
+static int
+handle_key(
+	const SDL_Event *key_evt,
+	struct World *world,
+	Uint32 frame_ticks,
+	float dt
+) {
+	// handle player actions
+	int act = key_action(key_evt);
+	if (!act || key_evt->key.repeat) {
+		return 1;
+	}
 
-	// render render time indicator
-	render_list_add_text(
-		rndr_list,
-		render_time_text,
-		-SCREEN_WIDTH / 2,
-		-SCREEN_HEIGHT / 2 + 80
-	);
+	// events polled in this frame happened after the previous frame
+	// started, which is where the upcoming world update begins, thus, the
+	// offset from it maps the event to world time
+	float offset = (Sint32)(key_evt->key.timestamp - frame_ticks) / 1000.0f;
+	if (offset < 0) {
+		offset = 0;
+	} else if (offset > dt) {
+		offset = dt;
+	}
 
-	// render credits counter
-	render_list_add_text(
-		rndr_list,
-		credits_text,
-		SCREEN_WIDTH / 2 - 150,
-		-SCREEN_HEIGHT / 2 + 20
+	world_push_input(
+		world,
+		world->time + offset,
+		act,
+		key_evt->type == SDL_KEYDOWN
 	);
+	return 1;
+}
 
-	// render hitpoints widget
-	render_list_add_widget(
-		rndr_list,
-		hp_bar_bg,
-		20,
-		25 - hp_bar_bg->height / 2
-	);
-	render_list_add_widget(
-		rndr_list,
-		hp_bar,
-		20,
-		25 - hp_bar->height / 2
+/**
+ * Create the world and start simulating it.
+ *
+ * If `r_sim_thread` is NULL, the world is left to be simulated by the caller.
+ * Co-op games seed the script with `COOP_SEED`, for both peers to spawn the
+ * same, whatever C library they run on. Whatever has been created is
+ * returned even on failure, for the caller to clean up.
+ */
+static int
+start_local_game(
+	struct World **r_world,
+	struct ScriptEnv **r_env,
+	struct SimThread **r_sim_thread,
+	int coop
+) {
+	// create Lua script environment
+	if (!(*r_env = script_env_new())) {
+		return 0;
+	}
+
+	if (!(*r_world = world_new())) {
+		return 0;
+	}
+
+	// initialize script environment and perform initial tick
+	if (!script_env_init(*r_env, *r_world)) {
+		return 0;
+	}
+	if (coop) {
+		script_env_seed(*r_env, COOP_SEED);
+	}
+	if (!script_env_load_file(*r_env, "data/scripts/game.lua") ||
+	    !script_env_tick(*r_env)) {
+		return 0;
+	}
+
+	if (!r_sim_thread) {
+		return 1;
+	}
+
+	// start simulating on a separate thread and extract the initial frame
+	if (!(*r_sim_thread = sim_thread_new(*r_world, *r_env))) {
+		return 0;
+	}
+	sim_thread_kick(*r_sim_thread, 0);
+	return 1;
+}
+
+static void
+usage(const char *prog)
+{
+	fprintf(
+		stderr,
+		"usage: %s [--vsync | --adaptive-vsync | --unlimited | --fps N]\n"
+		"       [--mipmaps] [--gpu-budget MS]\n"
+		"       [--capture PREFIX | --capture-raw PREFIX]\n"
+		"       [--headless] [--frames N]\n"
+		"       [--server [PORT] | --connect HOST:PORT]\n"
+		"       [--peer HOST:PORT [--port PORT] [--player 0|1]]\n"
+		"       [--net-loss P] [--net-latency MS] [--net-jitter MS]\n",
+		prog
 	);
 }
 
 static int
-handle_key(const SDL_Event *key_evt, struct World *world)
+parse_args(int argc, char *argv[], struct Options *opts)
 {
-	// handle player actions
-	int act = 0;
-	switch (key_evt->key.keysym.sym) {
-	case SDLK_a:
-	case SDLK_LEFT:
-		act = ACTION_MOVE_LEFT;
-		break;
-	case SDLK_d:
-	case SDLK_RIGHT:
-		act = ACTION_MOVE_RIGHT;
-		break;
-	case SDLK_SPACE:
-		act = ACTION_SHOOT;
-		break;
+	memset(opts, 0, sizeof(struct Options));
+	opts->pace_mode = PACE_MODE_ADAPTIVE_VSYNC;
+	opts->fps = DEFAULT_FPS;
+	opts->gpu_budget = -1;
+	opts->port = DEFAULT_PORT;
+
+	for (int i = 1; i < argc; i++) {
+		int has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--vsync") == 0) {
+			opts->pace_mode = PACE_MODE_VSYNC;
+		} else if (strcmp(argv[i], "--adaptive-vsync") == 0) {
+			opts->pace_mode = PACE_MODE_ADAPTIVE_VSYNC;
+		} else if (strcmp(argv[i], "--unlimited") == 0) {
+			opts->pace_mode = PACE_MODE_UNLIMITED;
+		} else if (strcmp(argv[i], "--fps") == 0 && has_value) {
+			opts->pace_mode = PACE_MODE_FIXED;
+			opts->fps = atof(argv[++i]);
+			if (opts->fps <= 0) {
+				fprintf(stderr, "bad frame rate `%s`\n", argv[i]);
+				return 0;
+			}
+		} else if (strcmp(argv[i], "--mipmaps") == 0) {
+			opts->texture_filter = TEXTURE_FILTER_TRILINEAR;
+		} else if (strcmp(argv[i], "--gpu-budget") == 0 && has_value) {
+			opts->gpu_budget = atof(argv[++i]) / 1000.0f;
+			if (opts->gpu_budget < 0) {
+				fprintf(stderr, "bad GPU budget `%s`\n", argv[i]);
+				return 0;
+			}
+		} else if (strcmp(argv[i], "--capture") == 0 && has_value) {
+			opts->capture = argv[++i];
+			opts->capture_format = CAPTURE_FORMAT_PNG;
+		} else if (strcmp(argv[i], "--capture-raw") == 0 && has_value) {
+			opts->capture = argv[++i];
+			opts->capture_format = CAPTURE_FORMAT_RAW;
+		} else if (strcmp(argv[i], "--headless") == 0) {
+			opts->headless = 1;
+		} else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+			opts->frames = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--server") == 0) {
+			opts->server = 1;
+			if (has_value && argv[i + 1][0] != '-') {
+				int port = atoi(argv[++i]);
+				if (port <= 0 || port > 65535) {
+					fprintf(stderr, "bad port `%s`\n", argv[i]);
+					return 0;
+				}
+				opts->port = port;
+			}
+		} else if (strcmp(argv[i], "--connect") == 0 && has_value) {
+			opts->connect = argv[++i];
+		} else if (strcmp(argv[i], "--peer") == 0 && has_value) {
+			opts->peer = argv[++i];
+		} else if (strcmp(argv[i], "--port") == 0 && has_value) {
+			int port = atoi(argv[++i]);
+			if (port <= 0 || port > 65535) {
+				fprintf(stderr, "bad port `%s`\n", argv[i]);
+				return 0;
+			}
+			opts->port = port;
+		} else if (strcmp(argv[i], "--player") == 0 && has_value) {
+			opts->player = atoi(argv[++i]);
+			if (opts->player < 0 || opts->player >= ROLLBACK_PLAYERS) {
+				fprintf(stderr, "bad player `%s`\n", argv[i]);
+				return 0;
+			}
+		} else if (strcmp(argv[i], "--net-loss") == 0 && has_value) {
+			opts->net.loss = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--net-latency") == 0 && has_value) {
+			opts->net.latency = atof(argv[++i]) / 1000.0f;
+		} else if (strcmp(argv[i], "--net-jitter") == 0 && has_value) {
+			opts->net.jitter = atof(argv[++i]) / 1000.0f;
+		} else {
+			usage(argv[0]);
+			return 0;
+		}
 	}
 
-	if (key_evt->type == SDL_KEYUP) {
-		world->player.actions &= ~act;
-	} else {
-		world->player.actions |= act;
+	// there's no display to synchronize with when headless
+	if (opts->headless && (
+		opts->pace_mode == PACE_MODE_VSYNC ||
+		opts->pace_mode == PACE_MODE_ADAPTIVE_VSYNC
+	)) {
+		opts->pace_mode = PACE_MODE_UNLIMITED;
 	}
 	return 1;
 }
@@ -291,52 +459,140 @@ main(int argc, char *argv[])
 {
 	int ok = 1;
 	struct World *world = NULL;
+	struct SimThread *sim_thread = NULL;
+	struct NetClient *client = NULL;
+	struct Rollback *rollback = NULL;
+	struct WorldFrame coop_frame = { 0 };
+	struct ScriptEnv *env = NULL;
+	struct DynRes *dynres = NULL;
+	struct Capture *capture = NULL;
+
+	struct Options opts;
+	if (!parse_args(argc, argv, &opts)) {
+		return EXIT_FAILURE;
+	}
+
+	// headless server needs neither a window nor resources
+	if (opts.server) {
+		ok = server_run(opts.port, &opts.net) && !error_is_set();
+		if (!ok) {
+			error_dump(stdout);
+		}
+		return !ok;
+	}
 
 	// initialize renderer
-	if (!renderer_init(SCREEN_WIDTH, SCREEN_HEIGHT)) {
+	if (!(opts.headless ?
+	      renderer_init_headless(SCREEN_WIDTH, SCREEN_HEIGHT) :
+	      renderer_init(SCREEN_WIDTH, SCREEN_HEIGHT))) {
+		return EXIT_FAILURE;
+	}
+
+	// initialize frame pacing; vsync modes pace to the display, whose
+	// refresh rate is assumed to be the default one if it can't be told
+	float fps = opts.fps;
+	if (opts.pace_mode == PACE_MODE_VSYNC ||
+	    opts.pace_mode == PACE_MODE_ADAPTIVE_VSYNC) {
+		float refresh_rate = renderer_get_refresh_rate();
+		fps = refresh_rate > 0 ? refresh_rate : DEFAULT_FPS;
+	}
+	struct FramePacer pacer;
+	if (!pacer_init(&pacer, opts.pace_mode, fps)) {
+		renderer_shutdown();
 		return EXIT_FAILURE;
 	}
 
 	// create a render list
 	struct RenderList *rndr_list = render_list_new();
 
-	// create Lua script environment
-	struct ScriptEnv *env = script_env_new();
-	if (!env) {
-		ok = 0;
+	texture_set_filter(opts.texture_filter);
+	if (!(ok = load_resources())) {
 		goto cleanup;
 	}
 
-	if (!(ok = load_resources())) {
+	// render the world at the resolution the GPU can afford, by default in
+	// a share of the frame, as long as the pacer makes it
+	float gpu_budget = opts.gpu_budget;
+	if (gpu_budget < 0) {
+		gpu_budget = GPU_BUDGET_SHARE * pacer.period;
+	}
+	if (gpu_budget > 0 && !(dynres = dynres_new(
+		SCREEN_WIDTH,
+		SCREEN_HEIGHT,
+		gpu_budget,
+		MIN_RESOLUTION_SCALE
+	))) {
+		ok = 0;
 		goto cleanup;
 	}
 
-	if (!(world = world_new())) {
+	if (opts.capture && !(capture = capture_new(
+		SCREEN_WIDTH,
+		SCREEN_HEIGHT,
+		opts.capture,
+		opts.capture_format
+	))) {
 		ok = 0;
 		goto cleanup;
 	}
 
-	// initialize script environment and perform initial tick
-	if (!script_env_init(env, world) ||
-	    !script_env_load_file(env, "data/scripts/game.lua") ||
-	    !script_env_tick(env)) {
+	if (opts.connect) {
+		// remote games are simulated by the server
+		if (!(client = net_client_new(opts.connect, &opts.net))) {
+			ok = 0;
+			goto cleanup;
+		}
+	} else if (opts.peer) {
+		// co-op games are simulated in lockstep on both peers
+		if (!start_local_game(&world, &env, NULL, 1) ||
+		    !(rollback = rollback_new(
+				world,
+				env,
+				opts.player,
+				opts.port,
+				opts.peer,
+				&opts.net
+		    ))) {
+			ok = 0;
+			goto cleanup;
+		}
+	} else if (!start_local_game(&world, &env, &sim_thread, 0)) {
 		ok = 0;
 		goto cleanup;
 	}
 
 	int run = 1;
-	Uint32 last_update = SDL_GetTicks();
-	float tick = 0, time_acc = 0;
-	unsigned frame_count = 0, current_credits;
+	int actions = 0;
+	struct Clock clock;
+	clock_init(&clock);
+	Uint32 frame_ticks = SDL_GetTicks();
+	float time_acc = 0;
+	unsigned frame_count = 0;
+	unsigned long missed_frames = 0;
+	float sim_acc = 0;
+	float scroll = 0;
+	double render_total = 0;
 	while (ok && run) {
 		// compute timers and counters
-		Uint32 now = SDL_GetTicks();
-		float dt = (now - last_update) / 1000.0f;
-		last_update = now;
-		tick += dt;
+		float dt = clock_tick(&clock);
+		Uint32 last_frame_ticks = frame_ticks;
+		frame_ticks = SDL_GetTicks();
 		time_acc += dt;
 		frame_count++;
 
+		// wait for the simulation of this frame, which ran while the
+		// previous one was being rendered, or for the remote one
+		const struct WorldFrame *frame;
+		if (client) {
+			ok &= net_client_update(client, dt, actions, &frame);
+		} else if (rollback) {
+			frame = &coop_frame;
+		} else {
+			int running;
+			ok &= sim_thread_wait(sim_thread, &running, &frame);
+			run &= running;
+		}
+
 		// handle input
 		SDL_Event evt;
 		while (SDL_PollEvent(&evt)) {
@@ -346,57 +602,145 @@ main(int argc, char *argv[])
 				case SDLK_ESCAPE:
 					run = 0;
 				}
-				run &= handle_key(&evt, world);
+				if (client || rollback) {
+					int act = key_action(&evt);
+					if (evt.type == SDL_KEYDOWN) {
+						actions |= act;
+					} else {
+						actions &= ~act;
+					}
+				} else {
+					run &= handle_key(
+						&evt,
+						world,
+						last_frame_ticks,
+						dt
+					);
+				}
 			} else if (evt.type == SDL_QUIT) {
 				run = 0;
 			}
 		}
 
-		// update the world
-		run &= world_update(world, dt);
-
-		// update credits text
-		if (world->player.credits != current_credits) {
-			current_credits = world->player.credits;
-			text_set_fmt(credits_text, "Credits: %d$", current_credits);
+		// start simulating the next frame
+		if (sim_thread && ok && run) {
+			sim_thread_kick(sim_thread, dt);
 		}
 
-		// update hitpoints widget
-		hp_bar->width = 200.0 * world->player.hitpoints / PLAYER_INITIAL_HITPOINTS;
-
-		// notify script environment
-		while (tick >= TICK) {
-			tick -= TICK;
-			ok &= script_env_tick(env);
+		// advance the co-op session as far as the peer allows, without
+		// falling more than the rollback window behind
+		if (rollback && ok && run) {
+			sim_acc += dt;
+			if (sim_acc > SIMULATION_STEP * ROLLBACK_MAX_FRAMES) {
+				sim_acc = SIMULATION_STEP * ROLLBACK_MAX_FRAMES;
+			}
+			ok &= rollback_poll(rollback);
+			while (ok && run && sim_acc >= SIMULATION_STEP &&
+			       rollback_can_advance(rollback)) {
+				int running;
+				ok &= rollback_advance(rollback, actions, &running);
+				run &= running;
+				sim_acc -= SIMULATION_STEP;
+			}
+			ok &= world_extract(world, &coop_frame);
 		}
 
+		// update the HUD, which is rendered anew only if it changes
+		ok &= hud_set_text_fmt(hud, credits_node, "Credits: %d$", frame->credits);
+		float hitpoints = frame->hitpoints > 0 ? frame->hitpoints : 0;
+		hud_set_size(
+			hud,
+			hp_bar_node,
+			hp_bar_bg->width * hitpoints / PLAYER_INITIAL_HITPOINTS,
+			hp_bar->height
+		);
+
 		// render!
-		now = SDL_GetTicks();
+		double render_start = clock_now();
 		renderer_clear();
-		render_world(rndr_list, world);
-		render_ui(rndr_list);
-		render_list_exec(rndr_list);
+		scroll += dt * STARFIELD_SPEED;
+		render_list_add_starfield(rndr_list, scroll);
+		render_world(rndr_list, frame);
+		if (dynres) {
+			ok &= dynres_render(dynres, rndr_list);
+		} else {
+			ok &= render_list_exec(rndr_list);
+		}
+		ok &= hud_render(hud);
+		if (capture) {
+			ok &= capture_frame(capture);
+		}
 		renderer_present();
-		Uint32 render_time = SDL_GetTicks() - now;
+		double render_time = clock_now() - render_start;
+		render_total += render_time;
+
+		// wait for the next frame
+		pacer_end_frame(&pacer);
+		if (opts.frames && pacer.frames >= opts.frames) {
+			run = 0;
+		}
 
 		// each second, update the stats
 		if (time_acc >= 1.0) {
 			time_acc -= 1.0;
 
-			// update fps
-			text_set_fmt(fps_text, "FPS: %d", frame_count);
+			// update fps and the number of frames which missed their
+			// deadline during the last second
+			ok &= hud_set_text_fmt(
+				hud,
+				fps_node,
+				"FPS: %d (%lu missed)",
+				frame_count,
+				pacer.missed - missed_frames
+			);
 			frame_count = 0;
+			missed_frames = pacer.missed;
 
 			// update render time
-			text_set_fmt(
-				render_time_text,
-				"Render time: %dms",
-				render_time
+			ok &= hud_set_text_fmt(
+				hud,
+				render_time_node,
+				"Render time: %.2fms (%.0f%% resolution)",
+				render_time * 1000.0,
+				dynres ? dynres_get_scale(dynres) * 100.0 : 100.0
 			);
+
+			// update rollback stats, with the number of frames which
+			// can be simulated again within a 16ms budget
+			if (rollback) {
+				struct RollbackStats stats;
+				rollback_get_stats(rollback, &stats);
+				double per_frame = stats.resimulated ?
+					stats.resim_time / stats.resimulated :
+					0;
+				ok &= hud_set_text_fmt(
+					hud,
+					rollback_node,
+					"Rollbacks: %lu (%lu frames, %.0f per 16ms)",
+					stats.rollbacks,
+					stats.resimulated,
+					per_frame > 0 ? 0.016 / per_frame : 0.0
+				);
+			}
 		}
 	}
 
+	// summarize, for benchmarks
+	if ((opts.frames || opts.headless) && pacer.frames > 0) {
+		printf(
+			"rendered %lu frames, %.2fms per frame\n",
+			pacer.frames,
+			render_total * 1000.0 / pacer.frames
+		);
+	}
+
 cleanup:
+	capture_destroy(capture);
+	dynres_destroy(dynres);
+	net_client_destroy(client);
+	rollback_destroy(rollback);
+	world_frame_release(&coop_frame);
+	sim_thread_destroy(sim_thread);
 	script_env_destroy(env);
 	world_destroy(world);
 	cleanup_resources();
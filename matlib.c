@@ -8,6 +8,20 @@
 # include <cblas.h>
 #endif
 
+void
+fast_sincos_batch(const float *angles, float *r_sin, float *r_cos, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		fast_sincos_poly(angles[i], &r_sin[i], &r_cos[i]);
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (!(fabsf(angles[i]) <= 8192.0f)) {
+			r_sin[i] = sinf(angles[i]);
+			r_cos[i] = cosf(angles[i]);
+		}
+	}
+}
+
 void
 mat_mul(const Mat *a, const Mat *b, Mat *r)
 {
@@ -71,9 +85,9 @@ mat_rotatev(Mat *m, const Vec *v, float angle)
 	const float x = v->data[0];
 	const float y = v->data[1];
 	const float z = v->data[2];
-	const float sin_a = sin(angle);
-	const float cos_a = cos(angle);
-	const float k = 1 - cos(angle);
+	const float sin_a = sinf(angle);
+	const float cos_a = cosf(angle);
+	const float k = 1 - cos_a;
 
 	rm.data[0] = cos_a + k * x * x;
 	rm.data[1] = k * x * y - z * sin_a;
@@ -136,19 +150,18 @@ mat_get_scale(const Mat *m)
 Vec
 mat_get_translation(const Mat *m)
 {
-	Vec o = vec(0, 0, 0, 1);
-	Vec pos, result;
-	mat_mulv(m, &o, &pos);
-	vec_mulf(&pos, -1.0f, &result);
-	return result;
+	return vec(m->data[3], m->data[7], m->data[11], 0);
 }
 
 Qtr
 mat_get_rotation(const Mat *m)
 {
 	const float *mat = m->data;
+	// the trace-based formula loses precision as the rotation angle nears
+	// 180 degrees; once the trace turns negative, beyond 120 degrees, the
+	// largest diagonal element is used instead
 	float t = 1 + mat[0] + mat[5] + mat[10], s, x, y, z, w;
-	if (fabs(t) > 0.00000001) {
+	if (t > 1) {
 		s = sqrt(t) * 2;
 		x = (mat[9] - mat[6]) / s;
 		y = (mat[2] - mat[8]) / s;
@@ -339,9 +352,11 @@ mat_inverse(Mat *m, Mat *out_m)
 void
 mat_transpose(Mat *m, Mat *out_m)
 {
+	// copy first, the result may be the matrix itself
+	Mat tmp = *m;
 	for (short i = 0; i < 4; i++) {
 		for (short j = 0; j < 4; j++) {
-			out_m->data[i * 4 + j] = m->data[j * 4 + i];
+			out_m->data[i * 4 + j] = tmp.data[j * 4 + i];
 		}
 	}
 }
@@ -412,7 +427,7 @@ void
 mat_persp(Mat *m, float fovy, float aspect, float n, float f)
 {
 	fovy = M_PI / 180.0 * fovy;
-	float y = 1.0 / (fovy / 2.0);
+	float y = 1.0 / tan(fovy / 2.0);
 	float x = y / aspect;
 	float z = (f + n) / (n - f);
 	float tz = (2 * f * n) / (n - f);
@@ -523,8 +538,11 @@ vec_mag(const Vec *v)
 void
 vec_norm(Vec *v)
 {
-	vec_mulf(v, 1.0f / vec_mag(v), v);
-
+	// zero vectors have no direction and are left as they are
+	float mag = vec_mag(v);
+	if (mag > 0) {
+		vec_mulf(v, 1.0f / mag, v);
+	}
 }
 
 void
@@ -554,6 +572,40 @@ vec_lerp(const Vec *a, const Vec *b, float t, Vec *r_v)
 	vec_add(&at, &bt, r_v);
 }
 
+void
+vec2_madd_batch(Vec2 *v, const Vec2 *d, float scalar, size_t count)
+{
+	// treated as flat float arrays, which compilers vectorize readily
+	float *out = (float*)v;
+	const float *in = (const float*)d;
+	for (size_t i = 0; i < count * 2; i++) {
+		out[i] += in[i] * scalar;
+	}
+}
+
+void
+affine2_apply_batch(const Affine2 *m, const Vec2 *v, Vec2 *r_v, size_t count)
+{
+	const float a = m->data[0], b = m->data[1], tx = m->data[2];
+	const float c = m->data[3], d = m->data[4], ty = m->data[5];
+	for (size_t i = 0; i < count; i++) {
+		float x = v[i].x, y = v[i].y;
+		r_v[i].x = a * x + b * y + tx;
+		r_v[i].y = c * x + d * y + ty;
+	}
+}
+
+void
+affine2_to_mat(const Affine2 *m, Mat *r_m)
+{
+	const float *a = m->data;
+	*r_m = (Mat){{
+		a[0], a[1], 0, a[2],
+		a[3], a[4], 0, a[5],
+		0,    0,    1, 0,
+		0,    0,    0, 1
+	}};
+}
 
 Qtr
 qtr(float w, float x, float y, float z)
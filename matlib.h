@@ -1,6 +1,8 @@
 #pragma once
 
 #include <math.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifndef M_PI
 # define M_PI 3.14159265358979323846
@@ -9,8 +11,107 @@
 typedef struct Vec Vec;
 typedef struct Mat Mat;
 typedef struct Qtr Qtr;
+typedef struct Vec2 Vec2;
+typedef struct Affine2 Affine2;
 
 
+/*******************************************************************************
+ * Fast trigonometry.
+*******************************************************************************/
+
+/**
+ * Sine and cosine of an angle in radians, for |angle| <= 8192.
+ *
+ * The angle is reduced to [-pi/4, pi/4] around the nearest multiple of pi/2
+ * and both functions are evaluated there as minimax polynomials, with an
+ * absolute error below 2e-7. There are no branches, thus, loops over it
+ * vectorize; beyond the bound, where the reduction would lose precision,
+ * results are meaningless, but defined.
+ */
+static inline void
+fast_sincos_poly(float angle, float *r_sin, float *r_cos)
+{
+	// pi/2 split into parts whose products with the quadrant are exact
+	const float pio2_1 = 1.5703125f;
+	const float pio2_2 = 4.837512969970703125e-4f;
+	const float pio2_3 = 7.54978995489188216e-8f;
+
+	// round to the nearest quadrant by adding 1.5 * 2^23, which leaves it
+	// in the low bits of the mantissa; unlike a conversion to int, which
+	// doesn't vectorize once clamped, it's defined for any angle
+	union { float f; uint32_t i; } q = {
+		angle * (float)(2 / M_PI) + 12582912.0f
+	};
+	float k = q.f - 12582912.0f;
+	int quadrant = q.i & 3;
+	float r = ((angle - k * pio2_1) - k * pio2_2) - k * pio2_3;
+	float r2 = r * r;
+
+	float s = r + r * r2 * (
+		-1.6666654611e-1f +
+		r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f)
+	);
+	float c = 1.0f - 0.5f * r2 + r2 * r2 * (
+		4.166664568298827e-2f +
+		r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f)
+	);
+
+	// map back to the quadrant, blending rather than selecting, which GCC
+	// doesn't vectorize; either term is zero, thus, it's exact
+	float odd = quadrant & 1;
+	float qs = s * (1 - odd) + c * odd;
+	float qc = c * (1 - odd) + s * odd;
+	*r_sin = qs * (1 - (quadrant & 2));
+	*r_cos = qc * (1 - ((quadrant + 1) & 2));
+}
+
+/**
+ * Sine and cosine of an angle in radians.
+ *
+ * Evaluated by `fast_sincos_poly()` for |angle| <= 8192 and by libm
+ * otherwise, as well as for infinities and NaNs. A single call is no faster
+ * than libm; it pays off only in loops which vectorize, see
+ * `fast_sincos_batch()`.
+ */
+static inline void
+fast_sincos(float angle, float *r_sin, float *r_cos)
+{
+	// negated, for NaNs to take this branch too
+	if (!(fabsf(angle) <= 8192.0f)) {
+		*r_sin = sinf(angle);
+		*r_cos = cosf(angle);
+		return;
+	}
+	fast_sincos_poly(angle, r_sin, r_cos);
+}
+
+static inline float
+fast_sin(float angle)
+{
+	float s, c;
+	fast_sincos(angle, &s, &c);
+	return s;
+}
+
+static inline float
+fast_cos(float angle)
+{
+	float s, c;
+	fast_sincos(angle, &s, &c);
+	return c;
+}
+
+/**
+ * Sine and cosine of `count` angles.
+ *
+ * All angles are evaluated by `fast_sincos_poly()` in one loop, and those
+ * beyond its bound are redone by libm in another, thus, results must not
+ * overlap the angles. The first loop vectorizes at -O3, where it's about
+ * twice as fast as libm; the default, unoptimized build is slower than libm.
+ */
+void
+fast_sincos_batch(const float *angles, float *r_sin, float *r_cos, size_t count);
+
 /*******************************************************************************
  * Matrix type and matrix operations.
 *******************************************************************************/
@@ -149,6 +250,162 @@ vec_clamp(Vec *v, float value);
 void
 vec_lerp(const Vec *a, const Vec *b, float t, Vec *r_v);
 
+/*******************************************************************************
+ * 2D vector type and 2D vector operations.
+*******************************************************************************/
+
+/**
+ * Vec2 - 2D vector.
+ *
+ * Small enough to be passed and returned by value.
+ */
+struct Vec2 {
+	float x, y;
+};
+
+static inline Vec2
+vec2(float x, float y)
+{
+	Vec2 v = { x, y };
+	return v;
+}
+
+static inline Vec2
+vec2_add(Vec2 a, Vec2 b)
+{
+	return vec2(a.x + b.x, a.y + b.y);
+}
+
+static inline Vec2
+vec2_sub(Vec2 a, Vec2 b)
+{
+	return vec2(a.x - b.x, a.y - b.y);
+}
+
+static inline Vec2
+vec2_mulf(Vec2 v, float scalar)
+{
+	return vec2(v.x * scalar, v.y * scalar);
+}
+
+static inline float
+vec2_dot(Vec2 a, Vec2 b)
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+static inline float
+vec2_mag(Vec2 v)
+{
+	return sqrtf(vec2_dot(v, v));
+}
+
+static inline Vec2
+vec2_lerp(Vec2 a, Vec2 b, float t)
+{
+	return vec2(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
+}
+
+/**
+ * Add `scalar` multiples of `d` to each of `count` vectors, e.g. velocities
+ * times the time step to positions.
+ */
+void
+vec2_madd_batch(Vec2 *v, const Vec2 *d, float scalar, size_t count);
+
+/*******************************************************************************
+ * 2D affine transform type and operations.
+*******************************************************************************/
+
+/**
+ * Affine2 - 2x3 affine transform.
+ *
+ * Row-major like `Mat`, with the translation in the last column:
+ *
+ *     | data[0] data[1] data[2] |
+ *     | data[3] data[4] data[5] |
+ *
+ * Operations compose the new transform on the right, thus, it is applied to
+ * points first. Converted to `Mat` only when handed to the GPU.
+ */
+struct Affine2 {
+	float data[6];
+};
+
+static inline void
+affine2_ident(Affine2 *m)
+{
+	m->data[0] = 1; m->data[1] = 0; m->data[2] = 0;
+	m->data[3] = 0; m->data[4] = 1; m->data[5] = 0;
+}
+
+static inline void
+affine2_mul(const Affine2 *a, const Affine2 *b, Affine2 *r_m)
+{
+	const float *x = a->data, *y = b->data;
+	float *r = r_m->data;
+	r[0] = x[0] * y[0] + x[1] * y[3];
+	r[1] = x[0] * y[1] + x[1] * y[4];
+	r[2] = x[0] * y[2] + x[1] * y[5] + x[2];
+	r[3] = x[3] * y[0] + x[4] * y[3];
+	r[4] = x[3] * y[1] + x[4] * y[4];
+	r[5] = x[3] * y[2] + x[4] * y[5] + x[5];
+}
+
+static inline void
+affine2_translate(Affine2 *m, float tx, float ty)
+{
+	m->data[2] += m->data[0] * tx + m->data[1] * ty;
+	m->data[5] += m->data[3] * tx + m->data[4] * ty;
+}
+
+/**
+ * Rotate counter-clockwise by given angle, given as its sine and cosine.
+ */
+static inline void
+affine2_rotate_sc(Affine2 *m, float sin_a, float cos_a)
+{
+	float a = m->data[0], b = m->data[1], c = m->data[3], d = m->data[4];
+	m->data[0] = a * cos_a + b * sin_a;
+	m->data[1] = b * cos_a - a * sin_a;
+	m->data[3] = c * cos_a + d * sin_a;
+	m->data[4] = d * cos_a - c * sin_a;
+}
+
+static inline void
+affine2_rotate(Affine2 *m, float angle)
+{
+	affine2_rotate_sc(m, sinf(angle), cosf(angle));
+}
+
+static inline void
+affine2_scale(Affine2 *m, float sx, float sy)
+{
+	m->data[0] *= sx; m->data[1] *= sy;
+	m->data[3] *= sx; m->data[4] *= sy;
+}
+
+static inline Vec2
+affine2_apply(const Affine2 *m, Vec2 v)
+{
+	return vec2(
+		m->data[0] * v.x + m->data[1] * v.y + m->data[2],
+		m->data[3] * v.x + m->data[4] * v.y + m->data[5]
+	);
+}
+
+/**
+ * Transform `count` points.
+ */
+void
+affine2_apply_batch(const Affine2 *m, const Vec2 *v, Vec2 *r_v, size_t count);
+
+/**
+ * Expand to a 4x4 matrix acting on the XY plane.
+ */
+void
+affine2_to_mat(const Affine2 *m, Mat *r_m);
+
 /*******************************************************************************
  * Quaternion type and quaternion operations
 *******************************************************************************/
@@ -0,0 +1,1950 @@
+#include "matlib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * matlib test and benchmark.
+ *
+ * Checks every matlib function on random inputs against a reference
+ * implementation in double precision, failing if the largest error exceeds
+ * the tolerance of the function, then measures the throughput of each.
+ * Errors are relative to the magnitude of the expected values, but never
+ * smaller than absolute ones.
+ *
+ * Optional arguments select the functions to run by their name prefix.
+ */
+
+#define CHECK_SAMPLES 10000
+#define BENCH_INPUTS 64           // inputs cycled through by benchmarks
+#define BENCH_MIN_TIME 0.05       // seconds to run each benchmark for at least
+
+struct Test {
+	const char *name;
+	double (*check)(void);        // returns the largest error seen
+	double tolerance;
+	void (*bench)(size_t count);  // runs the function `count` times
+};
+
+/*******************************************************************************
+ * Random inputs.
+*******************************************************************************/
+
+static float
+rnd(float lo, float hi)
+{
+	return lo + (hi - lo) * (rand() / (float)RAND_MAX);
+}
+
+static Mat
+rnd_mat(void)
+{
+	Mat m;
+	for (int i = 0; i < 16; i++) {
+		m.data[i] = rnd(-1, 1);
+	}
+	return m;
+}
+
+static Vec
+rnd_vec(void)
+{
+	return vec(rnd(-1, 1), rnd(-1, 1), rnd(-1, 1), rnd(-1, 1));
+}
+
+/**
+ * Random unit vector, with w = 0.
+ */
+static Vec
+rnd_axis(void)
+{
+	Vec v;
+	do {
+		v = vec(rnd(-1, 1), rnd(-1, 1), rnd(-1, 1), 0);
+	} while (vec_mag(&v) < 0.1f);
+	float mag = vec_mag(&v);
+	return vec(v.data[0] / mag, v.data[1] / mag, v.data[2] / mag, 0);
+}
+
+/**
+ * Random unit quaternion, uniformly distributed over rotations.
+ */
+static Qtr
+rnd_rotation(void)
+{
+	double q[4], n;
+	do {
+		n = 0;
+		for (int i = 0; i < 4; i++) {
+			q[i] = rnd(-1, 1);
+			n += q[i] * q[i];
+		}
+	} while (n < 0.01 || n > 1);
+	n = sqrt(n);
+	return qtr(q[0] / n, q[1] / n, q[2] / n, q[3] / n);
+}
+
+static Affine2
+rnd_affine2(void)
+{
+	Affine2 m;
+	for (int i = 0; i < 6; i++) {
+		m.data[i] = rnd(-1, 1);
+	}
+	return m;
+}
+
+/*******************************************************************************
+ * Reference implementations, in double precision.
+*******************************************************************************/
+
+static void
+to_double(const float *f, double *r_d, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		r_d[i] = f[i];
+	}
+}
+
+static double
+error_of(const float *got, const double *want, size_t count)
+{
+	double err = 0;
+	for (size_t i = 0; i < count; i++) {
+		double e = fabs(got[i] - want[i]) / fmax(1.0, fabs(want[i]));
+		if (isnan(e)) {
+			return INFINITY;  // fmax() would drop NaNs
+		}
+		err = fmax(err, e);
+	}
+	return err;
+}
+
+/**
+ * Product of square, row-major matrices of given size.
+ */
+static void
+ref_mul(const double *a, const double *b, double *r, int size)
+{
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			double sum = 0;
+			for (int k = 0; k < size; k++) {
+				sum += a[i * size + k] * b[k * size + j];
+			}
+			r[i * size + j] = sum;
+		}
+	}
+}
+
+static void
+ref_ident(double *r, int size)
+{
+	for (int i = 0; i < size * size; i++) {
+		r[i] = i % (size + 1) == 0;
+	}
+}
+
+/**
+ * Rotation matrix of a unit quaternion.
+ */
+static void
+ref_qtr_mat(const double *q, double *r)
+{
+	double w = q[0], x = q[1], y = q[2], z = q[3];
+	double m[16] = {
+		1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w), 0,
+		2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w), 0,
+		2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y), 0,
+		0, 0, 0, 1
+	};
+	memcpy(r, m, sizeof(m));
+}
+
+/**
+ * Rotation matrix of an angle about a unit axis.
+ */
+static void
+ref_axis_angle_mat(const double *axis, double angle, double *r)
+{
+	double s = sin(angle / 2);
+	double q[4] = { cos(angle / 2), axis[0] * s, axis[1] * s, axis[2] * s };
+	ref_qtr_mat(q, r);
+}
+
+static void
+ref_qtr_mul(const double *a, const double *b, double *r)
+{
+	r[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+	r[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+	r[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+	r[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+static void
+ref_normalize(double *v, int count)
+{
+	double n = 0;
+	for (int i = 0; i < count; i++) {
+		n += v[i] * v[i];
+	}
+	n = sqrt(n);
+	for (int i = 0; i < count; i++) {
+		v[i] /= n;
+	}
+}
+
+static void
+ref_cross(const double *a, const double *b, double *r)
+{
+	r[0] = a[1] * b[2] - a[2] * b[1];
+	r[1] = a[2] * b[0] - a[0] * b[2];
+	r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/**
+ * Inverse of a 4x4 matrix, by Gauss-Jordan elimination with partial
+ * pivoting.
+ */
+static int
+ref_inverse(const double *m, double *r)
+{
+	double a[16];
+	memcpy(a, m, sizeof(a));
+	ref_ident(r, 4);
+	for (int col = 0; col < 4; col++) {
+		int pivot = col;
+		for (int row = col + 1; row < 4; row++) {
+			if (fabs(a[row * 4 + col]) > fabs(a[pivot * 4 + col])) {
+				pivot = row;
+			}
+		}
+		if (a[pivot * 4 + col] == 0) {
+			return 0;
+		}
+		for (int j = 0; j < 4; j++) {
+			double t = a[col * 4 + j];
+			a[col * 4 + j] = a[pivot * 4 + j];
+			a[pivot * 4 + j] = t;
+			t = r[col * 4 + j];
+			r[col * 4 + j] = r[pivot * 4 + j];
+			r[pivot * 4 + j] = t;
+		}
+		double p = a[col * 4 + col];
+		for (int j = 0; j < 4; j++) {
+			a[col * 4 + j] /= p;
+			r[col * 4 + j] /= p;
+		}
+		for (int row = 0; row < 4; row++) {
+			double f = a[row * 4 + col];
+			if (row == col || f == 0) {
+				continue;
+			}
+			for (int j = 0; j < 4; j++) {
+				a[row * 4 + j] -= f * a[col * 4 + j];
+				r[row * 4 + j] -= f * r[col * 4 + j];
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+ * Expand a 2x3 affine transform to a 3x3 matrix.
+ */
+static void
+ref_affine2(const Affine2 *m, double *r)
+{
+	to_double(m->data, r, 6);
+	r[6] = 0;
+	r[7] = 0;
+	r[8] = 1;
+}
+
+/*******************************************************************************
+ * Fast trigonometry checks.
+*******************************************************************************/
+
+/**
+ * Check sine and cosine functions, given through fast_sincos()'s signature,
+ * on angles within one turn, within the bound of fast_sincos() polynomials,
+ * at and around the bound, and far beyond it.
+ */
+static double
+check_sincos(void (*sincos)(float, float*, float*))
+{
+	const float ranges[] = { 2 * M_PI, 8192, 1e10f };
+	const float bounds[] = {
+		8192,
+		-8192,
+		nextafterf(8192, INFINITY),
+		nextafterf(-8192, -INFINITY),
+	};
+	const int bound_count = sizeof(bounds) / sizeof(bounds[0]);
+
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		float angle = (
+			i < bound_count ?
+			bounds[i] :
+			rnd(-1, 1) * ranges[i % 3]
+		);
+		float r[2];
+		sincos(angle, &r[0], &r[1]);
+		double want[2] = { sin(angle), cos(angle) };
+		err = fmax(err, error_of(r, want, 2));
+	}
+
+	// non-finite angles have neither
+	const float nonfinite[] = { INFINITY, -INFINITY, NAN };
+	for (int i = 0; i < 3; i++) {
+		float r_sin, r_cos;
+		sincos(nonfinite[i], &r_sin, &r_cos);
+		if (!isnan(r_sin) || !isnan(r_cos)) {
+			return INFINITY;
+		}
+	}
+	return err;
+}
+
+static void
+fast_sin_cos(float angle, float *r_sin, float *r_cos)
+{
+	*r_sin = fast_sin(angle);
+	*r_cos = fast_cos(angle);
+}
+
+static void
+fast_sincos_batch_of_one(float angle, float *r_sin, float *r_cos)
+{
+	fast_sincos_batch(&angle, r_sin, r_cos, 1);
+}
+
+/**
+ * libm, for comparison.
+ */
+static void
+libm_sincos(float angle, float *r_sin, float *r_cos)
+{
+	*r_sin = sinf(angle);
+	*r_cos = cosf(angle);
+}
+
+static double
+check_fast_sincos(void)
+{
+	return check_sincos(fast_sincos);
+}
+
+static double
+check_fast_sincos_poly(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		float angle = i < 2 ? (i ? -8192 : 8192) : rnd(-8192, 8192);
+		float r[2];
+		fast_sincos_poly(angle, &r[0], &r[1]);
+		double want[2] = { sin(angle), cos(angle) };
+		err = fmax(err, error_of(r, want, 2));
+	}
+	return err;
+}
+
+static double
+check_fast_sin_cos(void)
+{
+	return check_sincos(fast_sin_cos);
+}
+
+static double
+check_fast_sincos_batch(void)
+{
+	// odd counts, to cover the tails of vectorized loops
+	double err = check_sincos(fast_sincos_batch_of_one);
+	for (int i = 0; i < CHECK_SAMPLES / 100; i++) {
+		float angles[101], r[202];
+		double want[202];
+		size_t count = 1 + i % 101;
+		for (size_t j = 0; j < count; j++) {
+			angles[j] = rnd(-8192, 8192);
+			want[j] = sin(angles[j]);
+			want[count + j] = cos(angles[j]);
+		}
+		fast_sincos_batch(angles, r, r + count, count);
+		err = fmax(err, error_of(r, want, count * 2));
+	}
+	return err;
+}
+
+static double
+check_libm_sincos(void)
+{
+	return check_sincos(libm_sincos);
+}
+
+/*******************************************************************************
+ * Matrix checks.
+*******************************************************************************/
+
+static double
+check_mat_mul(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat a = rnd_mat(), b = rnd_mat(), r;
+		double da[16], db[16], want[16];
+		to_double(a.data, da, 16);
+		to_double(b.data, db, 16);
+		ref_mul(da, db, want, 4);
+		mat_mul(&a, &b, &r);
+		err = fmax(err, error_of(r.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_imul(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat a = rnd_mat(), b = rnd_mat();
+		double da[16], db[16], want[16];
+		to_double(a.data, da, 16);
+		to_double(b.data, db, 16);
+		ref_mul(da, db, want, 4);
+		mat_imul(&a, &b);
+		err = fmax(err, error_of(a.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_mulv(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat m = rnd_mat();
+		Vec v = rnd_vec(), r;
+		double dm[16], dv[4], want[4];
+		to_double(m.data, dm, 16);
+		to_double(v.data, dv, 4);
+		for (int row = 0; row < 4; row++) {
+			want[row] = 0;
+			for (int k = 0; k < 4; k++) {
+				want[row] += dm[row * 4 + k] * dv[k];
+			}
+		}
+		mat_mulv(&m, &v, &r);
+		err = fmax(err, error_of(r.data, want, 4));
+	}
+	return err;
+}
+
+/**
+ * Check mat_rotate() or mat_rotatev(), which rotate about the axis before
+ * applying the matrix.
+ */
+static double
+check_rotate(int by_vec)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat m = rnd_mat();
+		Vec axis = rnd_axis();
+		float angle = rnd(-2 * M_PI, 2 * M_PI);
+		double dm[16], daxis[3], rm[16], want[16];
+		to_double(m.data, dm, 16);
+		to_double(axis.data, daxis, 3);
+		ref_axis_angle_mat(daxis, angle, rm);
+		ref_mul(rm, dm, want, 4);
+		if (by_vec) {
+			mat_rotatev(&m, &axis, angle);
+		} else {
+			mat_rotate(
+				&m,
+				axis.data[0],
+				axis.data[1],
+				axis.data[2],
+				angle
+			);
+		}
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_rotate(void)
+{
+	return check_rotate(0);
+}
+
+static double
+check_mat_rotatev(void)
+{
+	return check_rotate(1);
+}
+
+static double
+check_mat_rotateq(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat m = rnd_mat();
+		Qtr q = rnd_rotation();
+		double dm[16], dq[4], rm[16], want[16];
+		to_double(m.data, dm, 16);
+		to_double(q.data, dq, 4);
+		ref_qtr_mat(dq, rm);
+		ref_mul(dm, rm, want, 4);
+		mat_rotateq(&m, &q);
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_get_rotation(void)
+{
+	// half turns, and nearly so, come first, as they are the hard cases
+	const double h = sqrt(0.5), e = 1e-3;
+	const double hard[][4] = {
+		{ 0, 1, 0, 0 },
+		{ 0, 0, 1, 0 },
+		{ 0, 0, 0, 1 },
+		{ 0, h, h, 0 },
+		{ e, sqrt(1 - e * e), 0, 0 },
+		{ e, 0, 0, sqrt(1 - e * e) },
+	};
+	const int hard_count = sizeof(hard) / sizeof(hard[0]);
+
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		double want[4], dm[16];
+		if (i < hard_count) {
+			memcpy(want, hard[i], sizeof(want));
+		} else {
+			Qtr q = rnd_rotation();
+			to_double(q.data, want, 4);
+		}
+		ref_qtr_mat(want, dm);
+		Mat m;
+		for (int j = 0; j < 16; j++) {
+			m.data[j] = dm[j];
+		}
+
+		// q and -q are the same rotation
+		Qtr r = mat_get_rotation(&m);
+		double neg[4] = { -want[0], -want[1], -want[2], -want[3] };
+		err = fmax(err, fmin(
+			error_of(r.data, want, 4),
+			error_of(r.data, neg, 4)
+		));
+	}
+	return err;
+}
+
+/**
+ * Check mat_scale() or mat_scalev(), which scale before applying the
+ * matrix.
+ */
+static double
+check_scale(int by_vec)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat m = rnd_mat();
+		Vec s = rnd_vec();
+		double dm[16], sm[16], want[16];
+		to_double(m.data, dm, 16);
+		ref_ident(sm, 4);
+		sm[0] = s.data[0];
+		sm[5] = s.data[1];
+		sm[10] = s.data[2];
+		ref_mul(dm, sm, want, 4);
+		if (by_vec) {
+			mat_scalev(&m, &s);
+		} else {
+			mat_scale(&m, s.data[0], s.data[1], s.data[2]);
+		}
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_scale(void)
+{
+	return check_scale(0);
+}
+
+static double
+check_mat_scalev(void)
+{
+	return check_scale(1);
+}
+
+static double
+check_mat_get_scale(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat m = rnd_mat();
+		double dm[16], want[4] = { 0 };
+		to_double(m.data, dm, 16);
+		for (int col = 0; col < 3; col++) {
+			for (int row = 0; row < 3; row++) {
+				want[col] += dm[row * 4 + col] * dm[row * 4 + col];
+			}
+			want[col] = sqrt(want[col]);
+		}
+		Vec r = mat_get_scale(&m);
+		err = fmax(err, error_of(r.data, want, 4));
+	}
+	return err;
+}
+
+/**
+ * Check mat_translate() or mat_translatev(), which translate before
+ * applying the matrix.
+ */
+static double
+check_translate(int by_vec)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat m = rnd_mat();
+		Vec t = rnd_vec();
+		double dm[16], tm[16], want[16];
+		to_double(m.data, dm, 16);
+		ref_ident(tm, 4);
+		tm[3] = t.data[0];
+		tm[7] = t.data[1];
+		tm[11] = t.data[2];
+		ref_mul(dm, tm, want, 4);
+		if (by_vec) {
+			mat_translatev(&m, &t);
+		} else {
+			mat_translate(&m, t.data[0], t.data[1], t.data[2]);
+		}
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_translate(void)
+{
+	return check_translate(0);
+}
+
+static double
+check_mat_translatev(void)
+{
+	return check_translate(1);
+}
+
+static double
+check_mat_get_translation(void)
+{
+	// translations followed by any linear transform are retrieved as they
+	// are, without the transform applied
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec t = rnd_vec();
+		Mat m;
+		mat_ident(&m);
+		mat_translate(&m, t.data[0], t.data[1], t.data[2]);
+		mat_scale(&m, rnd(0.1f, 2), rnd(0.1f, 2), rnd(0.1f, 2));
+		Qtr q = rnd_rotation();
+		mat_rotateq(&m, &q);
+
+		double want[4] = { t.data[0], t.data[1], t.data[2], 0 };
+		Vec r = mat_get_translation(&m);
+		err = fmax(err, error_of(r.data, want, 4));
+	}
+	return err;
+}
+
+/**
+ * Check mat_lookat() or mat_lookatv() against gluLookAt().
+ */
+static double
+check_lookat(int by_vec)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec eye = rnd_vec(), center = rnd_vec(), up = rnd_axis();
+		eye.data[3] = center.data[3] = 0;
+		double de[3], dc[3], du[3], f[3], s[3], u[3];
+		to_double(eye.data, de, 3);
+		to_double(center.data, dc, 3);
+		to_double(up.data, du, 3);
+		for (int j = 0; j < 3; j++) {
+			f[j] = dc[j] - de[j];
+		}
+		ref_normalize(f, 3);
+		ref_cross(f, du, s);
+		// skip degenerate views, along the up vector
+		if (sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]) < 0.1) {
+			continue;
+		}
+		ref_normalize(s, 3);
+		ref_cross(s, f, u);
+		double want[16] = {
+			s[0], s[1], s[2], -(s[0] * de[0] + s[1] * de[1] + s[2] * de[2]),
+			u[0], u[1], u[2], -(u[0] * de[0] + u[1] * de[1] + u[2] * de[2]),
+			-f[0], -f[1], -f[2], f[0] * de[0] + f[1] * de[1] + f[2] * de[2],
+			0, 0, 0, 1
+		};
+
+		Mat m;
+		if (by_vec) {
+			mat_lookatv(&m, &eye, &center, &up);
+		} else {
+			mat_lookat(
+				&m,
+				eye.data[0], eye.data[1], eye.data[2],
+				center.data[0], center.data[1], center.data[2],
+				up.data[0], up.data[1], up.data[2]
+			);
+		}
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_lookat(void)
+{
+	return check_lookat(0);
+}
+
+static double
+check_mat_lookatv(void)
+{
+	return check_lookat(1);
+}
+
+/**
+ * Check against glOrtho(), whose arguments come in a different order.
+ */
+static double
+check_mat_ortho(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		float l = rnd(-1000, 0), r = rnd(1, 1000);
+		float b = rnd(-1000, 0), t = rnd(1, 1000);
+		float n = rnd(-10, 10), f = n + rnd(1, 1000);
+		double want[16] = {
+			2 / ((double)r - l), 0, 0, -((double)r + l) / ((double)r - l),
+			0, 2 / ((double)t - b), 0, -((double)t + b) / ((double)t - b),
+			0, 0, -2 / ((double)f - n), -((double)f + n) / ((double)f - n),
+			0, 0, 0, 1
+		};
+		Mat m;
+		mat_ortho(&m, l, r, t, b, n, f);
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+/**
+ * Check against gluPerspective().
+ */
+static double
+check_mat_persp(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		float fovy = rnd(10, 170), aspect = rnd(0.5f, 2);
+		float n = rnd(0.1f, 10), f = n + rnd(1, 1000);
+		double y = 1 / tan(fovy * M_PI / 360);
+		double want[16] = {
+			y / aspect, 0, 0, 0,
+			0, y, 0, 0,
+			0, 0, ((double)f + n) / ((double)n - f),
+			2.0 * f * n / ((double)n - f),
+			0, 0, -1, 0
+		};
+		Mat m;
+		mat_persp(&m, fovy, aspect, n, f);
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+static double
+check_mat_ident(void)
+{
+	double want[16];
+	ref_ident(want, 4);
+	Mat m = rnd_mat();
+	mat_ident(&m);
+	return error_of(m.data, want, 16);
+}
+
+static double
+check_mat_inverse(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		// diagonally dominant, thus, well conditioned
+		Mat m = rnd_mat(), r;
+		for (int j = 0; j < 4; j++) {
+			m.data[j * 5] += j % 2 ? 4 : -4;
+		}
+		double dm[16], want[16];
+		to_double(m.data, dm, 16);
+		ref_inverse(dm, want);
+		if (!mat_inverse(&m, &r)) {
+			return INFINITY;
+		}
+		err = fmax(err, error_of(r.data, want, 16));
+	}
+
+	// singular matrices have no inverse; those of a zero row have
+	// a determinant of exactly zero even in single precision
+	Mat singular = rnd_mat(), r;
+	memset(&singular.data[4], 0, 4 * sizeof(float));
+	return mat_inverse(&singular, &r) ? INFINITY : err;
+}
+
+static double
+check_mat_transpose(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Mat m = rnd_mat(), r;
+		double want[16];
+		for (int row = 0; row < 4; row++) {
+			for (int col = 0; col < 4; col++) {
+				want[row * 4 + col] = m.data[col * 4 + row];
+			}
+		}
+		// either into another matrix or in place
+		if (i % 2) {
+			mat_transpose(&m, &r);
+		} else {
+			r = m;
+			mat_transpose(&r, &r);
+		}
+		err = fmax(err, error_of(r.data, want, 16));
+	}
+	return err;
+}
+
+/*******************************************************************************
+ * Vector checks.
+*******************************************************************************/
+
+static double
+check_vec(void)
+{
+	const double want[4] = { 1, 2, 3, 4 };
+	Vec v = vec(1, 2, 3, 4);
+	return error_of(v.data, want, 4);
+}
+
+/**
+ * Check an element-wise operation of two vectors, or a vector and a scalar,
+ * in both of its forms, e.g. vec_add() and vec_iadd().
+ */
+static double
+check_elementwise(
+	void (*op)(const Vec*, const Vec*, Vec*),
+	void (*iop)(Vec*, const Vec*),
+	void (*opf)(const Vec*, float, Vec*),
+	void (*iopf)(Vec*, float),
+	double (*ref)(double, double)
+) {
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec a = rnd_vec(), b = rnd_vec(), r;
+		float s = rnd(-1, 1);
+		double want[4];
+		for (int j = 0; j < 4; j++) {
+			want[j] = ref(a.data[j], op ? b.data[j] : s);
+		}
+		if (op) {
+			op(&a, &b, &r);
+			err = fmax(err, error_of(r.data, want, 4));
+			iop(&a, &b);
+		} else {
+			opf(&a, s, &r);
+			err = fmax(err, error_of(r.data, want, 4));
+			iopf(&a, s);
+		}
+		err = fmax(err, error_of(a.data, want, 4));
+	}
+	return err;
+}
+
+static double
+ref_add(double a, double b)
+{
+	return a + b;
+}
+
+static double
+ref_sub(double a, double b)
+{
+	return a - b;
+}
+
+static double
+ref_mulf(double a, double b)
+{
+	return a * b;
+}
+
+static double
+check_vec_add(void)
+{
+	return check_elementwise(vec_add, vec_iadd, NULL, NULL, ref_add);
+}
+
+static double
+check_vec_addf(void)
+{
+	return check_elementwise(NULL, NULL, vec_addf, vec_iaddf, ref_add);
+}
+
+static double
+check_vec_sub(void)
+{
+	return check_elementwise(vec_sub, vec_isub, NULL, NULL, ref_sub);
+}
+
+static double
+check_vec_subf(void)
+{
+	return check_elementwise(NULL, NULL, vec_subf, vec_isubf, ref_sub);
+}
+
+static double
+check_vec_mulf(void)
+{
+	return check_elementwise(NULL, NULL, vec_mulf, vec_imulf, ref_mulf);
+}
+
+static double
+check_vec_dot(void)
+{
+	// of the first three components only
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec a = rnd_vec(), b = rnd_vec();
+		double want = 0;
+		for (int j = 0; j < 3; j++) {
+			want += (double)a.data[j] * b.data[j];
+		}
+		float r = vec_dot(&a, &b);
+		err = fmax(err, error_of(&r, &want, 1));
+	}
+	return err;
+}
+
+static double
+check_vec_mag(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec v = rnd_vec();
+		double dv[3];
+		to_double(v.data, dv, 3);
+		double want = sqrt(dv[0] * dv[0] + dv[1] * dv[1] + dv[2] * dv[2]);
+		float r = vec_mag(&v);
+		err = fmax(err, error_of(&r, &want, 1));
+	}
+	return err;
+}
+
+static double
+check_vec_cross(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec a = rnd_vec(), b = rnd_vec(), r;
+		double da[3], db[3], want[4] = { 0 };
+		to_double(a.data, da, 3);
+		to_double(b.data, db, 3);
+		ref_cross(da, db, want);
+		vec_cross(&a, &b, &r);
+		err = fmax(err, error_of(r.data, want, 4));
+	}
+	return err;
+}
+
+static double
+check_vec_norm(void)
+{
+	// all components are divided by the magnitude of the first three
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec v = rnd_vec();
+		double dv[4];
+		to_double(v.data, dv, 4);
+		double mag = sqrt(dv[0] * dv[0] + dv[1] * dv[1] + dv[2] * dv[2]);
+		double want[4];
+		for (int j = 0; j < 4; j++) {
+			want[j] = dv[j] / mag;
+		}
+		vec_norm(&v);
+		err = fmax(err, error_of(v.data, want, 4));
+	}
+
+	// zero vectors are left alone
+	Vec zero = vec(0, 0, 0, 0);
+	const double want[4] = { 0 };
+	vec_norm(&zero);
+	return fmax(err, error_of(zero.data, want, 4));
+}
+
+static double
+check_vec_clamp(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec v = rnd_vec();
+		float limit = rnd(0, 2);
+		double dv[4];
+		to_double(v.data, dv, 4);
+		double mag = sqrt(dv[0] * dv[0] + dv[1] * dv[1] + dv[2] * dv[2]);
+		double want[4];
+		for (int j = 0; j < 4; j++) {
+			want[j] = mag > limit ? dv[j] / mag * limit : dv[j];
+		}
+		vec_clamp(&v, limit);
+		err = fmax(err, error_of(v.data, want, 4));
+	}
+	return err;
+}
+
+static double
+check_vec_lerp(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec a = rnd_vec(), b = rnd_vec(), r;
+		float t = rnd(0, 1);
+		double want[4];
+		for (int j = 0; j < 4; j++) {
+			want[j] = a.data[j] + ((double)b.data[j] - a.data[j]) * t;
+		}
+		vec_lerp(&a, &b, t, &r);
+		err = fmax(err, error_of(r.data, want, 4));
+	}
+	return err;
+}
+
+/*******************************************************************************
+ * 2D vector checks.
+*******************************************************************************/
+
+static double
+check_vec2_arithmetic(void)
+{
+	// vec2(), vec2_add(), vec2_sub() and vec2_mulf()
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		float ax = rnd(-1, 1), ay = rnd(-1, 1);
+		float bx = rnd(-1, 1), by = rnd(-1, 1), s = rnd(-1, 1);
+		Vec2 a = vec2(ax, ay), b = vec2(bx, by);
+		Vec2 r[3] = { vec2_add(a, b), vec2_sub(a, b), vec2_mulf(a, s) };
+		double want[6] = {
+			(double)ax + bx, (double)ay + by,
+			(double)ax - bx, (double)ay - by,
+			(double)ax * s, (double)ay * s
+		};
+		err = fmax(err, error_of(&r[0].x, want, 6));
+	}
+	return err;
+}
+
+static double
+check_vec2_dot_mag(void)
+{
+	// vec2_dot() and vec2_mag()
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec2 a = vec2(rnd(-1, 1), rnd(-1, 1));
+		Vec2 b = vec2(rnd(-1, 1), rnd(-1, 1));
+		float r[2] = { vec2_dot(a, b), vec2_mag(a) };
+		double want[2] = {
+			(double)a.x * b.x + (double)a.y * b.y,
+			sqrt((double)a.x * a.x + (double)a.y * a.y)
+		};
+		err = fmax(err, error_of(r, want, 2));
+	}
+	return err;
+}
+
+static double
+check_vec2_lerp(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Vec2 a = vec2(rnd(-1, 1), rnd(-1, 1));
+		Vec2 b = vec2(rnd(-1, 1), rnd(-1, 1));
+		float t = rnd(0, 1);
+		Vec2 r = vec2_lerp(a, b, t);
+		double want[2] = {
+			a.x + ((double)b.x - a.x) * t,
+			a.y + ((double)b.y - a.y) * t
+		};
+		err = fmax(err, error_of(&r.x, want, 2));
+	}
+	return err;
+}
+
+static double
+check_vec2_madd_batch(void)
+{
+	// odd counts, to cover the tails of vectorized loops
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES / 100; i++) {
+		Vec2 v[101], d[101];
+		double want[202];
+		size_t count = 1 + i % 101;
+		float s = rnd(-1, 1);
+		for (size_t j = 0; j < count; j++) {
+			v[j] = vec2(rnd(-1, 1), rnd(-1, 1));
+			d[j] = vec2(rnd(-1, 1), rnd(-1, 1));
+			want[j * 2] = v[j].x + (double)d[j].x * s;
+			want[j * 2 + 1] = v[j].y + (double)d[j].y * s;
+		}
+		vec2_madd_batch(v, d, s, count);
+		err = fmax(err, error_of(&v[0].x, want, count * 2));
+	}
+	return err;
+}
+
+/*******************************************************************************
+ * 2D affine transform checks.
+*******************************************************************************/
+
+static double
+check_affine2_ident(void)
+{
+	double want[9];
+	ref_ident(want, 3);
+	Affine2 m = rnd_affine2();
+	affine2_ident(&m);
+	return error_of(m.data, want, 6);
+}
+
+static double
+check_affine2_mul(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Affine2 a = rnd_affine2(), b = rnd_affine2(), r;
+		double da[9], db[9], want[9];
+		ref_affine2(&a, da);
+		ref_affine2(&b, db);
+		ref_mul(da, db, want, 3);
+		affine2_mul(&a, &b, &r);
+		err = fmax(err, error_of(r.data, want, 6));
+	}
+	return err;
+}
+
+/**
+ * Check a transform composed on the right of a random one, given as a 3x3
+ * matrix, by its function.
+ */
+static double
+check_affine2_op(void (*op)(Affine2*, const float*, double*))
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Affine2 m = rnd_affine2();
+		float args[2] = { rnd(-M_PI, M_PI), rnd(-M_PI, M_PI) };
+		double dm[9], om[9], want[9];
+		ref_affine2(&m, dm);
+		op(&m, args, om);
+		ref_mul(dm, om, want, 3);
+		err = fmax(err, error_of(m.data, want, 6));
+	}
+	return err;
+}
+
+static void
+op_translate(Affine2 *m, const float *args, double *r_m)
+{
+	ref_ident(r_m, 3);
+	r_m[2] = args[0];
+	r_m[5] = args[1];
+	affine2_translate(m, args[0], args[1]);
+}
+
+static void
+op_rotate_sc(Affine2 *m, const float *args, double *r_m)
+{
+	float s = sinf(args[0]), c = cosf(args[0]);
+	ref_ident(r_m, 3);
+	r_m[0] = r_m[4] = c;
+	r_m[1] = -s;
+	r_m[3] = s;
+	affine2_rotate_sc(m, s, c);
+}
+
+static void
+op_rotate(Affine2 *m, const float *args, double *r_m)
+{
+	ref_ident(r_m, 3);
+	r_m[0] = r_m[4] = cos(args[0]);
+	r_m[1] = -sin(args[0]);
+	r_m[3] = sin(args[0]);
+	affine2_rotate(m, args[0]);
+}
+
+static void
+op_scale(Affine2 *m, const float *args, double *r_m)
+{
+	ref_ident(r_m, 3);
+	r_m[0] = args[0];
+	r_m[4] = args[1];
+	affine2_scale(m, args[0], args[1]);
+}
+
+static double
+check_affine2_translate(void)
+{
+	return check_affine2_op(op_translate);
+}
+
+static double
+check_affine2_rotate_sc(void)
+{
+	return check_affine2_op(op_rotate_sc);
+}
+
+static double
+check_affine2_rotate(void)
+{
+	return check_affine2_op(op_rotate);
+}
+
+static double
+check_affine2_scale(void)
+{
+	return check_affine2_op(op_scale);
+}
+
+static double
+check_affine2_apply(void)
+{
+	// affine2_apply() and affine2_apply_batch(), of odd counts
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES / 100; i++) {
+		Affine2 m = rnd_affine2();
+		Vec2 v[101], r[101];
+		double want[202];
+		size_t count = 1 + i % 101;
+		const float *a = m.data;
+		for (size_t j = 0; j < count; j++) {
+			v[j] = vec2(rnd(-1, 1), rnd(-1, 1));
+			want[j * 2] = (double)a[0] * v[j].x + (double)a[1] * v[j].y + a[2];
+			want[j * 2 + 1] = (double)a[3] * v[j].x + (double)a[4] * v[j].y + a[5];
+		}
+		affine2_apply_batch(&m, v, r, count);
+		err = fmax(err, error_of(&r[0].x, want, count * 2));
+		for (size_t j = 0; j < count; j++) {
+			r[j] = affine2_apply(&m, v[j]);
+		}
+		err = fmax(err, error_of(&r[0].x, want, count * 2));
+	}
+	return err;
+}
+
+static double
+check_affine2_to_mat(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Affine2 a = rnd_affine2();
+		const float *d = a.data;
+		double want[16] = {
+			d[0], d[1], 0, d[2],
+			d[3], d[4], 0, d[5],
+			0, 0, 1, 0,
+			0, 0, 0, 1
+		};
+		Mat m;
+		affine2_to_mat(&a, &m);
+		err = fmax(err, error_of(m.data, want, 16));
+	}
+	return err;
+}
+
+/*******************************************************************************
+ * Quaternion checks.
+*******************************************************************************/
+
+static double
+check_qtr(void)
+{
+	const double want[4] = { 1, 2, 3, 4 };
+	Qtr q = qtr(1, 2, 3, 4);
+	return error_of(q.data, want, 4);
+}
+
+/**
+ * Check qtr_rotate() or qtr_rotatev(), which rotate about the axis before
+ * applying the quaternion.
+ */
+static double
+check_qtr_rotation(int by_vec)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Qtr q = rnd_rotation();
+		Vec axis = rnd_axis();
+		float angle = rnd(-2 * M_PI, 2 * M_PI);
+		double dq[4], rq[4], want[4];
+		to_double(q.data, dq, 4);
+		rq[0] = cos(angle / 2.0);
+		for (int j = 0; j < 3; j++) {
+			rq[j + 1] = axis.data[j] * sin(angle / 2.0);
+		}
+		ref_qtr_mul(dq, rq, want);
+		if (by_vec) {
+			qtr_rotatev(&q, &axis, angle);
+		} else {
+			qtr_rotate(
+				&q,
+				axis.data[0],
+				axis.data[1],
+				axis.data[2],
+				angle
+			);
+		}
+		err = fmax(err, error_of(q.data, want, 4));
+	}
+	return err;
+}
+
+static double
+check_qtr_rotate(void)
+{
+	return check_qtr_rotation(0);
+}
+
+static double
+check_qtr_rotatev(void)
+{
+	return check_qtr_rotation(1);
+}
+
+static double
+check_qtr_add(void)
+{
+	// qtr_add() and qtr_iadd()
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Qtr a = rnd_rotation(), b = rnd_rotation(), r;
+		double want[4];
+		for (int j = 0; j < 4; j++) {
+			want[j] = (double)a.data[j] + b.data[j];
+		}
+		qtr_add(&a, &b, &r);
+		qtr_iadd(&a, &b);
+		err = fmax(err, error_of(r.data, want, 4));
+		err = fmax(err, error_of(a.data, want, 4));
+	}
+	return err;
+}
+
+static double
+check_qtr_mul(void)
+{
+	// qtr_mul() and qtr_imul()
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Qtr a = rnd_rotation(), b = rnd_rotation(), r;
+		double da[4], db[4], want[4];
+		to_double(a.data, da, 4);
+		to_double(b.data, db, 4);
+		ref_qtr_mul(da, db, want);
+		qtr_mul(&a, &b, &r);
+		qtr_imul(&a, &b);
+		err = fmax(err, error_of(r.data, want, 4));
+		err = fmax(err, error_of(a.data, want, 4));
+	}
+	return err;
+}
+
+static double
+check_qtr_mulf(void)
+{
+	// qtr_mulf() and qtr_imulf()
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Qtr q = rnd_rotation(), r;
+		float s = rnd(-2, 2);
+		double want[4];
+		for (int j = 0; j < 4; j++) {
+			want[j] = (double)q.data[j] * s;
+		}
+		qtr_mulf(&q, s, &r);
+		qtr_imulf(&q, s);
+		err = fmax(err, error_of(r.data, want, 4));
+		err = fmax(err, error_of(q.data, want, 4));
+	}
+	return err;
+}
+
+static double
+check_qtr_norm(void)
+{
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Qtr q = qtr(rnd(-2, 2), rnd(-2, 2), rnd(-2, 2), rnd(-2, 2));
+		double want[4];
+		to_double(q.data, want, 4);
+		ref_normalize(want, 4);
+		qtr_norm(&q);
+		err = fmax(err, error_of(q.data, want, 4));
+	}
+	return err;
+}
+
+static double
+check_qtr_lerp(void)
+{
+	// normalized linear interpolation, of quaternions in the same
+	// hemisphere
+	double err = 0;
+	for (int i = 0; i < CHECK_SAMPLES; i++) {
+		Qtr a = rnd_rotation(), b = rnd_rotation(), r;
+		if (a.data[0] * b.data[0] + a.data[1] * b.data[1] +
+		    a.data[2] * b.data[2] + a.data[3] * b.data[3] < 0) {
+			qtr_imulf(&b, -1);
+		}
+		float t = rnd(0, 1);
+		double want[4];
+		for (int j = 0; j < 4; j++) {
+			want[j] = a.data[j] * (1.0 - t) + b.data[j] * (double)t;
+		}
+		ref_normalize(want, 4);
+		qtr_lerp(&a, &b, t, &r);
+		err = fmax(err, error_of(r.data, want, 4));
+	}
+	return err;
+}
+
+/*******************************************************************************
+ * Benchmarks.
+*******************************************************************************/
+
+static Mat in_mats[BENCH_INPUTS];
+static Vec in_vecs[BENCH_INPUTS];
+static Qtr in_qtrs[BENCH_INPUTS];
+static Affine2 in_affines[BENCH_INPUTS];
+static Vec2 in_vec2s[BENCH_INPUTS];
+static float in_floats[BENCH_INPUTS];
+static volatile float sink;   // keeps results from being optimized out
+
+static void
+init_bench_inputs(void)
+{
+	for (int i = 0; i < BENCH_INPUTS; i++) {
+		in_mats[i] = rnd_mat();
+		in_mats[i].data[i % 4 * 5] += 4;  // invertible
+		in_vecs[i] = rnd_vec();
+		in_qtrs[i] = rnd_rotation();
+		in_affines[i] = rnd_affine2();
+		in_vec2s[i] = vec2(rnd(-1, 1), rnd(-1, 1));
+		in_floats[i] = rnd(-M_PI, M_PI);
+	}
+}
+
+/**
+ * Define a benchmark, whose body uses inputs `j` and `k` and adds a
+ * component of the result to `acc`. The body is variadic, as commas in its
+ * declarations would split it into arguments.
+ */
+#define BENCH(name, ...)                                       \
+	static void                                            \
+	bench_##name(size_t count)                             \
+	{                                                      \
+		float acc = 0;                                 \
+		for (size_t i = 0; i < count; i++) {           \
+			size_t j = i % BENCH_INPUTS;           \
+			size_t k = (i + 1) % BENCH_INPUTS;     \
+			(void)k;                               \
+			__VA_ARGS__                            \
+		}                                              \
+		sink = acc;                                    \
+	}
+
+BENCH(fast_sincos, {
+	float r_sin, r_cos;
+	fast_sincos(in_floats[j], &r_sin, &r_cos);
+	acc += r_sin + r_cos;
+})
+
+BENCH(fast_sincos_poly, {
+	float r_sin, r_cos;
+	fast_sincos_poly(in_floats[j], &r_sin, &r_cos);
+	acc += r_sin + r_cos;
+})
+
+BENCH(fast_sin_cos, {
+	acc += fast_sin(in_floats[j]) + fast_cos(in_floats[j]);
+})
+
+static void
+bench_fast_sincos_batch(size_t count)
+{
+	float r_sin[BENCH_INPUTS], r_cos[BENCH_INPUTS];
+	for (size_t i = 0; i < count; i += BENCH_INPUTS) {
+		fast_sincos_batch(in_floats, r_sin, r_cos, BENCH_INPUTS);
+	}
+	sink = r_sin[0] + r_cos[0];
+}
+
+BENCH(libm_sincos, {
+	acc += sinf(in_floats[j]) + cosf(in_floats[j]);
+})
+
+BENCH(mat_mul, {
+	Mat r;
+	mat_mul(&in_mats[j], &in_mats[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(mat_imul, {
+	Mat r = in_mats[j];
+	mat_imul(&r, &in_mats[k]);
+	acc += r.data[0];
+})
+
+BENCH(mat_mulv, {
+	Vec r;
+	mat_mulv(&in_mats[j], &in_vecs[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(mat_rotate, {
+	Mat r = in_mats[j];
+	const float *a = in_vecs[k].data;
+	mat_rotate(&r, a[0], a[1], a[2], in_floats[k]);
+	acc += r.data[0];
+})
+
+BENCH(mat_rotatev, {
+	Mat r = in_mats[j];
+	mat_rotatev(&r, &in_vecs[k], in_floats[k]);
+	acc += r.data[0];
+})
+
+BENCH(mat_rotateq, {
+	Mat r = in_mats[j];
+	mat_rotateq(&r, &in_qtrs[k]);
+	acc += r.data[0];
+})
+
+BENCH(mat_get_rotation, {
+	acc += mat_get_rotation(&in_mats[j]).data[0];
+})
+
+BENCH(mat_scale, {
+	Mat r = in_mats[j];
+	const float *s = in_vecs[k].data;
+	mat_scale(&r, s[0], s[1], s[2]);
+	acc += r.data[0];
+})
+
+BENCH(mat_scalev, {
+	Mat r = in_mats[j];
+	mat_scalev(&r, &in_vecs[k]);
+	acc += r.data[0];
+})
+
+BENCH(mat_get_scale, {
+	acc += mat_get_scale(&in_mats[j]).data[0];
+})
+
+BENCH(mat_translate, {
+	Mat r = in_mats[j];
+	const float *t = in_vecs[k].data;
+	mat_translate(&r, t[0], t[1], t[2]);
+	acc += r.data[3];
+})
+
+BENCH(mat_translatev, {
+	Mat r = in_mats[j];
+	mat_translatev(&r, &in_vecs[k]);
+	acc += r.data[3];
+})
+
+BENCH(mat_get_translation, {
+	acc += mat_get_translation(&in_mats[j]).data[0];
+})
+
+BENCH(mat_lookat, {
+	Mat r;
+	const float *e = in_vecs[j].data;
+	const float *c = in_vecs[k].data;
+	mat_lookat(&r, e[0], e[1], e[2], c[0], c[1], c[2], 0, 1, 0);
+	acc += r.data[0];
+})
+
+BENCH(mat_lookatv, {
+	Mat r;
+	Vec up = vec(0, 1, 0, 0);
+	mat_lookatv(&r, &in_vecs[j], &in_vecs[k], &up);
+	acc += r.data[0];
+})
+
+BENCH(mat_ortho, {
+	Mat r;
+	mat_ortho(&r, -in_floats[j] - 4, in_floats[k] + 4, 1, -1, 0, 100);
+	acc += r.data[0];
+})
+
+BENCH(mat_persp, {
+	Mat r;
+	mat_persp(&r, 60 + in_floats[j], 1.5f, 0.1f, 100);
+	acc += r.data[0];
+})
+
+BENCH(mat_ident, {
+	Mat r;
+	mat_ident(&r);
+	acc += r.data[j % 16];
+})
+
+BENCH(mat_inverse, {
+	Mat r;
+	mat_inverse(&in_mats[j], &r);
+	acc += r.data[0];
+})
+
+BENCH(mat_transpose, {
+	Mat r;
+	mat_transpose(&in_mats[j], &r);
+	acc += r.data[1];
+})
+
+BENCH(vec, {
+	acc += vec(in_floats[j], 0, 0, 1).data[0];
+})
+
+BENCH(vec_add, {
+	Vec r;
+	vec_add(&in_vecs[j], &in_vecs[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(vec_addf, {
+	Vec r;
+	vec_addf(&in_vecs[j], in_floats[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(vec_sub, {
+	Vec r;
+	vec_sub(&in_vecs[j], &in_vecs[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(vec_subf, {
+	Vec r;
+	vec_subf(&in_vecs[j], in_floats[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(vec_mulf, {
+	Vec r;
+	vec_mulf(&in_vecs[j], in_floats[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(vec_dot, {
+	acc += vec_dot(&in_vecs[j], &in_vecs[k]);
+})
+
+BENCH(vec_mag, {
+	acc += vec_mag(&in_vecs[j]);
+})
+
+BENCH(vec_cross, {
+	Vec r;
+	vec_cross(&in_vecs[j], &in_vecs[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(vec_norm, {
+	Vec r = in_vecs[j];
+	vec_norm(&r);
+	acc += r.data[0];
+})
+
+BENCH(vec_clamp, {
+	Vec r = in_vecs[j];
+	vec_clamp(&r, 0.5f);
+	acc += r.data[0];
+})
+
+BENCH(vec_lerp, {
+	Vec r;
+	vec_lerp(&in_vecs[j], &in_vecs[k], 0.5f, &r);
+	acc += r.data[0];
+})
+
+BENCH(vec2_arithmetic, {
+	Vec2 r = vec2_add(in_vec2s[j], vec2_mulf(in_vec2s[k], in_floats[k]));
+	acc += vec2_sub(r, in_vec2s[k]).x;
+})
+
+BENCH(vec2_dot_mag, {
+	acc += vec2_dot(in_vec2s[j], in_vec2s[k]) + vec2_mag(in_vec2s[j]);
+})
+
+BENCH(vec2_lerp, {
+	acc += vec2_lerp(in_vec2s[j], in_vec2s[k], 0.5f).x;
+})
+
+static void
+bench_vec2_madd_batch(size_t count)
+{
+	Vec2 v[BENCH_INPUTS];
+	memcpy(v, in_vec2s, sizeof(v));
+	for (size_t i = 0; i < count; i += BENCH_INPUTS) {
+		vec2_madd_batch(v, in_vec2s, 1e-3f, BENCH_INPUTS);
+	}
+	sink = v[0].x;
+}
+
+BENCH(affine2_ident, {
+	Affine2 r;
+	affine2_ident(&r);
+	acc += r.data[j % 6];
+})
+
+BENCH(affine2_mul, {
+	Affine2 r;
+	affine2_mul(&in_affines[j], &in_affines[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(affine2_translate, {
+	Affine2 r = in_affines[j];
+	affine2_translate(&r, in_floats[j], in_floats[k]);
+	acc += r.data[2];
+})
+
+BENCH(affine2_rotate_sc, {
+	Affine2 r = in_affines[j];
+	affine2_rotate_sc(&r, in_vec2s[k].x, in_vec2s[k].y);
+	acc += r.data[0];
+})
+
+BENCH(affine2_rotate, {
+	Affine2 r = in_affines[j];
+	affine2_rotate(&r, in_floats[k]);
+	acc += r.data[0];
+})
+
+BENCH(affine2_scale, {
+	Affine2 r = in_affines[j];
+	affine2_scale(&r, in_floats[j], in_floats[k]);
+	acc += r.data[0];
+})
+
+static void
+bench_affine2_apply(size_t count)
+{
+	Vec2 r[BENCH_INPUTS];
+	for (size_t i = 0; i < count; i += BENCH_INPUTS) {
+		affine2_apply_batch(&in_affines[i % 7], in_vec2s, r, BENCH_INPUTS);
+	}
+	sink = r[0].x;
+}
+
+BENCH(affine2_to_mat, {
+	Mat r;
+	affine2_to_mat(&in_affines[j], &r);
+	acc += r.data[0];
+})
+
+BENCH(qtr, {
+	acc += qtr(in_floats[j], 0, 0, 0).data[0];
+})
+
+BENCH(qtr_rotate, {
+	Qtr r = in_qtrs[j];
+	const float *a = in_vecs[k].data;
+	qtr_rotate(&r, a[0], a[1], a[2], in_floats[k]);
+	acc += r.data[0];
+})
+
+BENCH(qtr_rotatev, {
+	Qtr r = in_qtrs[j];
+	qtr_rotatev(&r, &in_vecs[k], in_floats[k]);
+	acc += r.data[0];
+})
+
+BENCH(qtr_add, {
+	Qtr r;
+	qtr_add(&in_qtrs[j], &in_qtrs[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(qtr_mul, {
+	Qtr r;
+	qtr_mul(&in_qtrs[j], &in_qtrs[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(qtr_mulf, {
+	Qtr r;
+	qtr_mulf(&in_qtrs[j], in_floats[k], &r);
+	acc += r.data[0];
+})
+
+BENCH(qtr_norm, {
+	Qtr r = in_qtrs[j];
+	qtr_norm(&r);
+	acc += r.data[0];
+})
+
+BENCH(qtr_lerp, {
+	Qtr r;
+	qtr_lerp(&in_qtrs[j], &in_qtrs[k], 0.5f, &r);
+	acc += r.data[0];
+})
+
+/**
+ * Measure the time per run of a benchmark, in nanoseconds.
+ */
+static double
+measure(void (*bench)(size_t count))
+{
+	for (size_t count = 1024;; count *= 2) {
+		clock_t start = clock();
+		bench(count);
+		double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+		if (elapsed >= BENCH_MIN_TIME) {
+			return elapsed * 1e9 / count;
+		}
+	}
+}
+
+/*******************************************************************************
+ * Test table.
+*******************************************************************************/
+
+static const struct Test tests[] = {
+	{ "fast_sincos", check_fast_sincos, 2e-7, bench_fast_sincos },
+	{ "fast_sincos_poly", check_fast_sincos_poly, 2e-7, bench_fast_sincos_poly },
+	{ "fast_sin_cos", check_fast_sin_cos, 2e-7, bench_fast_sin_cos },
+	{ "fast_sincos_batch", check_fast_sincos_batch, 2e-7, bench_fast_sincos_batch },
+	{ "libm_sincos", check_libm_sincos, 2e-7, bench_libm_sincos },
+	{ "mat_mul", check_mat_mul, 1e-6, bench_mat_mul },
+	{ "mat_imul", check_mat_imul, 1e-6, bench_mat_imul },
+	{ "mat_mulv", check_mat_mulv, 1e-6, bench_mat_mulv },
+	{ "mat_rotate", check_mat_rotate, 1e-6, bench_mat_rotate },
+	{ "mat_rotatev", check_mat_rotatev, 1e-6, bench_mat_rotatev },
+	{ "mat_rotateq", check_mat_rotateq, 1e-6, bench_mat_rotateq },
+	{ "mat_get_rotation", check_mat_get_rotation, 1e-6, bench_mat_get_rotation },
+	{ "mat_scale", check_mat_scale, 1e-6, bench_mat_scale },
+	{ "mat_scalev", check_mat_scalev, 1e-6, bench_mat_scalev },
+	{ "mat_get_scale", check_mat_get_scale, 1e-6, bench_mat_get_scale },
+	{ "mat_translate", check_mat_translate, 1e-6, bench_mat_translate },
+	{ "mat_translatev", check_mat_translatev, 1e-6, bench_mat_translatev },
+	{ "mat_get_translation", check_mat_get_translation, 1e-6, bench_mat_get_translation },
+	{ "mat_lookat", check_mat_lookat, 1e-5, bench_mat_lookat },
+	{ "mat_lookatv", check_mat_lookatv, 1e-5, bench_mat_lookatv },
+	{ "mat_ortho", check_mat_ortho, 1e-6, bench_mat_ortho },
+	{ "mat_persp", check_mat_persp, 1e-6, bench_mat_persp },
+	{ "mat_ident", check_mat_ident, 0, bench_mat_ident },
+	{ "mat_inverse", check_mat_inverse, 1e-6, bench_mat_inverse },
+	{ "mat_transpose", check_mat_transpose, 0, bench_mat_transpose },
+	{ "vec", check_vec, 0, bench_vec },
+	{ "vec_add", check_vec_add, 1e-6, bench_vec_add },
+	{ "vec_addf", check_vec_addf, 1e-6, bench_vec_addf },
+	{ "vec_sub", check_vec_sub, 1e-6, bench_vec_sub },
+	{ "vec_subf", check_vec_subf, 1e-6, bench_vec_subf },
+	{ "vec_mulf", check_vec_mulf, 1e-6, bench_vec_mulf },
+	{ "vec_dot", check_vec_dot, 1e-6, bench_vec_dot },
+	{ "vec_mag", check_vec_mag, 1e-6, bench_vec_mag },
+	{ "vec_cross", check_vec_cross, 1e-6, bench_vec_cross },
+	{ "vec_norm", check_vec_norm, 1e-6, bench_vec_norm },
+	{ "vec_clamp", check_vec_clamp, 1e-6, bench_vec_clamp },
+	{ "vec_lerp", check_vec_lerp, 1e-6, bench_vec_lerp },
+	{ "vec2_add_sub_mulf", check_vec2_arithmetic, 1e-6, bench_vec2_arithmetic },
+	{ "vec2_dot_mag", check_vec2_dot_mag, 1e-6, bench_vec2_dot_mag },
+	{ "vec2_lerp", check_vec2_lerp, 1e-6, bench_vec2_lerp },
+	{ "vec2_madd_batch", check_vec2_madd_batch, 1e-6, bench_vec2_madd_batch },
+	{ "affine2_ident", check_affine2_ident, 0, bench_affine2_ident },
+	{ "affine2_mul", check_affine2_mul, 1e-6, bench_affine2_mul },
+	{ "affine2_translate", check_affine2_translate, 1e-6, bench_affine2_translate },
+	{ "affine2_rotate_sc", check_affine2_rotate_sc, 1e-6, bench_affine2_rotate_sc },
+	{ "affine2_rotate", check_affine2_rotate, 1e-6, bench_affine2_rotate },
+	{ "affine2_scale", check_affine2_scale, 1e-6, bench_affine2_scale },
+	{ "affine2_apply", check_affine2_apply, 1e-6, bench_affine2_apply },
+	{ "affine2_to_mat", check_affine2_to_mat, 0, bench_affine2_to_mat },
+	{ "qtr", check_qtr, 0, bench_qtr },
+	{ "qtr_rotate", check_qtr_rotate, 1e-6, bench_qtr_rotate },
+	{ "qtr_rotatev", check_qtr_rotatev, 1e-6, bench_qtr_rotatev },
+	{ "qtr_add", check_qtr_add, 1e-6, bench_qtr_add },
+	{ "qtr_mul", check_qtr_mul, 1e-6, bench_qtr_mul },
+	{ "qtr_mulf", check_qtr_mulf, 1e-6, bench_qtr_mulf },
+	{ "qtr_norm", check_qtr_norm, 1e-6, bench_qtr_norm },
+	{ "qtr_lerp", check_qtr_lerp, 1e-6, bench_qtr_lerp },
+	{ NULL }
+};
+
+static int
+selected(const char *name, int argc, char *argv[])
+{
+	if (argc < 2) {
+		return 1;
+	}
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(name, argv[i], strlen(argv[i])) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	// fixed seed, for failures to be reproducible
+	srand(1);
+	init_bench_inputs();
+
+	int failed = 0;
+	printf("%-22s %10s %10s %10s\n", "function", "error", "tolerance", "ns/op");
+	for (const struct Test *t = tests; t->name; t++) {
+		if (!selected(t->name, argc, argv)) {
+			continue;
+		}
+		double err = t->check();
+		int ok = err <= t->tolerance;
+		printf(
+			"%-22s %10.2e %10.0e %10.2f%s\n",
+			t->name,
+			err,
+			t->tolerance,
+			measure(t->bench),
+			ok ? "" : "  FAILED"
+		);
+		failed += !ok;
+	}
+
+	if (failed) {
+		printf("%d functions FAILED\n", failed);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,280 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "clock.h"
+#include "error.h"
+#include "memory.h"
+#include "net.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define DELAY_QUEUE_SIZE 256
+
+struct DelayedPacket {
+	double time;           // when to send, 0 if the slot is free
+	struct NetAddress to;
+	size_t size;
+	uint8_t data[NET_MAX_PACKET_SIZE];
+};
+
+struct NetSocket {
+	int fd;
+	struct NetConditions conditions;
+	int simulate;
+	uint32_t rand_state;
+	struct DelayedPacket *delayed;
+	size_t delayed_count;
+};
+
+static void
+to_sockaddr(const struct NetAddress *addr, struct sockaddr_in *sa)
+{
+	memset(sa, 0, sizeof(struct sockaddr_in));
+	sa->sin_family = AF_INET;
+	sa->sin_addr.s_addr = htonl(addr->host);
+	sa->sin_port = htons(addr->port);
+}
+
+int
+net_address_parse(const char *str, struct NetAddress *r_addr)
+{
+	const char *colon = strrchr(str, ':');
+	if (!colon || colon == str || colon[1] == '\0') {
+		fprintf(stderr, "bad address `%s`, expected host:port\n", str);
+		return 0;
+	}
+
+	char host[256];
+	size_t len = colon - str;
+	if (len >= sizeof(host)) {
+		fprintf(stderr, "host name too long\n");
+		return 0;
+	}
+	memcpy(host, str, len);
+	host[len] = '\0';
+
+	struct addrinfo hints = { 0 }, *info;
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	int rc = getaddrinfo(host, colon + 1, &hints, &info);
+	if (rc != 0) {
+		fprintf(stderr, "failed to resolve `%s`: %s\n", str, gai_strerror(rc));
+		return 0;
+	}
+	struct sockaddr_in *sa = (struct sockaddr_in*)info->ai_addr;
+	r_addr->host = ntohl(sa->sin_addr.s_addr);
+	r_addr->port = ntohs(sa->sin_port);
+	freeaddrinfo(info);
+	return 1;
+}
+
+int
+net_address_equal(const struct NetAddress *a, const struct NetAddress *b)
+{
+	return a->host == b->host && a->port == b->port;
+}
+
+struct NetSocket*
+net_socket_new(uint16_t port, const struct NetConditions *conditions)
+{
+	struct NetSocket *sock = make(struct NetSocket);
+	if (!sock) {
+		return NULL;
+	}
+	sock->fd = -1;
+
+	sock->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock->fd < 0) {
+		fprintf(stderr, "failed to create socket: %s\n", strerror(errno));
+		error(ERR_NET);
+		goto error;
+	}
+
+	struct sockaddr_in sa;
+	struct NetAddress any = { INADDR_ANY, port };
+	to_sockaddr(&any, &sa);
+	if (bind(sock->fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+		fprintf(stderr, "failed to bind port %u: %s\n", port, strerror(errno));
+		error(ERR_NET);
+		goto error;
+	}
+
+	int flags = fcntl(sock->fd, F_GETFL, 0);
+	if (flags < 0 || fcntl(sock->fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+		fprintf(stderr, "failed to make socket non-blocking\n");
+		error(ERR_NET);
+		goto error;
+	}
+
+	if (conditions && (
+	    conditions->loss > 0 ||
+	    conditions->latency > 0 ||
+	    conditions->jitter > 0)) {
+		sock->delayed = malloc(sizeof(struct DelayedPacket) * DELAY_QUEUE_SIZE);
+		if (!sock->delayed) {
+			error(ERR_NO_MEM);
+			goto error;
+		}
+		for (size_t i = 0; i < DELAY_QUEUE_SIZE; i++) {
+			sock->delayed[i].time = 0;
+		}
+		sock->conditions = *conditions;
+		sock->simulate = 1;
+		sock->rand_state = 0x9e3779b9u ^ port;
+	}
+
+	return sock;
+
+error:
+	net_socket_destroy(sock);
+	return NULL;
+}
+
+void
+net_socket_destroy(struct NetSocket *sock)
+{
+	if (sock) {
+		if (sock->fd >= 0) {
+			close(sock->fd);
+		}
+		free(sock->delayed);
+		destroy(sock);
+	}
+}
+
+/**
+ * Uniform random number in [0, 1).
+ */
+static float
+random_unit(struct NetSocket *sock)
+{
+	// xorshift32, predictable runs make for reproducible tests
+	uint32_t x = sock->rand_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	sock->rand_state = x;
+	return (x >> 8) / (float)(1 << 24);
+}
+
+static int
+send_now(
+	struct NetSocket *sock,
+	const struct NetAddress *to,
+	const void *data,
+	size_t size
+) {
+	struct sockaddr_in sa;
+	to_sockaddr(to, &sa);
+	ssize_t sent = sendto(
+		sock->fd,
+		data,
+		size,
+		0,
+		(struct sockaddr*)&sa,
+		sizeof(sa)
+	);
+	if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+		// the packet is lost, as any other UDP packet could be
+		fprintf(stderr, "failed to send packet: %s\n", strerror(errno));
+	}
+	return 1;
+}
+
+int
+net_flush(struct NetSocket *sock)
+{
+	if (!sock->delayed_count) {
+		return 1;
+	}
+
+	double now = clock_now();
+	for (size_t i = 0; i < DELAY_QUEUE_SIZE; i++) {
+		struct DelayedPacket *pkt = &sock->delayed[i];
+		if (pkt->time != 0 && pkt->time <= now) {
+			send_now(sock, &pkt->to, pkt->data, pkt->size);
+			pkt->time = 0;
+			sock->delayed_count--;
+		}
+	}
+	return 1;
+}
+
+int
+net_send(
+	struct NetSocket *sock,
+	const struct NetAddress *to,
+	const void *data,
+	size_t size
+) {
+	assert(size <= NET_MAX_PACKET_SIZE);
+
+	if (!sock->simulate) {
+		return send_now(sock, to, data, size);
+	}
+
+	net_flush(sock);
+
+	if (random_unit(sock) < sock->conditions.loss) {
+		return 1;
+	}
+
+	// a full queue drops the packet, just like an overflowing router
+	if (sock->delayed_count == DELAY_QUEUE_SIZE) {
+		return 1;
+	}
+
+	struct DelayedPacket *pkt = sock->delayed;
+	while (pkt->time != 0) {
+		pkt++;
+	}
+	pkt->time = (
+		clock_now() +
+		sock->conditions.latency +
+		sock->conditions.jitter * random_unit(sock)
+	);
+	pkt->to = *to;
+	pkt->size = size;
+	memcpy(pkt->data, data, size);
+	sock->delayed_count++;
+	return 1;
+}
+
+int
+net_recv(
+	struct NetSocket *sock,
+	struct NetAddress *r_from,
+	void *buf,
+	size_t size
+) {
+	net_flush(sock);
+
+	struct sockaddr_in sa;
+	socklen_t sa_len = sizeof(sa);
+	ssize_t len = recvfrom(
+		sock->fd,
+		buf,
+		size,
+		0,
+		(struct sockaddr*)&sa,
+		&sa_len
+	);
+	if (len < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNREFUSED) {
+			return 0;
+		}
+		fprintf(stderr, "failed to receive packet: %s\n", strerror(errno));
+		error(ERR_NET);
+		return -1;
+	}
+	r_from->host = ntohl(sa.sin_addr.s_addr);
+	r_from->port = ntohs(sa.sin_port);
+	return (int)len;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NET_MAX_PACKET_SIZE 1400
+
+/**
+ * IPv4 endpoint, in host byte order.
+ */
+struct NetAddress {
+	uint32_t host;
+	uint16_t port;
+};
+
+/**
+ * Simulated network conditions.
+ *
+ * Applied to outgoing packets, so that the effects of a bad network can be
+ * observed on loopback. Zeroed conditions are a perfect network.
+ */
+struct NetConditions {
+	float loss;      // probability of a packet being dropped, 0 to 1
+	float latency;   // one way delay, in seconds
+	float jitter;    // maximum random delay added to latency, in seconds
+};
+
+/**
+ * Non-blocking UDP socket.
+ */
+struct NetSocket;
+
+/**
+ * Parse a `host:port` string.
+ */
+int
+net_address_parse(const char *str, struct NetAddress *r_addr);
+
+int
+net_address_equal(const struct NetAddress *a, const struct NetAddress *b);
+
+/**
+ * Open a socket bound to given port, or to any port if zero.
+ *
+ * Conditions, if not NULL, are applied to every packet sent.
+ */
+struct NetSocket*
+net_socket_new(uint16_t port, const struct NetConditions *conditions);
+
+void
+net_socket_destroy(struct NetSocket *sock);
+
+/**
+ * Send a packet of at most `NET_MAX_PACKET_SIZE` bytes.
+ */
+int
+net_send(
+	struct NetSocket *sock,
+	const struct NetAddress *to,
+	const void *data,
+	size_t size
+);
+
+/**
+ * Receive a packet, if any.
+ *
+ * Returns the size of received packet, 0 if there's none pending or -1 on
+ * failure.
+ */
+int
+net_recv(
+	struct NetSocket *sock,
+	struct NetAddress *r_from,
+	void *buf,
+	size_t size
+);
+
+/**
+ * Send delayed packets which are due.
+ *
+ * Called by `net_send()` and `net_recv()`, thus, needed only when there is
+ * nothing else to do with the socket.
+ */
+int
+net_flush(struct NetSocket *sock);
@@ -0,0 +1,504 @@
+#include "clock.h"
+#include "error.h"
+#include "memory.h"
+#include "netgame.h"
+#include "script.h"
+#include "snapshot.h"
+#include <SDL.h>
+#include <assert.h>
+#include <math.h>
+#include <signal.h>
+#include <stdlib.h>
+
+enum {
+	PACKET_INPUT = 1,
+	PACKET_SNAPSHOT,
+};
+
+/**
+ * Snapshot history slot, indexed by sequence number.
+ */
+struct SnapshotSlot {
+	int valid;
+	uint16_t seq;
+	struct Snapshot snap;
+};
+
+/**
+ * Server side client state.
+ */
+struct RemoteClient {
+	int active;
+	struct NetAddress addr;
+	double last_heard;
+	int actions;
+	int has_ack;
+	uint16_t ack;        // newest snapshot the client has
+	uint16_t seq;        // sequence number of the next snapshot
+	size_t cursor;       // where the next snapshot starts its updates
+	struct SnapshotSlot sent[SNAPSHOT_HISTORY];
+};
+
+struct NetClient {
+	struct NetSocket *sock;
+	struct NetAddress server;
+	struct SnapshotSlot received[SNAPSHOT_HISTORY];
+	struct Snapshot empty;
+	int has_ack;
+	uint16_t ack;
+	int has_tick;
+	uint32_t latest_tick;
+	double render_tick;
+	struct WorldFrame frame;
+};
+
+static volatile sig_atomic_t interrupted = 0;
+
+/**
+ * Tell whether sequence number `a` is more recent than `b`, with wrap around.
+ */
+static int
+seq_newer(uint16_t a, uint16_t b)
+{
+	return (int16_t)(uint16_t)(a - b) > 0;
+}
+
+static struct SnapshotSlot*
+find_slot(struct SnapshotSlot *history, uint16_t seq)
+{
+	struct SnapshotSlot *slot = &history[seq % SNAPSHOT_HISTORY];
+	return slot->valid && slot->seq == seq ? slot : NULL;
+}
+
+static void
+release_history(struct SnapshotSlot *history)
+{
+	for (size_t i = 0; i < SNAPSHOT_HISTORY; i++) {
+		snapshot_release(&history[i].snap);
+		history[i].valid = 0;
+	}
+}
+
+/*** SERVER ***/
+
+static void
+handle_interrupt(int sig)
+{
+	interrupted = 1;
+}
+
+static struct RemoteClient*
+get_client(struct RemoteClient *clients, const struct NetAddress *addr)
+{
+	struct RemoteClient *free_client = NULL;
+	for (size_t i = 0; i < NETGAME_MAX_CLIENTS; i++) {
+		if (!clients[i].active) {
+			if (!free_client) {
+				free_client = &clients[i];
+			}
+		} else if (net_address_equal(&clients[i].addr, addr)) {
+			return &clients[i];
+		}
+	}
+
+	if (free_client) {
+		free_client->active = 1;
+		free_client->addr = *addr;
+		free_client->actions = 0;
+		free_client->has_ack = 0;
+		free_client->cursor = 0;
+		printf(
+			"client %u.%u.%u.%u:%u connected\n",
+			addr->host >> 24,
+			(addr->host >> 16) & 0xff,
+			(addr->host >> 8) & 0xff,
+			addr->host & 0xff,
+			addr->port
+		);
+	}
+	return free_client;
+}
+
+/**
+ * Get the client which controls the player, if any.
+ */
+static struct RemoteClient*
+get_owner(struct RemoteClient *clients)
+{
+	for (size_t i = 0; i < NETGAME_MAX_CLIENTS; i++) {
+		if (clients[i].active) {
+			return &clients[i];
+		}
+	}
+	return NULL;
+}
+
+static int
+receive_inputs(
+	struct NetSocket *sock,
+	struct RemoteClient *clients,
+	struct World *world
+) {
+	uint8_t buf[NET_MAX_PACKET_SIZE];
+	struct NetAddress from;
+	int len;
+	while ((len = net_recv(sock, &from, buf, sizeof(buf))) > 0) {
+		struct BitReader r;
+		bit_reader_init(&r, buf, len);
+		if (bit_read(&r, 8) != PACKET_INPUT) {
+			continue;
+		}
+		int has_ack = bit_read(&r, 1);
+		uint16_t ack = has_ack ? bit_read(&r, 16) : 0;
+		int actions = bit_read(&r, ACTION_BITS);
+		if (r.overflow) {
+			continue;
+		}
+
+		struct RemoteClient *client = get_client(clients, &from);
+		if (!client) {
+			// server is full
+			continue;
+		}
+		client->last_heard = clock_now();
+		client->actions = actions;
+		if (has_ack && (!client->has_ack || seq_newer(ack, client->ack))) {
+			client->has_ack = 1;
+			client->ack = ack;
+		}
+	}
+
+	// drop clients which went silent
+	double now = clock_now();
+	for (size_t i = 0; i < NETGAME_MAX_CLIENTS; i++) {
+		if (clients[i].active &&
+		    now - clients[i].last_heard > NETGAME_TIMEOUT) {
+			printf("client %zu timed out\n", i);
+			clients[i].active = 0;
+			release_history(clients[i].sent);
+		}
+	}
+
+	// apply the owner's actions to the player
+	struct RemoteClient *owner = get_owner(clients);
+	world_set_actions(world, owner ? owner->actions : 0);
+
+	return len >= 0;
+}
+
+static int
+send_snapshot(
+	struct NetSocket *sock,
+	struct RemoteClient *client,
+	const struct Snapshot *snap
+) {
+	// the baseline is the newest acknowledged snapshot, as long as it's
+	// still in the history
+	static const struct Snapshot empty = { 0 };
+	const struct Snapshot *base = &empty;
+	struct SnapshotSlot *base_slot = NULL;
+	if (client->has_ack &&
+	    (uint16_t)(client->seq - client->ack) < SNAPSHOT_HISTORY) {
+		base_slot = find_slot(client->sent, client->ack);
+	}
+	if (base_slot) {
+		base = &base_slot->snap;
+	}
+
+	uint8_t buf[NETGAME_SNAPSHOT_BUDGET];
+	struct BitWriter w;
+	bit_writer_init(&w, buf, sizeof(buf));
+	bit_write(&w, PACKET_SNAPSHOT, 8);
+	bit_write(&w, client->seq, 16);
+	bit_write(&w, base_slot != NULL, 1);
+	if (base_slot) {
+		bit_write(&w, base_slot->seq, 16);
+	}
+
+	struct SnapshotSlot *slot = &client->sent[client->seq % SNAPSHOT_HISTORY];
+	slot->valid = 0;
+	if (!snapshot_encode(base, snap, &client->cursor, &w, &slot->snap)) {
+		return 0;
+	}
+	slot->valid = 1;
+	slot->seq = client->seq++;
+
+	return net_send(sock, &client->addr, buf, bit_writer_bytes(&w));
+}
+
+int
+server_run(uint16_t port, const struct NetConditions *conditions)
+{
+	int ok = 1;
+	struct NetSocket *sock = NULL;
+	struct World *world = NULL;
+	struct ScriptEnv *env = NULL;
+	struct RemoteClient *clients = NULL;
+	struct WorldFrame frame = { 0 };
+	struct Snapshot snap = { 0 };
+
+	if (!(sock = net_socket_new(port, conditions)) ||
+	    !(clients = alloc0(sizeof(struct RemoteClient) * NETGAME_MAX_CLIENTS)) ||
+	    !(world = world_new()) ||
+	    !(env = script_env_new())) {
+		ok = 0;
+		goto cleanup;
+	}
+
+	if (!script_env_init(env, world) ||
+	    !script_env_load_file(env, "data/scripts/game.lua") ||
+	    !script_env_tick(env)) {
+		ok = 0;
+		goto cleanup;
+	}
+
+	signal(SIGINT, handle_interrupt);
+	printf("serving on port %u\n", port);
+
+	int run = 1;
+	uint32_t tick = 0;
+	float script_tick = 0;
+	double next_tick = clock_now();
+	while (ok && run && !interrupted) {
+		ok &= receive_inputs(sock, clients, world);
+
+		// advance the world by exactly one step
+		run &= world_update(world, SIMULATION_STEP);
+		script_tick += SIMULATION_STEP;
+		while (script_tick >= TICK) {
+			script_tick -= TICK;
+			ok &= script_env_tick(env);
+		}
+
+		// send the new state to everyone
+		ok &= (
+			world_extract(world, &frame) &&
+			snapshot_capture(&snap, &frame, tick++)
+		);
+		for (size_t i = 0; ok && i < NETGAME_MAX_CLIENTS; i++) {
+			if (clients[i].active) {
+				ok &= send_snapshot(sock, &clients[i], &snap);
+			}
+		}
+
+		// wait for the next tick, or skip the missed ones if the server
+		// fell too far behind
+		next_tick += SIMULATION_STEP;
+		double now = clock_now();
+		if (now - next_tick > 1.0) {
+			next_tick = now;
+		}
+		while ((now = clock_now()) < next_tick) {
+			net_flush(sock);
+			SDL_Delay(1);
+		}
+	}
+
+	signal(SIGINT, SIG_DFL);
+
+cleanup:
+	if (clients) {
+		for (size_t i = 0; i < NETGAME_MAX_CLIENTS; i++) {
+			release_history(clients[i].sent);
+		}
+		destroy(clients);
+	}
+	snapshot_release(&snap);
+	world_frame_release(&frame);
+	script_env_destroy(env);
+	world_destroy(world);
+	net_socket_destroy(sock);
+	return ok;
+}
+
+/*** CLIENT ***/
+
+struct NetClient*
+net_client_new(const char *address, const struct NetConditions *conditions)
+{
+	struct NetClient *client = make(struct NetClient);
+	if (!client) {
+		return NULL;
+	}
+
+	if (!net_address_parse(address, &client->server)) {
+		error(ERR_NET);
+		goto error;
+	}
+
+	if (!(client->sock = net_socket_new(0, conditions))) {
+		goto error;
+	}
+
+	return client;
+
+error:
+	net_client_destroy(client);
+	return NULL;
+}
+
+void
+net_client_destroy(struct NetClient *client)
+{
+	if (client) {
+		release_history(client->received);
+		world_frame_release(&client->frame);
+		net_socket_destroy(client->sock);
+		destroy(client);
+	}
+}
+
+static void
+handle_snapshot(struct NetClient *client, struct BitReader *r)
+{
+	uint16_t seq = bit_read(r, 16);
+	int has_base = bit_read(r, 1);
+	uint16_t base_seq = has_base ? bit_read(r, 16) : 0;
+	if (r->overflow) {
+		return;
+	}
+
+	// drop stale packets, and those based on snapshots we no longer have
+	struct SnapshotSlot *slot = &client->received[seq % SNAPSHOT_HISTORY];
+	if (slot->valid && !seq_newer(seq, slot->seq)) {
+		return;
+	}
+	const struct Snapshot *base = &client->empty;
+	if (has_base) {
+		struct SnapshotSlot *base_slot = find_slot(client->received, base_seq);
+		if (!base_slot || base_slot == slot) {
+			return;
+		}
+		base = &base_slot->snap;
+	}
+
+	slot->valid = 0;
+	if (!snapshot_decode(base, r, &slot->snap)) {
+		fprintf(stderr, "malformed snapshot %u\n", seq);
+		return;
+	}
+	slot->valid = 1;
+	slot->seq = seq;
+
+	if (!client->has_ack || seq_newer(seq, client->ack)) {
+		client->has_ack = 1;
+		client->ack = seq;
+	}
+	if (!client->has_tick || slot->snap.tick > client->latest_tick) {
+		if (!client->has_tick) {
+			client->render_tick = (
+				(double)slot->snap.tick -
+				NETGAME_INTERP_DELAY
+			);
+		}
+		client->has_tick = 1;
+		client->latest_tick = slot->snap.tick;
+	}
+}
+
+/**
+ * Advance render time, slowly drifting it towards the interpolation delay
+ * behind the newest snapshot, so that jitter doesn't make motion stutter.
+ */
+static void
+advance_render_tick(struct NetClient *client, float dt)
+{
+	double target = (double)client->latest_tick - NETGAME_INTERP_DELAY;
+	client->render_tick += dt / SIMULATION_STEP;
+	double drift = target - client->render_tick;
+	if (fabs(drift) > NETGAME_INTERP_DELAY * 3) {
+		client->render_tick = target;
+	} else {
+		client->render_tick += drift * 0.05;
+	}
+	if (client->render_tick > client->latest_tick) {
+		client->render_tick = client->latest_tick;
+	}
+}
+
+static int
+interpolate(struct NetClient *client)
+{
+	// find the snapshots around render time
+	const struct Snapshot *a = NULL, *b = NULL, *oldest = NULL;
+	for (size_t i = 0; i < SNAPSHOT_HISTORY; i++) {
+		const struct SnapshotSlot *slot = &client->received[i];
+		if (!slot->valid) {
+			continue;
+		}
+		const struct Snapshot *s = &slot->snap;
+		if (s->tick <= client->render_tick) {
+			if (!a || s->tick > a->tick) {
+				a = s;
+			}
+		} else if (!b || s->tick < b->tick) {
+			b = s;
+		}
+		if (!oldest || s->tick < oldest->tick) {
+			oldest = s;
+		}
+	}
+
+	if (!a) {
+		a = oldest;
+	}
+	float t = 0;
+	if (!b) {
+		b = a;
+	} else if (b->tick > a->tick) {
+		t = (client->render_tick - a->tick) / (b->tick - a->tick);
+		t = t < 0 ? 0 : t;
+	}
+
+	return snapshot_interpolate(a, b, t, &client->frame);
+}
+
+int
+net_client_update(
+	struct NetClient *client,
+	float dt,
+	int actions,
+	const struct WorldFrame **r_frame
+) {
+	*r_frame = &client->frame;
+
+	// receive snapshots
+	uint8_t buf[NET_MAX_PACKET_SIZE];
+	struct NetAddress from;
+	int len;
+	while ((len = net_recv(client->sock, &from, buf, sizeof(buf))) > 0) {
+		struct BitReader r;
+		bit_reader_init(&r, buf, len);
+		if (net_address_equal(&from, &client->server) &&
+		    bit_read(&r, 8) == PACKET_SNAPSHOT) {
+			handle_snapshot(client, &r);
+		}
+	}
+	if (len < 0) {
+		return 0;
+	}
+
+	// send actions along with the acknowledgement, which doubles as
+	// a keep-alive
+	uint8_t packet[8];
+	struct BitWriter w;
+	bit_writer_init(&w, packet, sizeof(packet));
+	bit_write(&w, PACKET_INPUT, 8);
+	bit_write(&w, client->has_ack, 1);
+	if (client->has_ack) {
+		bit_write(&w, client->ack, 16);
+	}
+	bit_write(&w, actions, ACTION_BITS);
+	if (!net_send(client->sock, &client->server, packet, bit_writer_bytes(&w))) {
+		return 0;
+	}
+
+	// nothing to show until the first snapshot arrives
+	if (!client->has_tick) {
+		client->frame.renderable_count = 0;
+		return 1;
+	}
+
+	advance_render_tick(client, dt);
+	return interpolate(client);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "game.h"
+#include "net.h"
+
+#define NETGAME_MAX_CLIENTS 8
+#define NETGAME_TIMEOUT 5.0              // seconds
+#define NETGAME_SNAPSHOT_BUDGET 1024     // bytes per snapshot packet
+#define NETGAME_INTERP_DELAY 3           // ticks
+
+/**
+ * Run a headless authoritative game server until interrupted.
+ *
+ * The world is simulated at `SIMULATION_STEP` ticks and a snapshot is sent
+ * to each client every tick, delta compressed against the last snapshot the
+ * client acknowledged. Snapshot packets never exceed
+ * `NETGAME_SNAPSHOT_BUDGET` bytes, so bandwidth per client stays bounded no
+ * matter the number of entities; entities which don't fit are updated in
+ * the following ticks. The first client to connect controls the player, the
+ * others spectate.
+ */
+int
+server_run(uint16_t port, const struct NetConditions *conditions);
+
+/**
+ * Game client.
+ *
+ * Sends player actions to the server and reconstructs the frames to render
+ * from received snapshots, interpolating `NETGAME_INTERP_DELAY` ticks
+ * behind the newest one.
+ */
+struct NetClient;
+
+struct NetClient*
+net_client_new(const char *address, const struct NetConditions *conditions);
+
+void
+net_client_destroy(struct NetClient *client);
+
+/**
+ * Exchange packets with the server and advance the client by given delta
+ * time.
+ *
+ * `r_frame` is set to the frame to render, which stays valid until the next
+ * update.
+ */
+int
+net_client_update(
+	struct NetClient *client,
+	float dt,
+	int actions,
+	const struct WorldFrame **r_frame
+);
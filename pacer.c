@@ -0,0 +1,117 @@
+#include "clock.h"
+#include "error.h"
+#include "pacer.h"
+#include <SDL.h>
+#include <assert.h>
+
+#define PACER_SPIN_TIME 0.002          // seconds
+#define PACER_VSYNC_TOLERANCE 1.5      // fraction of a refresh period
+
+static const char *mode_names[] = {
+	"unlimited",
+	"vsync",
+	"adaptive vsync",
+	"fixed",
+};
+
+int
+pacer_init(struct FramePacer *pacer, int mode, float fps)
+{
+	assert(pacer != NULL);
+	assert(fps > 0);
+
+	int interval = 0;
+	switch (mode) {
+	case PACE_MODE_VSYNC:
+		interval = 1;
+		break;
+	case PACE_MODE_ADAPTIVE_VSYNC:
+		interval = -1;
+		break;
+	}
+
+	// headless renderer has no window, whose vsync to turn off
+	if (interval == 0 && !SDL_GL_GetCurrentContext()) {
+		goto done;
+	}
+
+	if (SDL_GL_SetSwapInterval(interval) != 0) {
+		if (mode != PACE_MODE_ADAPTIVE_VSYNC) {
+			fprintf(
+				stderr,
+				"failed to set swap interval: %s\n",
+				SDL_GetError()
+			);
+			error(ERR_SDL);
+			return 0;
+		}
+
+		// late swap tearing is not supported, fall back to vsync
+		return pacer_init(pacer, PACE_MODE_VSYNC, fps);
+	}
+
+done:
+	pacer->mode = mode;
+	pacer->period = 1.0 / fps;
+	pacer->last = clock_now();
+	pacer->deadline = pacer->last + pacer->period;
+	pacer->frames = 0;
+	pacer->missed = 0;
+
+	printf("frame pacing: %s (%.1f FPS)\n", mode_names[mode], fps);
+
+	return 1;
+}
+
+static void
+wait_until(double deadline)
+{
+	// sleep while the scheduler can be trusted and spin the rest
+	double remaining = deadline - clock_now() - PACER_SPIN_TIME;
+	if (remaining > 0) {
+		SDL_Delay(remaining * 1000);
+	}
+	while (clock_now() < deadline);
+}
+
+int
+pacer_end_frame(struct FramePacer *pacer)
+{
+	assert(pacer != NULL);
+
+	double now = clock_now();
+	int missed = 0;
+
+	switch (pacer->mode) {
+	case PACE_MODE_VSYNC:
+	case PACE_MODE_ADAPTIVE_VSYNC:
+		// the swap blocks until vertical blank, thus, a frame which
+		// took noticeably longer than a refresh period missed one
+		missed = now - pacer->last > pacer->period * PACER_VSYNC_TOLERANCE;
+		break;
+	case PACE_MODE_FIXED:
+		missed = now > pacer->deadline;
+		if (missed && now - pacer->deadline > pacer->period) {
+			// more than a whole frame late, don't try to catch
+			// up, restart the schedule from now
+			pacer->deadline = now;
+		} else {
+			wait_until(pacer->deadline);
+		}
+		pacer->deadline += pacer->period;
+		now = clock_now();
+		break;
+	}
+
+	pacer->last = now;
+	pacer->frames++;
+	pacer->missed += missed;
+	return !missed;
+}
+
+const char*
+pacer_mode_name(int mode)
+{
+	assert(mode >= PACE_MODE_UNLIMITED && mode <= PACE_MODE_FIXED);
+	return mode_names[mode];
+}
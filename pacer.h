@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+ * Frame pacing modes.
+ */
+enum {
+	// present immediately and run as fast as possible, for benchmarking
+	PACE_MODE_UNLIMITED,
+	// wait for vertical blank on present
+	PACE_MODE_VSYNC,
+	// wait for vertical blank, unless the frame is late; falls back to
+	// plain vsync if the driver doesn't support late swap tearing
+	PACE_MODE_ADAPTIVE_VSYNC,
+	// present immediately and sleep until the target frame time elapses
+	PACE_MODE_FIXED,
+};
+
+/**
+ * Frame pacer.
+ */
+struct FramePacer {
+	int mode;
+	double period;      // target frame duration, in seconds
+	double deadline;    // timestamp by which the current frame must end
+	double last;        // timestamp of the previous frame end
+	unsigned long frames;
+	unsigned long missed;
+};
+
+/**
+ * Initialize a frame pacer.
+ *
+ * The `fps` argument is the target frame rate for fixed mode and the display
+ * refresh rate for vsync modes, where it's used to detect missed vertical
+ * blanks. Must be called when the OpenGL context is current.
+ */
+int
+pacer_init(struct FramePacer *pacer, int mode, float fps);
+
+/**
+ * End a frame, right after presenting it.
+ *
+ * In fixed mode, sleeps until the frame deadline, then spins for the last
+ * couple of milliseconds to compensate the coarse scheduler granularity.
+ * Returns 0 if the frame missed its deadline, 1 otherwise.
+ */
+int
+pacer_end_frame(struct FramePacer *pacer);
+
+/**
+ * Get the name of given pacing mode.
+ */
+const char*
+pacer_mode_name(int mode);
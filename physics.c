@@ -1,22 +1,24 @@
-#include "list.h"
-#include "math.h"
+#include "error.h"
+#include "memory.h"
 #include "physics.h"
-#include "utils.h"
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define BODIES_BASE_SIZE 64
+
+#if BODIES_BASE_SIZE % COLLISION_BLOCK_SIZE
+#error "BODIES_BASE_SIZE must be a multiple of COLLISION_BLOCK_SIZE"
+#endif
 
 struct SimulationSystem*
 sim_new(void)
 {
-	struct SimulationSystem *sys = malloc(sizeof(struct SimulationSystem));
+	struct SimulationSystem *sys = make(struct SimulationSystem);
 	if (!sys) {
 		return NULL;
 	}
-	if (!(sys->body_list = list_new())) {
-		free(sys);
-		return NULL;
-	}
-	sys->handler_count = 0;
 	return sys;
 }
 
@@ -24,16 +26,84 @@ void
 sim_destroy(struct SimulationSystem *sys)
 {
 	if (sys) {
-		list_destroy(sys->body_list);
-		free(sys);
+		free(sys->bodies);
+		free(sys->body_ids);
+		free(sys->slots);
+		free(sys->shape_x);
+		free(sys->shape_y);
+		free(sys->shape_radius);
+		free(sys->shape_type);
+		free(sys->shape_mask);
+		free(sys->shape_hit);
+		destroy(sys);
 	}
 }
 
+#ifdef PHYSICS_FIXED_POINT
+
 static inline int
-check_collision(struct Body *a, struct Body *b)
+check_collision(Scalar dx, Scalar dy, Scalar r)
+{
+	// clamping to the radius sum doesn't change the outcome, as a distance
+	// that large on either axis is never a collision, but keeps the
+	// squares from overflowing
+	int64_t cx = dx < -r ? -r : (dx > r ? r : dx);
+	int64_t cy = dy < -r ? -r : (dy > r ? r : dy);
+	return cx * cx + cy * cy < (int64_t)r * r;
+}
+
+#else
+
+static inline int
+check_collision(Scalar dx, Scalar dy, Scalar r)
+{
+	return dx * dx + dy * dy < r * r;
+}
+
+#endif
+
+/**
+ * Test a body against all candidates.
+ *
+ * Sets the hit flag of each candidate colliding with given body. The loop is
+ * free of branches and works on packed shape arrays, so that the compiler can
+ * run it at SIMD width.
+ */
+static void
+collide_shapes(
+	struct SimulationSystem *sys,
+	size_t padded,
+	const struct Body *body
+) {
+	const Scalar *restrict x = sys->shape_x;
+	const Scalar *restrict y = sys->shape_y;
+	const Scalar *restrict radius = sys->shape_radius;
+	const int *restrict type = sys->shape_type;
+	const int *restrict mask = sys->shape_mask;
+	int *restrict hit = sys->shape_hit;
+	Scalar bx = body->x, by = body->y, br = body->radius;
+	int btype = body->type, bmask = body->collision_mask;
+
+	for (size_t k = 0; k < padded; k++) {
+		hit[k] = (
+			((btype & mask[k]) != 0) &
+			((type[k] & bmask) != 0) &
+			check_collision(bx - x[k], by - y[k], br + radius[k])
+		);
+	}
+}
+
+/**
+ * Pack hit flags of a block of candidates into a bitmask.
+ */
+static inline unsigned
+block_hits(const int *hit)
 {
-	float dist = sqrt(powf(a->x - b->x, 2) + powf(a->y - b->y, 2));
-	return dist < a->radius + b->radius;
+	unsigned hits = 0;
+	for (unsigned k = 0; k < COLLISION_BLOCK_SIZE; k++) {
+		hits |= (unsigned)hit[k] << k;
+	}
+	return hits;
 }
 
 static int
@@ -53,42 +123,150 @@ dispatch_collision(struct SimulationSystem *sys, struct Body *a, struct Body *b)
 int
 sim_step(struct SimulationSystem *sys, float dt)
 {
-	struct ListNode *node_a = sys->body_list->head;
-	while (node_a) {
-		// move bodies
-		struct Body *a = node_a->data;
-		a->x += a->xvel * dt;
-		a->y += a->yvel * dt;
-
-		// check for collisions
-		struct ListNode *node_b = sys->body_list->head;
-		while (node_b) {
-			struct Body *b = node_b->data;
-			if (a != b &&
-			    a->type & b->collision_mask &&
-			    b->type & a->collision_mask &&
-			    check_collision(a, b)) {
-				if (!dispatch_collision(sys, a, b)) {
+	struct Body *bodies = sys->bodies;
+	size_t count = sys->body_count;
+	Scalar step = scalar_from_float(dt);
+
+	// move bodies
+	for (size_t i = 0; i < count; i++) {
+		bodies[i].x += scalar_mul(bodies[i].xvel, step);
+		bodies[i].y += scalar_mul(bodies[i].yvel, step);
+	}
+
+	// copy shapes for the narrowphase and pad the last block
+	size_t padded = (
+		(count + COLLISION_BLOCK_SIZE - 1) /
+		COLLISION_BLOCK_SIZE *
+		COLLISION_BLOCK_SIZE
+	);
+	for (size_t i = 0; i < count; i++) {
+		sys->shape_x[i] = bodies[i].x;
+		sys->shape_y[i] = bodies[i].y;
+		sys->shape_radius[i] = bodies[i].radius;
+		sys->shape_type[i] = bodies[i].type;
+		sys->shape_mask[i] = bodies[i].collision_mask;
+	}
+	for (size_t i = count; i < padded; i++) {
+		sys->shape_x[i] = sys->shape_y[i] = sys->shape_radius[i] = 0;
+		sys->shape_type[i] = sys->shape_mask[i] = 0;
+	}
+
+	// check for collisions, then walk the hits block-wise and dispatch them
+	for (size_t i = 0; i < count; i++) {
+		struct Body *a = &bodies[i];
+		collide_shapes(sys, padded, a);
+		sys->shape_hit[i] = 0;
+		for (size_t base = 0; base < padded; base += COLLISION_BLOCK_SIZE) {
+			unsigned hits = block_hits(sys->shape_hit + base);
+			for (size_t j = base; hits; j++, hits >>= 1) {
+				if (hits & 1 && !dispatch_collision(sys, a, &bodies[j])) {
 					return 0;
 				}
 			}
-			node_b = node_b->next;
 		}
-		node_a = node_a->next;
 	}
 	return 1;
 }
 
-int
-sim_add_body(struct SimulationSystem *sys, struct Body *body)
+static int
+reserve_body(struct SimulationSystem *sys)
 {
-	return list_add(sys->body_list, body);
+	if (sys->body_count < sys->body_capacity) {
+		return 1;
+	}
+
+	size_t capacity = sys->body_capacity + BODIES_BASE_SIZE;
+	struct Body *bodies = realloc(sys->bodies, sizeof(struct Body) * capacity);
+	if (!bodies) {
+		error(ERR_NO_MEM);
+		return 0;
+	}
+	sys->bodies = bodies;
+
+	BodyID *body_ids = realloc(sys->body_ids, sizeof(BodyID) * capacity);
+	if (!body_ids) {
+		error(ERR_NO_MEM);
+		return 0;
+	}
+	sys->body_ids = body_ids;
+
+	// there's never more handles than bodies
+	size_t *slots = realloc(sys->slots, sizeof(size_t) * capacity);
+	if (!slots) {
+		error(ERR_NO_MEM);
+		return 0;
+	}
+	sys->slots = slots;
+
+	// capacity is always a multiple of block size, so the padding fits
+	Scalar **scalars[] = { &sys->shape_x, &sys->shape_y, &sys->shape_radius };
+	for (size_t i = 0; i < sizeof(scalars) / sizeof(scalars[0]); i++) {
+		Scalar *array = realloc(*scalars[i], sizeof(Scalar) * capacity);
+		if (!array) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		*scalars[i] = array;
+	}
+	int **ints[] = {
+		&sys->shape_type,
+		&sys->shape_mask,
+		&sys->shape_hit
+	};
+	for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+		int *array = realloc(*ints[i], sizeof(int) * capacity);
+		if (!array) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		*ints[i] = array;
+	}
+
+	sys->body_capacity = capacity;
+	return 1;
+}
+
+BodyID
+sim_add_body(struct SimulationSystem *sys, const struct Body *body)
+{
+	assert(body != NULL);
+
+	if (!reserve_body(sys)) {
+		return 0;
+	}
+
+	// take a free handle, or a new one
+	BodyID id;
+	if (sys->free_slot) {
+		id = sys->free_slot;
+		sys->free_slot = sys->slots[id - 1];
+	} else {
+		id = ++sys->slot_count;
+	}
+
+	sys->slots[id - 1] = sys->body_count;
+	sys->body_ids[sys->body_count] = id;
+	sys->bodies[sys->body_count++] = *body;
+	return id;
 }
 
 void
-sim_remove_body(struct SimulationSystem *sys, struct Body *body)
+sim_remove_body(struct SimulationSystem *sys, BodyID id)
 {
-	while (list_remove(sys->body_list, body, ptr_cmp));
+	assert(id > 0 && id <= sys->slot_count);
+
+	// move the last body in place of the removed one
+	size_t index = sys->slots[id - 1];
+	size_t last = --sys->body_count;
+	if (index != last) {
+		sys->bodies[index] = sys->bodies[last];
+		sys->body_ids[index] = sys->body_ids[last];
+		sys->slots[sys->body_ids[index] - 1] = index;
+	}
+
+	// chain the handle into free list
+	sys->slots[id - 1] = sys->free_slot;
+	sys->free_slot = id;
 }
 
 int
@@ -99,4 +277,109 @@ sim_add_handler(struct SimulationSystem *sys, const struct CollisionHandler *hnd
 		return 1;
 	}
 	return 0;
-}
\ No newline at end of file
+}
+
+size_t
+sim_query_nearest(
+	struct SimulationSystem *sys,
+	Scalar x,
+	Scalar y,
+	int type_mask,
+	struct Body **r_bodies,
+	size_t max
+) {
+	assert(max <= SIM_QUERY_MAX);
+
+	// keep the nearest bodies found so far sorted by insertion
+	float dist[SIM_QUERY_MAX];
+	size_t count = 0;
+	for (size_t i = 0; i < sys->body_count; i++) {
+		struct Body *body = &sys->bodies[i];
+		if (!(body->type & type_mask)) {
+			continue;
+		}
+
+		float dx = scalar_to_float(body->x - x);
+		float dy = scalar_to_float(body->y - y);
+		float d = dx * dx + dy * dy;
+		if (count == max && (max == 0 || d >= dist[max - 1])) {
+			continue;
+		}
+
+		size_t j = count < max ? count++ : max - 1;
+		for (; j > 0 && dist[j - 1] > d; j--) {
+			dist[j] = dist[j - 1];
+			r_bodies[j] = r_bodies[j - 1];
+		}
+		dist[j] = d;
+		r_bodies[j] = body;
+	}
+	return count;
+}
+
+int
+sim_save(const struct SimulationSystem *sys, struct SimSnapshot *snap)
+{
+	// there's never more handles than bodies the system has room for
+	size_t capacity = sys->body_capacity;
+	if (capacity > snap->capacity) {
+		struct Body *bodies = realloc(snap->bodies, sizeof(struct Body) * capacity);
+		if (!bodies) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		snap->bodies = bodies;
+
+		BodyID *body_ids = realloc(snap->body_ids, sizeof(BodyID) * capacity);
+		if (!body_ids) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		snap->body_ids = body_ids;
+
+		size_t *slots = realloc(snap->slots, sizeof(size_t) * capacity);
+		if (!slots) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		snap->slots = slots;
+		snap->capacity = capacity;
+	}
+
+	if (sys->slot_count) {
+		memcpy(snap->bodies, sys->bodies, sizeof(struct Body) * sys->body_count);
+		memcpy(snap->body_ids, sys->body_ids, sizeof(BodyID) * sys->body_count);
+		memcpy(snap->slots, sys->slots, sizeof(size_t) * sys->slot_count);
+	}
+	snap->body_count = sys->body_count;
+	snap->slot_count = sys->slot_count;
+	snap->free_slot = sys->free_slot;
+	return 1;
+}
+
+void
+sim_restore(struct SimulationSystem *sys, const struct SimSnapshot *snap)
+{
+	// capacity never shrinks, thus, saved state always fits
+	assert(snap->slot_count <= sys->body_capacity);
+
+	if (snap->slot_count) {
+		memcpy(sys->bodies, snap->bodies, sizeof(struct Body) * snap->body_count);
+		memcpy(sys->body_ids, snap->body_ids, sizeof(BodyID) * snap->body_count);
+		memcpy(sys->slots, snap->slots, sizeof(size_t) * snap->slot_count);
+	}
+	sys->body_count = snap->body_count;
+	sys->slot_count = snap->slot_count;
+	sys->free_slot = snap->free_slot;
+}
+
+void
+sim_snapshot_release(struct SimSnapshot *snap)
+{
+	if (snap) {
+		free(snap->bodies);
+		free(snap->body_ids);
+		free(snap->slots);
+		memset(snap, 0, sizeof(struct SimSnapshot));
+	}
+}
@@ -1,19 +1,98 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
-#define MAX_BODIES 20
 #define MAX_HANDLERS 10
+#define COLLISION_BLOCK_SIZE 8
+#define SIM_QUERY_MAX 32
+
+/**
+ * Physics scalar type.
+ *
+ * When built with PHYSICS_FIXED_POINT defined, bodies are stored and
+ * integrated in Q16.16 fixed point, so that simulation results do not depend
+ * on the compiler, its floating point flags or the math library, and replays
+ * and lockstep peers never drift apart. Otherwise, plain floats are used.
+ *
+ * Values should be converted to and from floats only through
+ * `scalar_from_float()` and `scalar_to_float()`.
+ */
+#ifdef PHYSICS_FIXED_POINT
+
+typedef int32_t Scalar;
+
+#define SCALAR_FRAC_BITS 16
+#define SCALAR_ONE (1 << SCALAR_FRAC_BITS)
+
+static inline Scalar
+scalar_from_float(float f)
+{
+	// round half away from zero, multiplication by a power of two is exact
+	f *= SCALAR_ONE;
+	return (Scalar)(f < 0 ? f - 0.5f : f + 0.5f);
+}
+
+static inline float
+scalar_to_float(Scalar s)
+{
+	return s / (float)SCALAR_ONE;
+}
+
+static inline Scalar
+scalar_mul(Scalar a, Scalar b)
+{
+	return (Scalar)(((int64_t)a * b) >> SCALAR_FRAC_BITS);
+}
+
+#else
+
+typedef float Scalar;
+
+static inline Scalar
+scalar_from_float(float f)
+{
+	return f;
+}
+
+static inline float
+scalar_to_float(Scalar s)
+{
+	return s;
+}
+
+static inline Scalar
+scalar_mul(Scalar a, Scalar b)
+{
+	return a * b;
+}
+
+#endif
 
 struct Body {
-	float x, y;
-	float xvel, yvel;
-	float radius;
+	Scalar x, y;
+	Scalar xvel, yvel;
+	Scalar radius;
 	int type;
 	int collision_mask;
 	void *userdata;
 };
 
+/**
+ * Body handle.
+ *
+ * Bodies are owned by the simulation system and stored in a tightly packed
+ * array, thus, they are referred to by handles rather than by pointers. Zero
+ * is never a valid handle.
+ */
+typedef unsigned BodyID;
+
+/**
+ * Collision callback.
+ *
+ * Body pointers are valid only for the duration of the call; callbacks must
+ * not add or remove bodies.
+ */
 typedef int (*CollisionCallback)(struct Body *a, struct Body *b, void *userdata);
 
 struct CollisionHandler {
@@ -23,11 +102,44 @@ struct CollisionHandler {
 };
 
 struct SimulationSystem {
-	struct List *body_list;
+	struct Body *bodies;
+	BodyID *body_ids;       // handle of each body in `bodies`
+	size_t body_count;
+	size_t body_capacity;
+
+	size_t *slots;          // handle - 1 -> index into `bodies`
+	size_t slot_count;
+	BodyID free_slot;       // first free handle, free slots are chained
+
+	// narrowphase copies of body shapes, laid out for block testing and
+	// padded with non-colliding entries up to a multiple of block size
+	Scalar *shape_x;
+	Scalar *shape_y;
+	Scalar *shape_radius;
+	int *shape_type;
+	int *shape_mask;
+	int *shape_hit;
+
 	struct CollisionHandler handlers[MAX_HANDLERS];
 	size_t handler_count;
 };
 
+/**
+ * Saved simulation state.
+ *
+ * Must be zero-initialized before first use; buffers are reused by
+ * subsequent saves and grow only when the simulation does.
+ */
+struct SimSnapshot {
+	struct Body *bodies;
+	BodyID *body_ids;
+	size_t body_count;
+	size_t *slots;
+	size_t slot_count;
+	BodyID free_slot;
+	size_t capacity;
+};
+
 struct SimulationSystem*
 sim_new(void);
 
@@ -37,11 +149,59 @@ sim_destroy(struct SimulationSystem *sys);
 int
 sim_step(struct SimulationSystem *sys, float dt);
 
-int
-sim_add_body(struct SimulationSystem *sys, struct Body *body);
+/**
+ * Add a copy of given body to the simulation.
+ *
+ * Returns the handle of the new body or 0 on failure.
+ */
+BodyID
+sim_add_body(struct SimulationSystem *sys, const struct Body *body);
 
 void
-sim_remove_body(struct SimulationSystem *sys, struct Body *body);
+sim_remove_body(struct SimulationSystem *sys, BodyID id);
+
+/**
+ * Get body by handle.
+ *
+ * The pointer is valid until a body is added or removed.
+ */
+static inline struct Body*
+sim_get_body(struct SimulationSystem *sys, BodyID id)
+{
+	return &sys->bodies[sys->slots[id - 1]];
+}
 
 int
 sim_add_handler(struct SimulationSystem *sys, const struct CollisionHandler *c);
+
+/**
+ * Find bodies of given types nearest to a point.
+ *
+ * Writes up to `max` bodies, at most `SIM_QUERY_MAX`, into `r_bodies`
+ * ordered by increasing distance and returns their number. The pointers are
+ * valid until a body is added or removed.
+ */
+size_t
+sim_query_nearest(
+	struct SimulationSystem *sys,
+	Scalar x,
+	Scalar y,
+	int type_mask,
+	struct Body **r_bodies,
+	size_t max
+);
+
+/**
+ * Save the state of all bodies.
+ */
+int
+sim_save(const struct SimulationSystem *sys, struct SimSnapshot *snap);
+
+/**
+ * Restore the state saved from the same simulation, handles included.
+ */
+void
+sim_restore(struct SimulationSystem *sys, const struct SimSnapshot *snap);
+
+void
+sim_snapshot_release(struct SimSnapshot *snap);
@@ -1,27 +1,30 @@
 #include "game.h"
-#include "memory.h"
 
-struct Projectile*
-projectile_new(float x, float y)
+Entity
+projectile_spawn(struct World *world, float x, float y)
 {
-	struct Projectile *prj = make(struct Projectile);
+	struct Body body = {
+		.x = scalar_from_float(x),
+		.y = scalar_from_float(y),
+		.yvel = scalar_from_float(-PLAYER_PROJECTILE_INITIAL_SPEED),
+		.radius = scalar_from_float(4),
+		.type = BODY_TYPE_PROJECTILE,
+		.collision_mask = BODY_TYPE_ENEMY,
+	};
+	Entity prj = world_spawn(
+		world,
+		ECS_BIT(COMPONENT_TRANSFORM) |
+		ECS_BIT(COMPONENT_BODY) |
+		ECS_BIT(COMPONENT_TTL) |
+		ECS_BIT(COMPONENT_SPRITE),
+		&body
+	);
 	if (!prj) {
-		return NULL;
+		return 0;
 	}
-	prj->x = prj->body.x = x;
-	prj->y = prj->body.y = y;
-	prj->ttl = (SCREEN_HEIGHT - 100) / PLAYER_PROJECTILE_INITIAL_SPEED;
-	prj->body.xvel = 0;
-	prj->body.yvel = -PLAYER_PROJECTILE_INITIAL_SPEED;
-	prj->body.radius = 4;
-	prj->body.type = BODY_TYPE_PROJECTILE;
-	prj->body.collision_mask = BODY_TYPE_ENEMY;
-	prj->body.userdata = prj;
+	*(float*)ecs_get(world->ecs, prj, COMPONENT_TTL) = (
+		(SCREEN_HEIGHT - 100) / PLAYER_PROJECTILE_INITIAL_SPEED
+	);
+	*(int*)ecs_get(world->ecs, prj, COMPONENT_SPRITE) = SPRITE_PROJECTILE;
 	return prj;
 }
-
-void
-projectile_destroy(struct Projectile *prj)
-{
-	destroy(prj);
-}
\ No newline at end of file
@@ -9,56 +9,111 @@
 #include "texture.h"
 #include "widget.h"
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
+#ifdef RENDERER_EGL
+# include <EGL/egl.h>
+# include <EGL/eglext.h>
+#endif
+
 #define RENDER_LIST_MAX_LEN 1000
-#define SPRITE_TEXTURE_UNIT 0
-#define TEXT_GLYPH_TEXTURE_UNIT 1
-#define TEXT_ATLAS_TEXTURE_UNIT 2
-#define WIDGET_TEXTURE_UNIT 3
+#define QUAD_BATCH_MAX_LEN 4096    // instances drawn at once
+#define QUAD_TEXTURES 4            // matching `textures` in quad.frag
+
+/**
+ * Per-instance attributes of quads.
+ */
+struct QuadInstance {
+	float transform[6];
+	float size[2];        // in pixels
+	float origin[2];      // texel of the top-left corner
+	GLuint border[2];     // first and last repeated texture columns
+	float depth;
+	GLuint kind;
+	GLuint slot;          // index of the texture in the batch
+	GLuint layer;
+};
+
+/**
+ * Kinds of quads, matching those in quad.frag.
+ */
+enum {
+	QUAD_SPRITE,
+	QUAD_WIDGET,
+	QUAD_GLYPH,
+};
+
+/**
+ * Which texels of quads to draw, matching `pass` in quad.frag.
+ */
+enum {
+	QUAD_PASS_OPAQUE,
+	QUAD_PASS_TRANSLUCENT,
+};
 
 enum {
 	RENDER_NODE_SPRITE,
 	RENDER_NODE_TEXT,
 	RENDER_NODE_WIDGET,
+	RENDER_NODE_STARFIELD,
 };
 
 static struct Renderer {
 	int initialized;
 	SDL_Window *win;
 	SDL_GLContext *ctx;
+#ifdef RENDERER_EGL
+	EGLDisplay egl_display;
+	EGLContext egl_context;
+	EGLSurface egl_surface;
+#endif
+	int gl_loaded;         // OpenGL functions are loaded by GLEW
+	// offscreen framebuffer standing for the screen of headless renderer,
+	// 0 for the window one
+	GLuint screen_fbo;
+	GLuint screen_color;
+	GLuint screen_depth;
 	int width, height;
 	Mat projection;
 	struct {
 		struct Shader *shader;
-		struct ShaderUniform u_texture;
-		struct ShaderUniform u_size;
-		struct ShaderUniform u_transform;
-	} sprite_pipeline;
+		struct ShaderUniform u_textures;
+		struct ShaderUniform u_projection;
+		struct ShaderUniform u_pass;
+		GLuint vao;
+		GLuint instance_buffer;
+
+		// batch of instances to draw, and the textures they sample,
+		// bound to consecutive units
+		struct QuadInstance instances[QUAD_BATCH_MAX_LEN];
+		size_t count;
+		GLuint textures[QUAD_TEXTURES];
+		size_t texture_count;
+	} quad_pipeline;
 	struct {
 		struct Shader *shader;
-		struct ShaderUniform u_transform;
-		struct ShaderUniform u_glyph_texture;
-		struct ShaderUniform u_atlas_texture;
-		struct ShaderUniform u_atlas_offset;
-	} text_pipeline;
+		struct ShaderUniform u_texture;
+		struct ShaderUniform u_projection;
+	} target_pipeline;
 	struct {
 		struct Shader *shader;
-		struct ShaderUniform u_texture;
-		struct ShaderUniform u_size;
-		struct ShaderUniform u_border;
-		struct ShaderUniform u_transform;
-	} widget_pipeline;
+		struct ShaderUniform u_unproject;
+		struct ShaderUniform u_scroll;
+		GLuint vao;
+	} starfield_pipeline;
 } rndr = { 0, NULL, NULL };
 
 struct RenderNode {
 	int type;
-	Mat transform;
+	Affine2 transform;
+	float depth;          // nodes added later are closer
 	union {
 		struct Sprite *sprite;
 		struct Text *text;
 		struct Widget *widget;
+		float scroll;
 	};
 };
 
@@ -67,118 +122,233 @@ struct RenderList {
 	size_t len;
 };
 
+/**
+ * Validate pipeline uniform types, so that they can be set through typed
+ * setters without any further checks.
+ */
 static int
-init_sprite_pipeline(void)
+check_uniform_types(struct ShaderUniform *uniforms[], const GLenum types[])
+{
+	int ok = 1;
+	for (size_t i = 0; uniforms[i] != NULL; i++) {
+		ok &= shader_uniform_check_type(uniforms[i], types[i]);
+	}
+	return ok;
+}
+
+/**
+ * Setup an instance attribute of the quad pipeline, of `count` components of
+ * given type at given offset.
+ */
+static void
+init_quad_attrib(GLuint index, GLint count, GLenum type, size_t offset)
+{
+	glEnableVertexAttribArray(index);
+	if (type == GL_FLOAT) {
+		glVertexAttribPointer(
+			index,
+			count,
+			type,
+			GL_FALSE,
+			sizeof(struct QuadInstance),
+			(GLvoid*)offset
+		);
+	} else {
+		glVertexAttribIPointer(
+			index,
+			count,
+			type,
+			sizeof(struct QuadInstance),
+			(GLvoid*)offset
+		);
+	}
+	glVertexAttribDivisor(index, 1);
+}
+
+static int
+init_quad_pipeline(void)
 {
 	// load and compile the shader
 	const char *uniform_names[] = {
-		"tex",
-		"size",
-		"transform",
+		"textures[0]",
+		"projection",
+		"pass",
 		NULL
 	};
 	struct ShaderUniform *uniforms[] = {
-		&rndr.sprite_pipeline.u_texture,
-		&rndr.sprite_pipeline.u_size,
-		&rndr.sprite_pipeline.u_transform,
+		&rndr.quad_pipeline.u_textures,
+		&rndr.quad_pipeline.u_projection,
+		&rndr.quad_pipeline.u_pass,
 		NULL
 	};
-	rndr.sprite_pipeline.shader = shader_compile(
-		"data/shaders/sprite.vert",
-		"data/shaders/sprite.frag",
+	const GLenum types[] = {
+		GL_SAMPLER_2D_ARRAY,
+		GL_FLOAT_MAT4,
+		GL_INT,
+	};
+	rndr.quad_pipeline.shader = shader_compile(
+		"data/shaders/quad.vert",
+		"data/shaders/quad.frag",
 		uniform_names,
 		uniforms,
 		NULL,
 		NULL
 	);
-	if (!rndr.sprite_pipeline.shader) {
+	if (!rndr.quad_pipeline.shader ||
+	    !check_uniform_types(uniforms, types)) {
 		fprintf(
 			stderr,
 			"failed to initialize rendering pipeline\n"
 		);
 		return 0;
 	}
+
+	// texture units never change, set them once
+	if (!shader_bind(rndr.quad_pipeline.shader)) {
+		return 0;
+	}
+	GLint units[QUAD_TEXTURES];
+	for (GLint i = 0; i < QUAD_TEXTURES; i++) {
+		units[i] = i;
+	}
+	if (!shader_uniform_set(
+		&rndr.quad_pipeline.u_textures,
+		QUAD_TEXTURES,
+		units
+	)) {
+		return 0;
+	}
+
+	// setup the instance attributes, streamed for each draw
+	glGenVertexArrays(1, &rndr.quad_pipeline.vao);
+	glGenBuffers(1, &rndr.quad_pipeline.instance_buffer);
+	glBindVertexArray(rndr.quad_pipeline.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, rndr.quad_pipeline.instance_buffer);
+	glBufferData(
+		GL_ARRAY_BUFFER,
+		sizeof(rndr.quad_pipeline.instances),
+		NULL,
+		GL_STREAM_DRAW
+	);
+	size_t transform = offsetof(struct QuadInstance, transform);
+	init_quad_attrib(0, 3, GL_FLOAT, transform);
+	init_quad_attrib(1, 3, GL_FLOAT, transform + sizeof(float) * 3);
+	init_quad_attrib(2, 2, GL_FLOAT, offsetof(struct QuadInstance, size));
+	init_quad_attrib(3, 2, GL_FLOAT, offsetof(struct QuadInstance, origin));
+	init_quad_attrib(4, 2, GL_UNSIGNED_INT, offsetof(struct QuadInstance, border));
+	init_quad_attrib(5, 1, GL_FLOAT, offsetof(struct QuadInstance, depth));
+	init_quad_attrib(6, 1, GL_UNSIGNED_INT, offsetof(struct QuadInstance, kind));
+	init_quad_attrib(7, 1, GL_UNSIGNED_INT, offsetof(struct QuadInstance, slot));
+	init_quad_attrib(8, 1, GL_UNSIGNED_INT, offsetof(struct QuadInstance, layer));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	if (!rndr.quad_pipeline.vao ||
+	    !rndr.quad_pipeline.instance_buffer ||
+	    glGetError() != GL_NO_ERROR) {
+		error(ERR_OPENGL);
+		return 0;
+	}
 	return 1;
 }
 
+/**
+ * Initialize the pipeline drawing render targets.
+ *
+ * Targets are drawn as quads of the quad pipeline, but composited by a
+ * fragment shader of their own, which samples a single texture, for the
+ * whole screen is usually covered.
+ */
 static int
-init_text_pipeline(void)
+init_target_pipeline(void)
 {
 	// load and compile the shader
 	const char *uniform_names[] = {
-		"glyph_tex",
-		"atlas_tex",
-		"atlas_offset",
-		"transform",
+		"tex",
+		"projection",
 		NULL
 	};
 	struct ShaderUniform *uniforms[] = {
-		&rndr.text_pipeline.u_glyph_texture,
-		&rndr.text_pipeline.u_atlas_texture,
-		&rndr.text_pipeline.u_atlas_offset,
-		&rndr.text_pipeline.u_transform,
+		&rndr.target_pipeline.u_texture,
+		&rndr.target_pipeline.u_projection,
 		NULL
 	};
-	rndr.text_pipeline.shader = shader_compile(
-		"data/shaders/text.vert",
-		"data/shaders/text.frag",
+	const GLenum types[] = {
+		GL_SAMPLER_2D_ARRAY,
+		GL_FLOAT_MAT4,
+	};
+	rndr.target_pipeline.shader = shader_compile(
+		"data/shaders/quad.vert",
+		"data/shaders/target.frag",
 		uniform_names,
 		uniforms,
 		NULL,
 		NULL
 	);
-	if (!rndr.text_pipeline.shader) {
+	if (!rndr.target_pipeline.shader ||
+	    !check_uniform_types(uniforms, types)) {
 		fprintf(
 			stderr,
 			"failed to initialize rendering pipeline\n"
 		);
 		return 0;
 	}
+
+	// the texture is bound to the unit of the first quad texture
+	if (!shader_bind(rndr.target_pipeline.shader)) {
+		return 0;
+	}
+	shader_uniform_set_int(&rndr.target_pipeline.u_texture, 0);
 	return 1;
 }
 
 static int
-init_widget_pipeline(void)
+init_starfield_pipeline(void)
 {
 	// load and compile the shader
 	const char *uniform_names[] = {
-		"tex",
-		"size",
-		"border",
-		"transform",
+		"unproject",
+		"scroll",
 		NULL
 	};
 	struct ShaderUniform *uniforms[] = {
-		&rndr.widget_pipeline.u_texture,
-		&rndr.widget_pipeline.u_size,
-		&rndr.widget_pipeline.u_border,
-		&rndr.widget_pipeline.u_transform,
+		&rndr.starfield_pipeline.u_unproject,
+		&rndr.starfield_pipeline.u_scroll,
 		NULL
 	};
-	rndr.widget_pipeline.shader = shader_compile(
-		"data/shaders/widget.vert",
-		"data/shaders/widget.frag",
+	const GLenum types[] = {
+		GL_FLOAT_VEC4,
+		GL_FLOAT,
+	};
+	rndr.starfield_pipeline.shader = shader_compile(
+		"data/shaders/starfield.vert",
+		"data/shaders/starfield.frag",
 		uniform_names,
 		uniforms,
 		NULL,
 		NULL
 	);
-	if (!rndr.widget_pipeline.shader) {
+	if (!rndr.starfield_pipeline.shader ||
+	    !check_uniform_types(uniforms, types)) {
 		fprintf(
 			stderr,
-			"failed to initialize widget pipeline\n"
+			"failed to initialize rendering pipeline\n"
 		);
 		return 0;
 	}
+
+	// the triangle is generated from vertex IDs, but a VAO must be bound
+	glGenVertexArrays(1, &rndr.starfield_pipeline.vao);
+	if (!rndr.starfield_pipeline.vao) {
+		error(ERR_OPENGL);
+		return 0;
+	}
 	return 1;
 }
 
-int
-renderer_init(unsigned width, unsigned height)
+static int
+init_window_context(unsigned width, unsigned height)
 {
-	assert(!rndr.initialized);
-	memset(&rndr, 0, sizeof(struct Renderer));
-
 	// initialize SDL video subsystem
 	if (!SDL_WasInit(SDL_INIT_VIDEO) && SDL_Init(SDL_INIT_VIDEO) != 0) {
 		fprintf(stderr, "failed to initialize SDL: %s", SDL_GetError());
@@ -198,10 +368,8 @@ renderer_init(unsigned width, unsigned height)
 	if (!rndr.win) {
 		fprintf(stderr, "failed to create OpenGL window\n");
 		error(ERR_SDL);
-		goto error;
+		return 0;
 	}
-	rndr.width = width;
-	rndr.height = height;
 
 	// initialize OpenGL context
 	SDL_GL_SetAttribute(
@@ -217,60 +385,303 @@ renderer_init(unsigned width, unsigned height)
 	if (!rndr.ctx) {
 		fprintf(stderr, "failed to initialize OpenGL context\n");
 		error(ERR_SDL);
-		goto error;
+		return 0;
+	}
+
+	return 1;
+}
+
+#ifdef RENDERER_EGL
+static int
+has_extension(const char *extensions, const char *name)
+{
+	size_t len = strlen(name);
+	const char *ext = extensions;
+	while (ext && (ext = strstr(ext, name))) {
+		if ((ext == extensions || ext[-1] == ' ') &&
+		    (ext[len] == ' ' || ext[len] == '\0')) {
+			return 1;
+		}
+		ext += len;
+	}
+	return 0;
+}
+
+static int
+init_headless_context(void)
+{
+	// prefer Mesa's platform which needs neither a display server nor a
+	// GPU device, otherwise let EGL pick one
+	EGLDisplay display = EGL_NO_DISPLAY;
+	const char *exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)
+		eglGetProcAddress("eglGetPlatformDisplayEXT")
+	);
+	if (get_platform_display &&
+	    has_extension(exts, "EGL_MESA_platform_surfaceless")) {
+		display = get_platform_display(
+			EGL_PLATFORM_SURFACELESS_MESA,
+			EGL_DEFAULT_DISPLAY,
+			NULL
+		);
+	}
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+		fprintf(stderr, "failed to initialize EGL: %#x\n", eglGetError());
+		error(ERR_OPENGL);
+		return 0;
+	}
+	rndr.egl_display = display;
+
+	// frames are rendered into a framebuffer object, thus, a surface is
+	// needed only if the context can't be made current without one
+	int surfaceless = has_extension(
+		eglQueryString(display, EGL_EXTENSIONS),
+		"EGL_KHR_surfaceless_context"
+	);
+	const EGLint config_attrs[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	const EGLint context_attrs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	const EGLint pbuffer_attrs[] = {
+		EGL_WIDTH, 1,
+		EGL_HEIGHT, 1,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint count = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) ||
+	    !eglChooseConfig(display, config_attrs, &config, 1, &count) ||
+	    count == 0 ||
+	    (rndr.egl_context = eglCreateContext(
+		display,
+		config,
+		EGL_NO_CONTEXT,
+		context_attrs
+	    )) == EGL_NO_CONTEXT) {
+		fprintf(
+			stderr,
+			"failed to create EGL context: %#x\n",
+			eglGetError()
+		);
+		error(ERR_OPENGL);
+		return 0;
 	}
-	SDL_GL_SetSwapInterval(0);
 
-	// initialize GLEW
+	rndr.egl_surface = EGL_NO_SURFACE;
+	if (!surfaceless && (rndr.egl_surface = eglCreatePbufferSurface(
+		display,
+		config,
+		pbuffer_attrs
+	)) == EGL_NO_SURFACE) {
+		fprintf(
+			stderr,
+			"failed to create EGL surface: %#x\n",
+			eglGetError()
+		);
+		error(ERR_OPENGL);
+		return 0;
+	}
+
+	if (!eglMakeCurrent(
+		display,
+		rndr.egl_surface,
+		rndr.egl_surface,
+		rndr.egl_context
+	)) {
+		fprintf(
+			stderr,
+			"failed to make EGL context current: %#x\n",
+			eglGetError()
+		);
+		error(ERR_OPENGL);
+		return 0;
+	}
+
+	printf("EGL version: %s\n", eglQueryString(display, EGL_VERSION));
+	return 1;
+}
+#endif
+
+/**
+ * Create the framebuffer the headless renderer draws into.
+ */
+static int
+init_screen_framebuffer(void)
+{
+	glGenRenderbuffers(1, &rndr.screen_color);
+	glBindRenderbuffer(GL_RENDERBUFFER, rndr.screen_color);
+	glRenderbufferStorage(
+		GL_RENDERBUFFER,
+		GL_RGBA8,
+		rndr.width,
+		rndr.height
+	);
+	glGenRenderbuffers(1, &rndr.screen_depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, rndr.screen_depth);
+	glRenderbufferStorage(
+		GL_RENDERBUFFER,
+		GL_DEPTH_COMPONENT24,
+		rndr.width,
+		rndr.height
+	);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &rndr.screen_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, rndr.screen_fbo);
+	glFramebufferRenderbuffer(
+		GL_FRAMEBUFFER,
+		GL_COLOR_ATTACHMENT0,
+		GL_RENDERBUFFER,
+		rndr.screen_color
+	);
+	glFramebufferRenderbuffer(
+		GL_FRAMEBUFFER,
+		GL_DEPTH_ATTACHMENT,
+		GL_RENDERBUFFER,
+		rndr.screen_depth
+	);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE || glGetError() != GL_NO_ERROR) {
+		fprintf(stderr, "failed to create screen framebuffer\n");
+		error(ERR_OPENGL);
+		return 0;
+	}
+	glViewport(0, 0, rndr.width, rndr.height);
+	return 1;
+}
+
+/**
+ * Initialize OpenGL state and pipelines, once a context is current.
+ */
+static int
+init_gl(int headless)
+{
+	// initialize GLEW; when built for GLX, it fails to query the extensions
+	// of the X display, which headless contexts have none of, after having
+	// loaded OpenGL functions though
 	glewExperimental = GL_TRUE;
-	if (glewInit() != 0) {
+	GLenum glew_error = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (headless && glew_error == GLEW_ERROR_NO_GLX_DISPLAY) {
+		glew_error = GLEW_OK;
+	}
+#endif
+	if (glew_error != GLEW_OK) {
 		fprintf(stderr, "failed to initialize GLEW");
 		error(ERR_OPENGL);
-		goto error;
+		return 0;
 	}
 	glGetError(); // silence any errors produced during GLEW initialization
+	rndr.gl_loaded = 1;
 
 	printf("OpenGL version: %s\n", glGetString(GL_VERSION));
 	printf("GLSL version: %s\n", glGetString(GL_SHADING_LANGUAGE_VERSION));
 	printf("GLEW version: %s\n", glewGetString(GLEW_VERSION));
 
+	if (headless && !init_screen_framebuffer()) {
+		return 0;
+	}
+
 	// initialize OpenGL state machine
 	glCullFace(GL_BACK);
 	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// all colors are premultiplied by alpha
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
 	// initialize projection matrix
 	mat_ortho(
 		&rndr.projection,
-		-(float)width / 2,
-		(float)width / 2,
-		(float)height / 2,
-		-(float)height / 2,
+		-(float)rndr.width / 2,
+		(float)rndr.width / 2,
+		(float)rndr.height / 2,
+		-(float)rndr.height / 2,
 		0,
 		100
 	);
 
-	rndr.initialized = (
-		init_sprite_pipeline() &&
-		init_text_pipeline() &&
-		init_widget_pipeline()
+	return (
+		init_quad_pipeline() &&
+		init_target_pipeline() &&
+		init_starfield_pipeline()
 	);
+}
+
+int
+renderer_init(unsigned width, unsigned height)
+{
+	assert(!rndr.initialized);
+	memset(&rndr, 0, sizeof(struct Renderer));
+	rndr.width = width;
+	rndr.height = height;
 
+	rndr.initialized = init_window_context(width, height) && init_gl(0);
 	if (!rndr.initialized) {
-		goto error;
+		renderer_shutdown();
+		return 0;
 	}
+	return 1;
+}
+
+int
+renderer_init_headless(unsigned width, unsigned height)
+{
+	assert(!rndr.initialized);
+	memset(&rndr, 0, sizeof(struct Renderer));
+	rndr.width = width;
+	rndr.height = height;
 
+#ifdef RENDERER_EGL
+	rndr.initialized = init_headless_context() && init_gl(1);
+#else
+	fprintf(stderr, "headless rendering is not supported by this build\n");
+	error(ERR_OPENGL);
+#endif
+	if (!rndr.initialized) {
+		renderer_shutdown();
+		return 0;
+	}
 	return 1;
+}
 
-error:
-	renderer_shutdown();
-	return 0;
+float
+renderer_get_refresh_rate(void)
+{
+	SDL_DisplayMode mode;
+	if (!rndr.win || SDL_GetWindowDisplayMode(rndr.win, &mode) != 0) {
+		return 0;
+	}
+	return mode.refresh_rate;
 }
 
 void
 renderer_shutdown(void)
 {
-	shader_free(rndr.sprite_pipeline.shader);
+	// initialization may have failed before there was a context to load
+	// OpenGL functions from
+	if (rndr.gl_loaded) {
+		glDeleteBuffers(1, &rndr.quad_pipeline.instance_buffer);
+		glDeleteVertexArrays(1, &rndr.quad_pipeline.vao);
+		shader_free(rndr.quad_pipeline.shader);
+		shader_free(rndr.target_pipeline.shader);
+		glDeleteVertexArrays(1, &rndr.starfield_pipeline.vao);
+		shader_free(rndr.starfield_pipeline.shader);
+		glDeleteFramebuffers(1, &rndr.screen_fbo);
+		glDeleteRenderbuffers(1, &rndr.screen_color);
+		glDeleteRenderbuffers(1, &rndr.screen_depth);
+		rndr.gl_loaded = 0;
+	}
 
 	if (rndr.ctx) {
 		SDL_GL_DeleteContext(rndr.ctx);
@@ -278,6 +689,24 @@ renderer_shutdown(void)
 	if (rndr.win) {
 		SDL_DestroyWindow(rndr.win);
 	}
+#ifdef RENDERER_EGL
+	if (rndr.egl_display != EGL_NO_DISPLAY) {
+		eglMakeCurrent(
+			rndr.egl_display,
+			EGL_NO_SURFACE,
+			EGL_NO_SURFACE,
+			EGL_NO_CONTEXT
+		);
+		if (rndr.egl_context != EGL_NO_CONTEXT) {
+			eglDestroyContext(rndr.egl_display, rndr.egl_context);
+		}
+		if (rndr.egl_surface != EGL_NO_SURFACE) {
+			eglDestroySurface(rndr.egl_display, rndr.egl_surface);
+		}
+		eglTerminate(rndr.egl_display);
+	}
+#endif
+	rndr.initialized = 0;
 }
 
 void
@@ -290,7 +719,11 @@ void
 renderer_present(void)
 {
 	assert(rndr.initialized);
-	SDL_GL_SwapWindow(rndr.win);
+	if (rndr.win) {
+		SDL_GL_SwapWindow(rndr.win);
+	} else {
+		glFlush();
+	}
 }
 
 struct RenderList*
@@ -307,6 +740,21 @@ render_list_destroy(struct RenderList *list)
 	destroy(list);
 }
 
+/**
+ * Append a node of given type to render list, in front of the ones added
+ * so far.
+ */
+static struct RenderNode*
+add_node(struct RenderList *list, int type)
+{
+	assert(list->len < RENDER_LIST_MAX_LEN);
+
+	struct RenderNode *node = &list->nodes[list->len++];
+	node->type = type;
+	node->depth = 1.0f - 2.0f * list->len / (RENDER_LIST_MAX_LEN + 1);
+	return node;
+}
+
 void
 render_list_add_sprite(
 	struct RenderList *list,
@@ -315,63 +763,16 @@ render_list_add_sprite(
 	float y,
 	float angle
 ) {
-	assert(list->len < RENDER_LIST_MAX_LEN);
-
 	// initialize sprite render node
-	struct RenderNode *node = &list->nodes[list->len++];
-	node->type = RENDER_NODE_SPRITE;
+	struct RenderNode *node = add_node(list, RENDER_NODE_SPRITE);
 	node->sprite = (struct Sprite*)spr;
 
-	// compute transform
-	Mat t, r;
-	mat_ident(&t);
-	mat_translate(&t, x, -y, 0);
-
-	mat_ident(&r);
-	mat_translate(&r, -spr->width / 2, spr->height / 2, 0);
-	mat_rotate(&r, 0, 0, 1, angle);
-
-	mat_mul(&t, &r, &node->transform);
-}
-
-static int
-render_sprite_node(const struct RenderNode *node)
-{
-	int ok = 1;
-
-	// configure size
-	Vec size = {{ node->sprite->width, node->sprite->height, 0, 0 }};
-	ok &= shader_uniform_set(
-		&rndr.sprite_pipeline.u_size,
-		1,
-		&size
-	);
-
-	// configure transform
-	Mat mvp;
-	mat_mul(&rndr.projection, &node->transform, &mvp);
-	ok &= shader_uniform_set(
-		&rndr.sprite_pipeline.u_transform,
-		1,
-		&mvp
-	);
-
-	// configure texture sampler
-	GLuint texture_unit = SPRITE_TEXTURE_UNIT;
-	ok &= shader_uniform_set(
-		&rndr.sprite_pipeline.u_texture,
-		1,
-		&texture_unit
-	);
-
-	// render
-	glActiveTexture(GL_TEXTURE0 + texture_unit);
-	glBindTexture(GL_TEXTURE_RECTANGLE, node->sprite->texture->hnd);
-	glBindVertexArray(node->sprite->vao);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	ok &= glGetError() == GL_NO_ERROR;
-
-	return ok;
+	// compute transform: rotate the sprite about its center, then move it
+	// into place
+	affine2_ident(&node->transform);
+	affine2_translate(&node->transform, x, -y);
+	affine2_rotate(&node->transform, angle);
+	affine2_translate(&node->transform, -spr->width / 2, spr->height / 2);
 }
 
 void
@@ -382,66 +783,10 @@ render_list_add_text(
 	float y
 ) {
 	// initialize text render node
-	struct RenderNode *node = &list->nodes[list->len++];
-	node->type = RENDER_NODE_TEXT;
+	struct RenderNode *node = add_node(list, RENDER_NODE_TEXT);
 	node->text = (struct Text*)txt;
-	mat_ident(&node->transform);
-	mat_translate(&node->transform, x, -y, 0);
-}
-
-static int
-render_text_node(const struct RenderNode *node)
-{
-	int ok = 1;
-
-	// configure transform
-	Mat mvp;
-	mat_mul(&rndr.projection, &node->transform, &mvp);
-	ok &= shader_uniform_set(
-		&rndr.text_pipeline.u_transform,
-		1,
-		&mvp
-	);
-
-	// configure atlas offset
-	unsigned int offset = font_get_atlas_offset(node->text->font);
-	ok &= shader_uniform_set(
-		&rndr.text_pipeline.u_atlas_offset,
-		1,
-		&offset
-	);
-
-	// configure texture samplers
-	GLuint glyph_texture_unit = TEXT_GLYPH_TEXTURE_UNIT;
-	GLuint atlas_texture_unit = TEXT_ATLAS_TEXTURE_UNIT;
-	ok &= shader_uniform_set(
-		&rndr.text_pipeline.u_glyph_texture,
-		1,
-		&glyph_texture_unit
-	);
-	ok &= shader_uniform_set(
-		&rndr.text_pipeline.u_atlas_texture,
-		1,
-		&atlas_texture_unit
-	);
-
-	// render
-	glActiveTexture(GL_TEXTURE0 + atlas_texture_unit);
-	glBindTexture(
-		GL_TEXTURE_RECTANGLE,
-		font_get_atlas_texture(node->text->font)
-	);
-	glActiveTexture(GL_TEXTURE0 + glyph_texture_unit);
-	glBindTexture(
-		GL_TEXTURE_1D,
-		font_get_glyph_texture(node->text->font)
-	);
-	glBindVertexArray(node->text->vao);
-	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, node->text->len);
-
-	ok &= glGetError() == GL_NO_ERROR;
-
-	return ok;
+	affine2_ident(&node->transform);
+	affine2_translate(&node->transform, x, -y);
 }
 
 void
@@ -451,116 +796,472 @@ render_list_add_widget(
 	float x,
 	float y
 ) {
-	// initialize text render node
-	struct RenderNode *node = &list->nodes[list->len++];
-	node->type = RENDER_NODE_WIDGET;
+	// initialize widget render node
+	struct RenderNode *node = add_node(list, RENDER_NODE_WIDGET);
 	node->widget = (struct Widget*)wdg;
-	mat_ident(&node->transform);
-	mat_translate(&node->transform, x - rndr.width / 2, -y + rndr.height / 2, 0);
+	affine2_ident(&node->transform);
+	affine2_translate(&node->transform, x - rndr.width / 2, -y + rndr.height / 2);
 }
 
-static int
-render_widget_node(const struct RenderNode *node)
+void
+render_list_add_starfield(struct RenderList *list, float scroll)
 {
-	int ok = 1;
+	struct RenderNode *node = add_node(list, RENDER_NODE_STARFIELD);
+	node->scroll = scroll;
+}
 
-	// configure size
-	Vec size = {{ node->widget->width, node->widget->height, 0, 0 }};
-	ok &= shader_uniform_set(
-		&rndr.widget_pipeline.u_size,
-		1,
-		&size
-	);
+/**
+ * Draw the batch of quads at once, and start a new one.
+ */
+static int
+flush_quads(void)
+{
+	size_t count = rndr.quad_pipeline.count;
+	if (count > 0) {
+		// orphan the previous contents of the buffer, not to wait for
+		// draws still using them
+		glBindBuffer(GL_ARRAY_BUFFER, rndr.quad_pipeline.instance_buffer);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			sizeof(rndr.quad_pipeline.instances),
+			NULL,
+			GL_STREAM_DRAW
+		);
+		glBufferSubData(
+			GL_ARRAY_BUFFER,
+			0,
+			sizeof(struct QuadInstance) * count,
+			rndr.quad_pipeline.instances
+		);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	// configure border
-	Vec border = {{
-		node->widget->border.left,
-		node->widget->texture->width - node->widget->border.right,
-		0,
-		0
-	}};
-	ok &= shader_uniform_set(
-		&rndr.widget_pipeline.u_border,
-		1,
-		&border
-	);
+		for (size_t i = 0; i < rndr.quad_pipeline.texture_count; i++) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(
+				GL_TEXTURE_2D_ARRAY,
+				rndr.quad_pipeline.textures[i]
+			);
+		}
+		glBindVertexArray(rndr.quad_pipeline.vao);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+	}
 
-	// configure transform
-	Mat mvp;
-	mat_mul(&rndr.projection, &node->transform, &mvp);
-	ok &= shader_uniform_set(
-		&rndr.widget_pipeline.u_transform,
-		1,
-		&mvp
-	);
+	rndr.quad_pipeline.count = 0;
+	rndr.quad_pipeline.texture_count = 0;
+	return glGetError() == GL_NO_ERROR;
+}
 
-	// configure texture sampler
-	GLuint texture_unit = WIDGET_TEXTURE_UNIT;
-	ok &= shader_uniform_set(
-		&rndr.widget_pipeline.u_texture,
-		1,
-		&texture_unit
-	);
+/**
+ * Find the slot of a texture among the ones of the batch, taking a free one
+ * if it's not there.
+ *
+ * Returns `QUAD_TEXTURES` if all slots are taken by other textures.
+ */
+static size_t
+find_slot(GLuint texture)
+{
+	GLuint *textures = rndr.quad_pipeline.textures;
+	size_t *count = &rndr.quad_pipeline.texture_count;
+	for (size_t i = 0; i < *count; i++) {
+		if (textures[i] == texture) {
+			return i;
+		}
+	}
+	if (*count < QUAD_TEXTURES) {
+		textures[*count] = texture;
+		return (*count)++;
+	}
+	return QUAD_TEXTURES;
+}
 
-	// render
-	glActiveTexture(GL_TEXTURE0 + texture_unit);
-	glBindTexture(GL_TEXTURE_RECTANGLE, node->widget->texture->hnd);
-	glBindVertexArray(node->widget->vao);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	ok &= glGetError() == GL_NO_ERROR;
+/**
+ * Add a quad of given kind, sampling given texture array, to the batch.
+ *
+ * The batch is drawn first if there's no room left for the quad or its
+ * texture. Returns the instance to be filled in, or NULL on failure.
+ */
+static struct QuadInstance*
+add_quad(int kind, GLuint texture)
+{
+	size_t slot = find_slot(texture);
+	if (slot == QUAD_TEXTURES ||
+	    rndr.quad_pipeline.count == QUAD_BATCH_MAX_LEN) {
+		if (!flush_quads()) {
+			return NULL;
+		}
+		slot = find_slot(texture);
+	}
 
-	return ok;
+	struct QuadInstance *inst = &rndr.quad_pipeline.instances[
+		rndr.quad_pipeline.count++
+	];
+	memset(inst, 0, sizeof(struct QuadInstance));
+	inst->kind = kind;
+	inst->slot = slot;
+	return inst;
 }
 
 static int
-node_cmp(const void *a, const void *b)
+add_sprite_quad(const struct RenderNode *node)
 {
-	if (((struct RenderNode*)a)->type == ((struct RenderNode*)b)->type) {
+	const struct TextureArray *texture = node->sprite->texture;
+	struct QuadInstance *inst = add_quad(QUAD_SPRITE, texture->hnd);
+	if (!inst) {
 		return 0;
-	} else if (a < b) {
-		return -1;
 	}
+	memcpy(inst->transform, node->transform.data, sizeof(inst->transform));
+	inst->size[0] = texture->width;
+	inst->size[1] = texture->height;
+	inst->layer = node->sprite->layer;
+	inst->depth = node->depth;
 	return 1;
 }
 
-int
-render_list_exec(struct RenderList *list)
+static int
+add_text_quads(const struct RenderNode *node)
 {
-	int ok = 1;
+	const struct Text *text = node->text;
+	GLuint atlas = font_get_atlas_texture(text->font);
+	unsigned atlas_offset = font_get_atlas_offset(text->font);
+	for (size_t i = 0; i < text->len; i++) {
+		const struct Character *ch = font_get_char(
+			text->font,
+			text->chars[i]
+		);
+		if (ch->size[0] == 0 || ch->size[1] == 0) {
+			continue;
+		}
+		struct QuadInstance *inst = add_quad(QUAD_GLYPH, atlas);
+		if (!inst) {
+			return 0;
+		}
 
-	// sort the list by node type
-	qsort(list->nodes, list->len, sizeof(struct RenderNode), node_cmp);
+		// glyphs are placed by their bottom-left corner, quads by the
+		// top-left one
+		Affine2 transform = node->transform;
+		affine2_translate(
+			&transform,
+			text->coords[i][0],
+			text->coords[i][1] + ch->size[1]
+		);
+		memcpy(inst->transform, transform.data, sizeof(inst->transform));
+		inst->size[0] = ch->size[0];
+		inst->size[1] = ch->size[1];
+		inst->origin[0] = (unsigned char)text->chars[i] * atlas_offset;
+		inst->depth = node->depth;
+	}
+	return 1;
+}
+
+static int
+add_widget_quad(const struct RenderNode *node)
+{
+	const struct Widget *widget = node->widget;
+	struct QuadInstance *inst = add_quad(QUAD_WIDGET, widget->texture->hnd);
+	if (!inst) {
+		return 0;
+	}
+	memcpy(inst->transform, node->transform.data, sizeof(inst->transform));
+	inst->size[0] = widget->width;
+	inst->size[1] = widget->height;
+	inst->border[0] = widget->border.left;
+	inst->border[1] = widget->texture->width - widget->border.right;
+	inst->depth = node->depth;
+	return 1;
+}
 
-	int active = -1;
-	for (size_t i = 0; i < list->len; i++) {
-		struct RenderNode *node = &list->nodes[i];
+/**
+ * Render either the fully opaque texels of all nodes, or the translucent
+ * ones.
+ *
+ * Opaque texels are drawn front to back with depth writes, for the hidden
+ * ones to be rejected by the depth test, then translucent texels are
+ * blended back to front over them. Nodes of all types are drawn at once, as
+ * long as the textures they sample fit the batch.
+ */
+static int
+render_quad_pass(const struct RenderList *list, int opaque)
+{
+	shader_uniform_set_int(
+		&rndr.quad_pipeline.u_pass,
+		opaque ? QUAD_PASS_OPAQUE : QUAD_PASS_TRANSLUCENT
+	);
+
+	int ok = 1;
+	for (size_t i = 0; ok && i < list->len; i++) {
+		const struct RenderNode *node = &list->nodes[
+			opaque ? list->len - 1 - i : i
+		];
 		switch (node->type) {
 		case RENDER_NODE_SPRITE:
-			if (active != node->type) {
-				ok &= shader_bind(rndr.sprite_pipeline.shader);
-			}
-			ok &= render_sprite_node(node);
+			ok = add_sprite_quad(node);
 			break;
 		case RENDER_NODE_TEXT:
-			if (active != node->type) {
-				ok &= shader_bind(rndr.text_pipeline.shader);
-			}
-			ok &= render_text_node(node);
+			ok = add_text_quads(node);
 			break;
 		case RENDER_NODE_WIDGET:
-			if (active != node->type) {
-				ok &= shader_bind(rndr.widget_pipeline.shader);
-			}
-			ok &= render_widget_node(node);
+			ok = add_widget_quad(node);
 			break;
 		}
-		active = node->type;
+	}
+	return ok && flush_quads();
+}
 
-		if (!ok) {
-			break;
+static int
+render_quad_nodes(const struct RenderList *list)
+{
+	if (!shader_bind(rndr.quad_pipeline.shader)) {
+		return 0;
+	}
+	shader_uniform_set_mat4(&rndr.quad_pipeline.u_projection, &rndr.projection);
+
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	int ok = render_quad_pass(list, 1);
+
+	glEnable(GL_BLEND);
+	glDepthMask(GL_FALSE);
+	ok = ok && render_quad_pass(list, 0);
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_DEPTH_TEST);
+	return ok;
+}
+
+static int
+render_starfield_node(const struct RenderNode *node)
+{
+	// map clip space back to world space, for the stars to stay in place
+	// regardless of the resolution and orientation of the output
+	const float *proj = rndr.projection.data;
+	Vec unproject = {{
+		1.0f / proj[0],
+		1.0f / proj[5],
+		-proj[3] / proj[0],
+		-proj[7] / proj[5]
+	}};
+	shader_uniform_set_vec4(&rndr.starfield_pipeline.u_unproject, &unproject);
+	shader_uniform_set_float(&rndr.starfield_pipeline.u_scroll, node->scroll);
+
+	glBindVertexArray(rndr.starfield_pipeline.vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+int
+render_list_exec(struct RenderList *list)
+{
+	// the background goes first, then everything else in the order it was
+	// added
+	int ok = 1;
+	for (size_t i = 0; ok && i < list->len; i++) {
+		if (list->nodes[i].type == RENDER_NODE_STARFIELD) {
+			ok = (
+				shader_bind(rndr.starfield_pipeline.shader) &&
+				render_starfield_node(&list->nodes[i])
+			);
 		}
 	}
+	ok = ok && render_quad_nodes(list);
 	list->len = 0;
 
 	return ok;
-}
\ No newline at end of file
+}
+
+struct RenderTarget {
+	GLuint fbo;
+	GLuint texture;   // single layer array, to be drawn as a sprite
+	GLuint depth;
+	unsigned width, height;
+	float scale;      // fraction of the size to render into and draw
+};
+
+struct RenderTarget*
+render_target_new(unsigned width, unsigned height)
+{
+	assert(rndr.initialized);
+
+	struct RenderTarget *target = make(struct RenderTarget);
+	if (!target) {
+		return NULL;
+	}
+	target->width = width;
+	target->height = height;
+	target->scale = 1.0f;
+
+	// create the color texture
+	glGenTextures(1, &target->texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, target->texture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage3D(
+		GL_TEXTURE_2D_ARRAY,
+		0,
+		GL_RGBA8,
+		width,
+		height,
+		1,
+		0,
+		GL_RGBA,
+		GL_UNSIGNED_BYTE,
+		NULL
+	);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// create the depth buffer, for sprites to be drawn as on the screen
+	glGenRenderbuffers(1, &target->depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, target->depth);
+	glRenderbufferStorage(
+		GL_RENDERBUFFER,
+		GL_DEPTH_COMPONENT24,
+		width,
+		height
+	);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	// attach them to a framebuffer
+	glGenFramebuffers(1, &target->fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+	glFramebufferTextureLayer(
+		GL_FRAMEBUFFER,
+		GL_COLOR_ATTACHMENT0,
+		target->texture,
+		0,
+		0
+	);
+	glFramebufferRenderbuffer(
+		GL_FRAMEBUFFER,
+		GL_DEPTH_ATTACHMENT,
+		GL_RENDERBUFFER,
+		target->depth
+	);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, rndr.screen_fbo);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE || glGetError() != GL_NO_ERROR) {
+		fprintf(stderr, "failed to create render target\n");
+		error(ERR_OPENGL);
+		render_target_destroy(target);
+		return NULL;
+	}
+
+	return target;
+}
+
+void
+render_target_destroy(struct RenderTarget *target)
+{
+	if (target) {
+		glDeleteFramebuffers(1, &target->fbo);
+		glDeleteRenderbuffers(1, &target->depth);
+		glDeleteTextures(1, &target->texture);
+		destroy(target);
+	}
+}
+
+void
+render_target_set_scale(struct RenderTarget *target, float scale)
+{
+	assert(scale > 0 && scale <= 1);
+	target->scale = scale;
+}
+
+static unsigned
+scaled_width(const struct RenderTarget *target)
+{
+	unsigned width = target->width * target->scale + 0.5f;
+	return width > 0 ? width : 1;
+}
+
+static unsigned
+scaled_height(const struct RenderTarget *target)
+{
+	unsigned height = target->height * target->scale + 0.5f;
+	return height > 0 ? height : 1;
+}
+
+int
+render_list_exec_target(struct RenderList *list, struct RenderTarget *target)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+	glViewport(0, 0, scaled_width(target), scaled_height(target));
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// flip the projection vertically, for the first texture row to be the
+	// top one, as it is for images
+	Mat projection = rndr.projection;
+	for (int i = 4; i < 8; i++) {
+		rndr.projection.data[i] = -rndr.projection.data[i];
+	}
+
+	int ok = render_list_exec(list);
+
+	rndr.projection = projection;
+	glViewport(0, 0, rndr.width, rndr.height);
+	glBindFramebuffer(GL_FRAMEBUFFER, rndr.screen_fbo);
+
+	return ok && glGetError() == GL_NO_ERROR;
+}
+
+int
+render_target_draw(
+	const struct RenderTarget *target,
+	float x,
+	float y,
+	float width,
+	float height
+) {
+	if (!shader_bind(rndr.target_pipeline.shader)) {
+		return 0;
+	}
+	shader_uniform_set_mat4(
+		&rndr.target_pipeline.u_projection,
+		&rndr.projection
+	);
+
+	// stretch the rendered part of the target over given area; texture
+	// coordinates are in texels, thus, the quad is scaled
+	float tex_width = scaled_width(target);
+	float tex_height = scaled_height(target);
+	Affine2 transform;
+	affine2_ident(&transform);
+	affine2_translate(&transform, x - rndr.width / 2, -y + rndr.height / 2);
+	affine2_scale(&transform, width / tex_width, height / tex_height);
+
+	struct QuadInstance *inst = add_quad(QUAD_SPRITE, target->texture);
+	if (!inst) {
+		return 0;
+	}
+	memcpy(inst->transform, transform.data, sizeof(inst->transform));
+	inst->size[0] = tex_width;
+	inst->size[1] = tex_height;
+	return flush_quads();
+}
+
+int
+render_target_blit(const struct RenderTarget *target)
+{
+	// rows of the target are stored top one first, see
+	// render_list_exec_target()
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, target->fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, rndr.screen_fbo);
+	glBlitFramebuffer(
+		0,
+		0,
+		scaled_width(target),
+		scaled_height(target),
+		0,
+		rndr.height,
+		rndr.width,
+		0,
+		GL_COLOR_BUFFER_BIT,
+		GL_LINEAR
+	);
+	glBindFramebuffer(GL_FRAMEBUFFER, rndr.screen_fbo);
+	return glGetError() == GL_NO_ERROR;
+}
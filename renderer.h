@@ -58,18 +58,107 @@ render_list_add_widget(
 	float y
 );
 
+/**
+ * Add the starfield background to render list.
+ *
+ * Stars are generated procedurally by a single full-screen draw, in a few
+ * layers at different depths, which scroll by given offset in pixels
+ * multiplied by their parallax factor.
+ */
+void
+render_list_add_starfield(struct RenderList *list, float scroll);
+
 /**
  * Execute a render list.
  */
 int
 render_list_exec(struct RenderList *list);
 
+/**
+ * Offscreen render target.
+ *
+ * Render lists can be executed into a target, whose contents can then be
+ * drawn on the screen any number of times. Targets hold premultiplied alpha.
+ */
+struct RenderTarget;
+
+/**
+ * Create a render target of given size in pixels.
+ */
+struct RenderTarget*
+render_target_new(unsigned width, unsigned height);
+
+void
+render_target_destroy(struct RenderTarget *target);
+
+/**
+ * Set the fraction of the target size to render into, 1 by default.
+ *
+ * Lists are executed into the scaled down part of the target only, which is
+ * stretched over the whole area when drawn, thus, trading sharpness for
+ * fill rate.
+ */
+void
+render_target_set_scale(struct RenderTarget *target, float scale);
+
+/**
+ * Execute a render list into a render target.
+ *
+ * The target is cleared to transparent first. Node coordinates are the same
+ * as for the screen, scaled to the size of the target.
+ */
+int
+render_list_exec_target(struct RenderList *list, struct RenderTarget *target);
+
+/**
+ * Draw the contents of a render target, stretched to given size, with the
+ * top-left corner at given screen position.
+ */
+int
+render_target_draw(
+	const struct RenderTarget *target,
+	float x,
+	float y,
+	float width,
+	float height
+);
+
+/**
+ * Copy the contents of a render target, stretched over the whole screen,
+ * replacing what's there.
+ *
+ * Much cheaper than drawing it, which blends the contents, thus, fit for
+ * targets rendered the first thing in a frame.
+ */
+int
+render_target_blit(const struct RenderTarget *target);
+
 /**
  * Initialize rendering system.
  */
 int
 renderer_init(unsigned width, unsigned height);
 
+/**
+ * Initialize rendering system without a window, for benchmarks and tests on
+ * machines without a display.
+ *
+ * Frames are rendered into an offscreen framebuffer of given size, through
+ * an OpenGL context created with EGL, preferably on Mesa's surfaceless
+ * platform. Presenting only flushes the rendering, thus, frames are to be
+ * read back with `capture_frame()`.
+ */
+int
+renderer_init_headless(unsigned width, unsigned height);
+
+/**
+ * Get the refresh rate of the display the window is on, in Hz.
+ *
+ * Returns 0 if it's unknown, which is always the case when headless.
+ */
+float
+renderer_get_refresh_rate(void);
+
 /**
  * Clean-up and shut down renderer.
  */
@@ -0,0 +1,287 @@
+#include "bitstream.h"
+#include "clock.h"
+#include "error.h"
+#include "memory.h"
+#include "rollback.h"
+#include <assert.h>
+#include <stdlib.h>
+
+struct Frame {
+	int inputs[ROLLBACK_PLAYERS];
+	struct WorldSnapshot state;   // world state at the start of the frame
+	struct SpawnLog spawns;       // spawns requested by the script
+};
+
+struct Rollback {
+	struct World *world;
+	struct ScriptEnv *env;
+	struct NetSocket *sock;
+	struct NetAddress peer;
+	int local;                    // local player index
+	int remote;                   // remote player index
+
+	uint32_t frame;               // next frame to simulate
+	uint32_t max_frame;           // frames simulated at least once
+	uint32_t remote_frame;        // remote input is known before this frame
+	uint32_t acked_frame;         // peer has local input before this frame
+	uint32_t bad_frame;           // first mispredicted frame
+	int mispredicted;
+	int running;
+
+	struct Frame frames[ROLLBACK_MAX_FRAMES];
+
+	unsigned long rollbacks;
+	unsigned long resimulated;
+	double resim_time;
+};
+
+static struct Frame*
+get_frame(struct Rollback *rb, uint32_t frame)
+{
+	return &rb->frames[frame % ROLLBACK_MAX_FRAMES];
+}
+
+struct Rollback*
+rollback_new(
+	struct World *world,
+	struct ScriptEnv *env,
+	int player,
+	uint16_t port,
+	const char *peer,
+	const struct NetConditions *conditions
+) {
+	assert(world != NULL);
+	assert(env != NULL);
+	assert(player >= 0 && player < ROLLBACK_PLAYERS);
+
+	struct Rollback *rb = make(struct Rollback);
+	if (!rb) {
+		return NULL;
+	}
+	rb->world = world;
+	rb->env = env;
+	rb->local = player;
+	rb->remote = !player;
+	rb->running = 1;
+
+	if (!net_address_parse(peer, &rb->peer)) {
+		error(ERR_NET);
+		goto error;
+	}
+	if (!(rb->sock = net_socket_new(port, conditions))) {
+		goto error;
+	}
+
+	return rb;
+
+error:
+	rollback_destroy(rb);
+	return NULL;
+}
+
+void
+rollback_destroy(struct Rollback *rb)
+{
+	if (rb) {
+		for (size_t i = 0; i < ROLLBACK_MAX_FRAMES; i++) {
+			world_snapshot_release(&rb->frames[i].state);
+			spawn_log_release(&rb->frames[i].spawns);
+		}
+		net_socket_destroy(rb->sock);
+		destroy(rb);
+	}
+}
+
+/**
+ * Simulate a frame, with its state already saved.
+ */
+static int
+simulate(struct Rollback *rb, uint32_t frame)
+{
+	struct World *world = rb->world;
+	struct Frame *f = get_frame(rb, frame);
+
+	// apply the combined actions of both players
+	world_set_actions(world, f->inputs[0] | f->inputs[1]);
+
+	rb->running = world_update(world, SIMULATION_STEP);
+
+	// tick the script at the end of each tick period, or replay what it
+	// requested when the frame is simulated again
+	if ((frame + 1) % STEPS_PER_TICK != 0) {
+		return 1;
+	}
+	if (frame >= rb->max_frame) {
+		f->spawns.count = 0;
+		world->spawn_log = &f->spawns;
+		int ok = script_env_tick(rb->env);
+		world->spawn_log = NULL;
+		return ok;
+	}
+	for (size_t i = 0; i < f->spawns.count; i++) {
+		if (!world_request_spawn(world, &f->spawns.requests[i])) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int
+step(struct Rollback *rb, uint32_t frame)
+{
+	if (!world_save(rb->world, &get_frame(rb, frame)->state) ||
+	    !simulate(rb, frame)) {
+		return 0;
+	}
+	if (frame >= rb->max_frame) {
+		rb->max_frame = frame + 1;
+	}
+	return 1;
+}
+
+static void
+receive_input(struct Rollback *rb, uint32_t frame, int actions)
+{
+	// only the next unknown frame is of interest, the rest are either
+	// duplicates or arrive out of order and will be sent again; input for
+	// frames past the current one would overwrite the frames which may yet
+	// be rolled back to, thus, is taken once the session gets there
+	if (frame != rb->remote_frame || frame > rb->frame) {
+		return;
+	}
+
+	// frames not simulated yet get the input as their prediction
+	struct Frame *f = get_frame(rb, frame);
+	if (frame < rb->frame && f->inputs[rb->remote] != actions) {
+		if (!rb->mispredicted || frame < rb->bad_frame) {
+			rb->bad_frame = frame;
+		}
+		rb->mispredicted = 1;
+	}
+	f->inputs[rb->remote] = actions;
+	rb->remote_frame++;
+}
+
+static int
+receive_inputs(struct Rollback *rb)
+{
+	uint8_t buf[NET_MAX_PACKET_SIZE];
+	struct NetAddress from;
+	int len;
+	while ((len = net_recv(rb->sock, &from, buf, sizeof(buf))) > 0) {
+		if (!net_address_equal(&from, &rb->peer)) {
+			continue;
+		}
+
+		struct BitReader r;
+		bit_reader_init(&r, buf, len);
+		uint32_t acked = bit_read(&r, 32);
+		uint32_t first = bit_read(&r, 32);
+		unsigned count = bit_read(&r, 8);
+		if (r.overflow) {
+			continue;
+		}
+		if (acked > rb->acked_frame && acked <= rb->frame) {
+			rb->acked_frame = acked;
+		}
+		for (unsigned i = 0; i < count; i++) {
+			int actions = bit_read(&r, ACTION_BITS);
+			if (r.overflow) {
+				break;
+			}
+			receive_input(rb, first + i, actions);
+		}
+	}
+	return len >= 0;
+}
+
+/**
+ * Send local input the peer hasn't acknowledged yet, along with the
+ * acknowledgement of its input.
+ */
+static int
+send_inputs(struct Rollback *rb)
+{
+	uint8_t buf[64];
+	struct BitWriter w;
+	bit_writer_init(&w, buf, sizeof(buf));
+
+	uint32_t first = rb->acked_frame;
+	unsigned count = rb->frame - first;
+	assert(count <= ROLLBACK_MAX_FRAMES);
+	bit_write(&w, rb->remote_frame, 32);
+	bit_write(&w, first, 32);
+	bit_write(&w, count, 8);
+	for (unsigned i = 0; i < count; i++) {
+		bit_write(&w, get_frame(rb, first + i)->inputs[rb->local], ACTION_BITS);
+	}
+	assert(!w.overflow);
+	return net_send(rb->sock, &rb->peer, buf, bit_writer_bytes(&w));
+}
+
+int
+rollback_poll(struct Rollback *rb)
+{
+	if (!receive_inputs(rb)) {
+		return 0;
+	}
+
+	if (rb->mispredicted) {
+		double start = clock_now();
+		world_restore(rb->world, &get_frame(rb, rb->bad_frame)->state);
+		for (uint32_t frame = rb->bad_frame; frame < rb->frame; frame++) {
+			if (!step(rb, frame)) {
+				return 0;
+			}
+			rb->resimulated++;
+		}
+		rb->resim_time += clock_now() - start;
+		rb->rollbacks++;
+		rb->mispredicted = 0;
+	}
+
+	return send_inputs(rb);
+}
+
+int
+rollback_can_advance(const struct Rollback *rb)
+{
+	// the state to roll back to and unacknowledged input must not be
+	// overwritten
+	return (
+		rb->frame < rb->remote_frame + ROLLBACK_MAX_FRAMES - 1 &&
+		rb->frame < rb->acked_frame + ROLLBACK_MAX_FRAMES - 1
+	);
+}
+
+int
+rollback_advance(struct Rollback *rb, int actions, int *r_running)
+{
+	assert(rollback_can_advance(rb));
+
+	// predict the remote input to stay as it was
+	struct Frame *f = get_frame(rb, rb->frame);
+	f->inputs[rb->local] = actions;
+	if (rb->frame >= rb->remote_frame) {
+		f->inputs[rb->remote] = (
+			rb->remote_frame > 0 ?
+			get_frame(rb, rb->remote_frame - 1)->inputs[rb->remote] :
+			0
+		);
+	}
+
+	int ok = step(rb, rb->frame);
+	rb->frame++;
+	*r_running = rb->running;
+	return ok && send_inputs(rb);
+}
+
+void
+rollback_get_stats(const struct Rollback *rb, struct RollbackStats *r_stats)
+{
+	r_stats->frame = rb->frame;
+	r_stats->confirmed = rb->remote_frame < rb->frame ? rb->remote_frame : rb->frame;
+	r_stats->rollbacks = rb->rollbacks;
+	r_stats->resimulated = rb->resimulated;
+	r_stats->resim_time = rb->resim_time;
+}
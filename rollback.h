@@ -0,0 +1,83 @@
+#pragma once
+
+#include "game.h"
+#include "net.h"
+#include "script.h"
+
+#define ROLLBACK_MAX_FRAMES 16   // frames which can be rolled back
+#define ROLLBACK_PLAYERS 2
+
+/**
+ * Rollback session.
+ *
+ * Runs the same world on two peers in lockstep of fixed `SIMULATION_STEP`
+ * frames, without waiting for the remote input: missing remote input is
+ * predicted to stay as it was last received, and when the actual input
+ * turns out to differ, the world is restored to the state of the first
+ * mispredicted frame and all frames since are simulated again.
+ *
+ * Both players' actions are combined onto the world's ship. Lua state can't
+ * be saved, thus, the script is ticked only the first time a frame is
+ * simulated, and the spawn requests it made are replayed when the frame is
+ * simulated again. Peers stay in sync only if their simulation is
+ * deterministic; builds with `PHYSICS_FIXED_POINT` are across platforms,
+ * provided that scripts draw their random numbers from the same seed rather
+ * than from the C library.
+ */
+struct Rollback;
+
+/**
+ * Start a session on given world.
+ *
+ * The world and script environment must be in the same state on both peers,
+ * including the script's random numbers, seeded alike with `script_env_seed()`.
+ */
+struct Rollback*
+rollback_new(
+	struct World *world,
+	struct ScriptEnv *env,
+	int player,
+	uint16_t port,
+	const char *peer,
+	const struct NetConditions *conditions
+);
+
+void
+rollback_destroy(struct Rollback *rb);
+
+/**
+ * Exchange input with the peer, rolling back and simulating again the
+ * frames which turn out to have been mispredicted.
+ */
+int
+rollback_poll(struct Rollback *rb);
+
+/**
+ * Tell whether the next frame can be simulated.
+ *
+ * The session stalls if the remote peer falls `ROLLBACK_MAX_FRAMES` behind.
+ */
+int
+rollback_can_advance(const struct Rollback *rb);
+
+/**
+ * Simulate the next frame with given local player actions.
+ *
+ * Sets `r_running` to 0 if the game is over.
+ */
+int
+rollback_advance(struct Rollback *rb, int actions, int *r_running);
+
+/**
+ * Rollback statistics.
+ */
+struct RollbackStats {
+	unsigned long frame;          // next frame to simulate
+	unsigned long confirmed;      // frames with both inputs known
+	unsigned long rollbacks;
+	unsigned long resimulated;    // frames simulated again
+	double resim_time;            // time spent simulating again, seconds
+};
+
+void
+rollback_get_stats(const struct Rollback *rb, struct RollbackStats *r_stats);
@@ -0,0 +1,385 @@
+#include "clock.h"
+#include "error.h"
+#include "rollback.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Rollback test and benchmark.
+ *
+ * Runs two rollback sessions in the same process, talking to each other over
+ * loopback with simulated network conditions, each with its own random
+ * input. Once both have simulated given number of frames with all input
+ * confirmed, their worlds must be identical. Then measures what a rollback
+ * costs: restoring the world and simulating frames again.
+ *
+ * Options are those of the game: `--net-loss P`, `--net-latency MS` and
+ * `--net-jitter MS`, as well as `--frames N` and `--port PORT`, the port of
+ * the first peer, the second one using the next.
+ */
+
+#define DEFAULT_FRAMES 600
+#define DEFAULT_PORT 7101
+#define SCRIPT_SEED 1
+#define INPUT_PERIOD 8            // frames between input changes, on average
+#define STALL_TIMEOUT 10.0        // seconds without progress before failing
+#define BENCH_MIN_TIME 0.05       // seconds to run each benchmark for at least
+#define FRAME_BUDGET 0.016        // seconds
+
+struct Peer {
+	struct World *world;
+	struct ScriptEnv *env;
+	struct Rollback *rb;
+	unsigned long frame;          // frames advanced
+	uint32_t random;              // input generator state
+	int actions;
+};
+
+static struct {
+	unsigned long frames;
+	uint16_t port;
+	struct NetConditions net;
+} opts = {
+	DEFAULT_FRAMES,
+	DEFAULT_PORT,
+	{ 0.1f, 0.03f, 0.01f },
+};
+
+static int
+parse_args(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; i++) {
+		int has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--frames") == 0 && has_value) {
+			opts.frames = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--port") == 0 && has_value) {
+			int port = atoi(argv[++i]);
+			if (port <= 0 || port >= 65535) {
+				fprintf(stderr, "bad port `%s`\n", argv[i]);
+				return 0;
+			}
+			opts.port = port;
+		} else if (strcmp(argv[i], "--net-loss") == 0 && has_value) {
+			opts.net.loss = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--net-latency") == 0 && has_value) {
+			opts.net.latency = atof(argv[++i]) / 1000.0f;
+		} else if (strcmp(argv[i], "--net-jitter") == 0 && has_value) {
+			opts.net.jitter = atof(argv[++i]) / 1000.0f;
+		} else {
+			fprintf(
+				stderr,
+				"usage: %s [--frames N] [--port PORT]\n"
+				"       [--net-loss P] [--net-latency MS] [--net-jitter MS]\n",
+				argv[0]
+			);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*******************************************************************************
+ * Peers.
+*******************************************************************************/
+
+/**
+ * Start a game and a session with the other peer, in the same state as that
+ * of the other peer.
+ */
+static int
+peer_init(struct Peer *p, int player)
+{
+	char addr[32];
+	uint16_t port = opts.port + player;
+	snprintf(addr, sizeof(addr), "127.0.0.1:%u", opts.port + !player);
+
+	if (!(p->env = script_env_new()) || !(p->world = world_new())) {
+		return 0;
+	}
+	p->world->quiet = 1;
+
+	// math.random of both scripts must draw the same numbers
+	if (!script_env_init(p->env, p->world)) {
+		return 0;
+	}
+	script_env_seed(p->env, SCRIPT_SEED);
+	if (!script_env_load_file(p->env, "data/scripts/game.lua") ||
+	    !script_env_tick(p->env)) {
+		return 0;
+	}
+
+	p->random = 2463534242u + player;
+	return (p->rb = rollback_new(
+		p->world,
+		p->env,
+		player,
+		port,
+		addr,
+		&opts.net
+	)) != NULL;
+}
+
+static void
+peer_cleanup(struct Peer *p)
+{
+	rollback_destroy(p->rb);
+	script_env_destroy(p->env);
+	world_destroy(p->world);
+}
+
+/**
+ * Get the actions of the next frame, which change every `INPUT_PERIOD`
+ * frames on average, for mispredictions to happen now and then.
+ */
+static int
+next_actions(struct Peer *p)
+{
+	// xorshift32
+	p->random ^= p->random << 13;
+	p->random ^= p->random >> 17;
+	p->random ^= p->random << 5;
+	if (p->random % INPUT_PERIOD == 0) {
+		p->actions = (p->random >> 8) & (
+			ACTION_MOVE_LEFT |
+			ACTION_MOVE_RIGHT |
+			ACTION_SHOOT
+		);
+	}
+	return p->actions;
+}
+
+/**
+ * Exchange input and advance the session as far as the other peer allows.
+ */
+static int
+peer_update(struct Peer *p)
+{
+	if (!rollback_poll(p->rb)) {
+		return 0;
+	}
+	while (p->frame < opts.frames && rollback_can_advance(p->rb)) {
+		// the game may be over on one path of predictions but not
+		// on another, thus, the session carries on regardless
+		int running;
+		if (!rollback_advance(p->rb, next_actions(p), &running)) {
+			return 0;
+		}
+		p->frame++;
+	}
+	return 1;
+}
+
+/**
+ * Run both peers until all of their frames are confirmed.
+ */
+static int
+run(struct Peer *peers)
+{
+	double last_progress = clock_now();
+	unsigned long last_confirmed = 0;
+	for (;;) {
+		unsigned long confirmed = 0;
+		for (int i = 0; i < ROLLBACK_PLAYERS; i++) {
+			struct RollbackStats stats;
+			if (!peer_update(&peers[i])) {
+				return 0;
+			}
+			rollback_get_stats(peers[i].rb, &stats);
+			confirmed += stats.confirmed;
+		}
+		if (confirmed == opts.frames * ROLLBACK_PLAYERS) {
+			return 1;
+		}
+
+		// delayed packets are sent by polling, thus, the peers wait
+		// for each other only briefly
+		double now = clock_now();
+		if (confirmed > last_confirmed) {
+			last_confirmed = confirmed;
+			last_progress = now;
+		} else if (now - last_progress > STALL_TIMEOUT) {
+			printf("stalled at %lu confirmed frames\n", confirmed);
+			return 0;
+		}
+		SDL_Delay(1);
+	}
+}
+
+/**
+ * Compare the worlds of both peers, as far as they can be observed.
+ */
+static int
+compare_worlds(struct World *a, struct World *b)
+{
+	struct WorldFrame fa = { 0 }, fb = { 0 };
+	int same = 0;
+	if (!world_extract(a, &fa) || !world_extract(b, &fb)) {
+		goto cleanup;
+	}
+
+	if (a->time != b->time) {
+		printf("world time differs: %f vs %f\n", a->time, b->time);
+	} else if (memcmp(&a->player, &b->player, sizeof(a->player)) != 0) {
+		printf(
+			"player differs: (%f, %f) %.0fhp vs (%f, %f) %.0fhp\n",
+			a->player.x,
+			a->player.y,
+			a->player.hitpoints,
+			b->player.x,
+			b->player.y,
+			b->player.hitpoints
+		);
+	} else if (fa.renderable_count != fb.renderable_count) {
+		printf(
+			"entity count differs: %zu vs %zu\n",
+			fa.renderable_count,
+			fb.renderable_count
+		);
+	} else {
+		same = 1;
+		for (size_t i = 0; i < fa.renderable_count; i++) {
+			struct Renderable *ra = &fa.renderables[i];
+			struct Renderable *rb = &fb.renderables[i];
+			if (memcmp(ra, rb, sizeof(*ra)) != 0) {
+				printf(
+					"entity %zu differs: (%f, %f) vs (%f, %f)\n",
+					i,
+					ra->x,
+					ra->y,
+					rb->x,
+					rb->y
+				);
+				same = 0;
+				break;
+			}
+		}
+	}
+
+cleanup:
+	world_frame_release(&fa);
+	world_frame_release(&fb);
+	return same;
+}
+
+/*******************************************************************************
+ * Benchmark.
+*******************************************************************************/
+
+/**
+ * Measure the time to roll back given number of frames, in seconds.
+ *
+ * Spawn requests of the script aren't replayed, which costs next to nothing
+ * compared to the simulation.
+ */
+static double
+measure_rollback(struct World *world, const struct WorldSnapshot *snap, int frames)
+{
+	for (unsigned long count = 16;; count *= 2) {
+		double start = clock_now();
+		for (unsigned long i = 0; i < count; i++) {
+			world_restore(world, snap);
+			for (int f = 0; f < frames; f++) {
+				world_set_actions(world, f & ACTION_SHOOT);
+				world_update(world, SIMULATION_STEP);
+			}
+		}
+		double elapsed = clock_now() - start;
+		if (elapsed >= BENCH_MIN_TIME) {
+			world_restore(world, snap);
+			return elapsed / count;
+		}
+	}
+}
+
+static int
+bench(struct World *world)
+{
+	struct WorldSnapshot snap = { 0 };
+	if (!world_save(world, &snap)) {
+		return 0;
+	}
+
+	printf(
+		"%zu entities, %.0fhp\n",
+		ecs_count(world->ecs, 0),
+		world->player.hitpoints
+	);
+	static const int depths[] = { 1, 2, 4, 8, ROLLBACK_MAX_FRAMES - 1 };
+	printf("%8s %12s %14s\n", "frames", "us/rollback", "frames/16ms");
+	for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+		int frames = depths[i];
+		double t = measure_rollback(world, &snap, frames);
+		printf(
+			"%8d %12.1f %14.0f\n",
+			frames,
+			t * 1e6,
+			FRAME_BUDGET / t * frames
+		);
+	}
+
+	world_snapshot_release(&snap);
+	return 1;
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (!parse_args(argc, argv)) {
+		return EXIT_FAILURE;
+	}
+
+	int ok = 1;
+	struct Peer peers[ROLLBACK_PLAYERS] = { { 0 } };
+	for (int i = 0; i < ROLLBACK_PLAYERS; i++) {
+		if (!peer_init(&peers[i], i)) {
+			ok = 0;
+			goto cleanup;
+		}
+	}
+
+	printf(
+		"%lu frames, %.0f%% loss, %.0fms latency, %.0fms jitter\n",
+		opts.frames,
+		opts.net.loss * 100.0,
+		opts.net.latency * 1000.0,
+		opts.net.jitter * 1000.0
+	);
+	double start = clock_now();
+	if (!run(peers)) {
+		ok = 0;
+		goto cleanup;
+	}
+	for (int i = 0; i < ROLLBACK_PLAYERS; i++) {
+		struct RollbackStats stats;
+		rollback_get_stats(peers[i].rb, &stats);
+		printf(
+			"peer %d: %lu rollbacks, %lu frames simulated again\n",
+			i,
+			stats.rollbacks,
+			stats.resimulated
+		);
+	}
+	printf("confirmed in %.2fs\n", clock_now() - start);
+
+	if (!compare_worlds(peers[0].world, peers[1].world)) {
+		printf("peers are out of sync\n");
+		ok = 0;
+		goto cleanup;
+	}
+	printf("peers are in sync\n");
+
+	ok = bench(peers[0].world);
+
+cleanup:
+	for (int i = 0; i < ROLLBACK_PLAYERS; i++) {
+		peer_cleanup(&peers[i]);
+	}
+
+	ok &= !error_is_set();
+	if (!ok) {
+		error_dump(stdout);
+	}
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -101,9 +101,15 @@ luafunc_add_asteroid(lua_State *state)
 	get_args(state, args, &x, &y, &xvel, &yvel, &rot_speed);
 
 	struct World *world = get_world_upvalue(state);
-	struct Asteroid *ast = asteroid_new(x, y, xvel, yvel, rot_speed);
-	if (!ast || !world_add_asteroid(world, ast)) {
-		asteroid_destroy(ast);
+	struct SpawnRequest req = {
+		.kind = SPAWN_ASTEROID,
+		.x = x,
+		.y = y,
+		.xvel = xvel,
+		.yvel = yvel,
+		.rot_speed = rot_speed,
+	};
+	if (!world_request_spawn(world, &req)) {
 		return luaL_error(state, "add_asteroid() call failed");
 	}
 
@@ -128,22 +134,103 @@ luafunc_add_enemy(lua_State *state)
 	lua_Number x, y;
 	get_args(state, args, &x, &y);
 
-	struct Enemy *enemy = enemy_new(x, y);
 	struct World *world = get_world_upvalue(state);
-	if (!enemy || !world_add_enemy(world, enemy)) {
-		enemy_destroy(enemy);
+	struct SpawnRequest req = {
+		.kind = SPAWN_ENEMY,
+		.x = x,
+		.y = y,
+	};
+	if (!world_request_spawn(world, &req)) {
 		return luaL_error(state, "add_enemy() call failed");
 	}
 
 	return 0;
 }
 
+/**
+ * Draw the next number from script's own generator (splitmix64).
+ */
+static uint64_t
+next_random(struct ScriptEnv *env)
+{
+	uint64_t z = (env->random_state += UINT64_C(0x9e3779b97f4a7c15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+	return z ^ (z >> 31);
+}
+
+/**
+ * Replacement of `math.random()`, taking the same arguments.
+ *
+ * Arguments:
+ *     m:     Optional, upper bound of integers to draw, or the lower one,
+ *            if followed by `n`. Without arguments, a float in [0, 1) is
+ *            drawn.
+ *     n:     Optional, upper bound.
+ */
+static int
+luafunc_random(lua_State *state)
+{
+	struct ScriptEnv *env = lua_touserdata(state, lua_upvalueindex(1));
+
+	// 53 bits, as many as a double holds
+	double r = (next_random(env) >> 11) * (1.0 / (UINT64_C(1) << 53));
+	lua_Integer low, up;
+	switch (lua_gettop(state)) {
+	case 0:
+		lua_pushnumber(state, r);
+		return 1;
+	case 1:
+		low = 1;
+		up = luaL_checkinteger(state, 1);
+		break;
+	case 2:
+		low = luaL_checkinteger(state, 1);
+		up = luaL_checkinteger(state, 2);
+		break;
+	default:
+		return luaL_error(state, "wrong number of arguments");
+	}
+	luaL_argcheck(state, low <= up, 1, "interval is empty");
+	lua_pushinteger(state, low + (lua_Integer)(r * ((double)up - low + 1)));
+	return 1;
+}
+
+/**
+ * Replacement of `math.randomseed()`.
+ *
+ * Arguments:
+ *     x:     Seed.
+ */
+static int
+luafunc_randomseed(lua_State *state)
+{
+	struct ScriptEnv *env = lua_touserdata(state, lua_upvalueindex(1));
+	env->random_state = (lua_Integer)luaL_checknumber(state, 1);
+	return 0;
+}
+
+/**
+ * Replacement of `print()` for quiet worlds, ignoring its arguments.
+ */
+static int
+luafunc_ignore(lua_State *state)
+{
+	return 0;
+}
+
 static const luaL_Reg reg[] = {
 	{ "add_asteroid", luafunc_add_asteroid },
 	{ "add_enemy", luafunc_add_enemy },
 	{ NULL, NULL }
 };
 
+static const luaL_Reg random_reg[] = {
+	{ "random", luafunc_random },
+	{ "randomseed", luafunc_randomseed },
+	{ NULL, NULL }
+};
+
 static const struct {
 	const char *name;
 	lua_Number value;
@@ -171,13 +258,9 @@ script_env_new(void)
 
 	luaL_openlibs(env->state);
 
+	env->chunk = LUA_NOREF;
 	env->tick_func = LUA_NOREF;
 
-	// retrieve version and print it
-	lua_getglobal(env->state, "_VERSION");
-	printf("Initialized %s environment\n", lua_tostring(env->state, -1));
-	lua_pop(env->state, 1);
-
 	return env;
 }
 
@@ -204,13 +287,25 @@ script_env_init(struct ScriptEnv *env, struct World *world)
 	// register the library as `game` global
 	lua_setglobal(env->state, "game");
 
+	// scripts of quiet worlds print nothing either, otherwise, retrieve
+	// version and print it
+	env->quiet = world->quiet;
+	if (env->quiet) {
+		lua_pushcfunction(env->state, luafunc_ignore);
+		lua_setglobal(env->state, "print");
+	} else {
+		lua_getglobal(env->state, "_VERSION");
+		printf("Initialized %s environment\n", lua_tostring(env->state, -1));
+		lua_pop(env->state, 1);
+	}
+
 	return 1;
 }
 
 int
 script_env_load_file(struct ScriptEnv *env, const char *filename)
 {
-	if (luaL_dofile(env->state, filename)) {
+	if (luaL_loadfile(env->state, filename) != LUA_OK) {
 		fprintf(
 			stderr,
 			"failed to load Lua script file `%s`:\n%s\n",
@@ -220,12 +315,41 @@ script_env_load_file(struct ScriptEnv *env, const char *filename)
 		error(ERR_SCRIPT_LOAD);
 		return 0;
 	}
+	luaL_unref(env->state, LUA_REGISTRYINDEX, env->chunk);
+	env->chunk = luaL_ref(env->state, LUA_REGISTRYINDEX);
+	if (!script_env_restart(env)) {
+		return 0;
+	}
 
 #ifdef DEBUG
-	printf("loaded script `%s`\n", filename);
+	if (!env->quiet) {
+		printf("loaded script `%s`\n", filename);
+	}
 #endif
 
+	return 1;
+}
+
+int
+script_env_restart(struct ScriptEnv *env)
+{
+	assert(env->chunk != LUA_NOREF);
+
+	lua_rawgeti(env->state, LUA_REGISTRYINDEX, env->chunk);
+	if (lua_pcall(env->state, 0, 0, 0) != LUA_OK) {
+		fprintf(
+			stderr,
+			"failed to run Lua script:\n%s\n",
+			lua_tostring(env->state, -1)
+		);
+		lua_pop(env->state, 1);
+		error(ERR_SCRIPT_LOAD);
+		return 0;
+	}
+
 	// check whether there's an update function and make a reference for it
+	luaL_unref(env->state, LUA_REGISTRYINDEX, env->tick_func);
+	env->tick_func = LUA_NOREF;
 	lua_getglobal(env->state, "tick");
 	if (lua_type(env->state, -1) == LUA_TFUNCTION) {
 		env->tick_func = luaL_ref(env->state, LUA_REGISTRYINDEX);
@@ -236,6 +360,16 @@ script_env_load_file(struct ScriptEnv *env, const char *filename)
 	return 1;
 }
 
+void
+script_env_seed(struct ScriptEnv *env, uint64_t seed)
+{
+	env->random_state = seed;
+	lua_getglobal(env->state, "math");
+	lua_pushlightuserdata(env->state, env);
+	luaL_setfuncs(env->state, random_reg, 1);
+	lua_pop(env->state, 1);
+}
+
 int
 script_env_tick(struct ScriptEnv *env)
 {
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "game.h"
+#include <stdint.h>
 
 struct ScriptEnv {
 	struct lua_State *state;
+	int chunk;              // reference to the loaded script
 	int tick_func;
+	uint64_t random_state;  // of `math.random()`, once seeded
+	int quiet;              // if set, as the world is, nothing is printed
 };
 
 struct ScriptEnv*
@@ -13,9 +17,29 @@ script_env_new(void);
 int
 script_env_init(struct ScriptEnv *env, struct World *world);
 
+/**
+ * Load a script file and run it.
+ */
 int
 script_env_load_file(struct ScriptEnv *env, const char *filename);
 
+/**
+ * Run the loaded script anew, without reading it again, thus, resetting
+ * the globals it defines.
+ */
+int
+script_env_restart(struct ScriptEnv *env);
+
+/**
+ * Make `math.random()` draw from a generator of the script's own, seeded by
+ * given value, instead of the C library one, shared by the whole process.
+ *
+ * Scripts seeded alike spawn alike, regardless of other scripts running on
+ * other threads.
+ */
+void
+script_env_seed(struct ScriptEnv *env, uint64_t seed);
+
 int
 script_env_tick(struct ScriptEnv *env);
 
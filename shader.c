@@ -15,6 +15,7 @@ compute_uniform_size(struct ShaderUniform *uniform)
 	case GL_INT:
 	case GL_SAMPLER_2D:
 	case GL_SAMPLER_2D_RECT:
+	case GL_SAMPLER_2D_ARRAY:
 	case GL_SAMPLER_1D:
 	case GL_INT_SAMPLER_1D:
 	case GL_UNSIGNED_INT_SAMPLER_1D:
@@ -43,6 +44,81 @@ compute_uniform_size(struct ShaderUniform *uniform)
 	return 0;  // unknown uniform type
 }
 
+static int
+name_table_init(struct ShaderNameTable *table, size_t count)
+{
+	table->slots = NULL;
+	table->size = 0;
+	if (count == 0) {
+		return 1;
+	}
+
+	// keep the load factor at or below 1/2; size must be a power of two
+	size_t size = 4;
+	while (size < count * 2) {
+		size *= 2;
+	}
+	if (!(table->slots = calloc(size, sizeof(GLuint)))) {
+		return 0;
+	}
+	table->size = size;
+	return 1;
+}
+
+static void
+name_table_insert(struct ShaderNameTable *table, unsigned hash, GLuint index)
+{
+	size_t mask = table->size - 1;
+	size_t slot = hash & mask;
+	while (table->slots[slot]) {
+		slot = (slot + 1) & mask;
+	}
+	table->slots[slot] = index + 1;
+}
+
+static void
+name_table_free(struct ShaderNameTable *table)
+{
+	free(table->slots);
+	table->slots = NULL;
+	table->size = 0;
+}
+
+static int
+init_uniform_table(
+	struct ShaderNameTable *table,
+	const struct ShaderUniform *uniforms,
+	size_t count
+) {
+	if (!name_table_init(table, count)) {
+		return 0;
+	}
+	for (size_t i = 0; i < count; i++) {
+		name_table_insert(table, uniforms[i].hash, i);
+	}
+	return 1;
+}
+
+static const struct ShaderUniform*
+find_uniform(
+	const struct ShaderNameTable *table,
+	const struct ShaderUniform *uniforms,
+	const char *name
+) {
+	if (table->size == 0) {
+		return NULL;
+	}
+	unsigned hash = string_hash(name);
+	size_t mask = table->size - 1;
+	for (size_t slot = hash & mask; table->slots[slot]; slot = (slot + 1) & mask) {
+		const struct ShaderUniform *uniform = &uniforms[table->slots[slot] - 1];
+		if (uniform->hash == hash && strcmp(uniform->name, name) == 0) {
+			return uniform;
+		}
+	}
+	return NULL;
+}
+
 struct ShaderSource*
 shader_source_from_string(const char *source, GLenum type)
 {
@@ -149,6 +225,7 @@ query_uniform_block(
 	if (!(block->name = string_copy(name))) {
 		return 0;
 	}
+	block->hash = string_hash(name);
 
 	// query block index
 	block->index = glGetUniformBlockIndex(shader->prog, name);
@@ -241,6 +318,9 @@ query_uniform_block(
 
 		// retrieve uniform name
 		uniform->name = malloc(uniform_name_lengths[i]);
+		if (!uniform->name) {
+			return 0;
+		}
 		glGetActiveUniformName(
 			shader->prog,
 			uniform_indices[i],
@@ -248,9 +328,14 @@ query_uniform_block(
 			NULL,
 			(GLchar*)uniform->name
 		);
+		uniform->hash = string_hash(uniform->name);
 	}
 
-	return 1;
+	return init_uniform_table(
+		&block->uniform_table,
+		block->uniforms,
+		block->uniform_count
+	);
 }
 
 static int
@@ -286,6 +371,14 @@ init_shader_uniform_blocks(struct Shader *s)
 			return 0;
 		}
 	}
+
+	// build block name lookup table
+	if (!name_table_init(&s->block_table, s->block_count)) {
+		return 0;
+	}
+	for (size_t i = 0; i < s->block_count; i++) {
+		name_table_insert(&s->block_table, s->blocks[i].hash, i);
+	}
 	return 1;
 }
 
@@ -346,6 +439,7 @@ init_shader_uniforms(struct Shader *s)
 		for (size_t i = 0; i < actual_count; i++) {
 			struct ShaderUniform *uniform = &s->uniforms[i];
 			uniform->name = uniform_names[i];
+			uniform->hash = string_hash(uniform->name);
 			uniform->loc = uniform_locations[i];
 			uniform->type = uniform_types[i];
 			uniform->count = uniform_sizes[i];
@@ -356,7 +450,11 @@ init_shader_uniforms(struct Shader *s)
 		}
 	}
 
-	return 1;
+	return init_uniform_table(
+		&s->uniform_table,
+		s->uniforms,
+		s->uniform_count
+	);
 }
 
 struct Shader*
@@ -481,8 +579,11 @@ shader_free(struct Shader *s)
 				free((char*)block->uniforms[j].name);
 			}
 			free(block->uniforms);
+			name_table_free(&block->uniform_table);
 		}
 		free(s->blocks);
+		name_table_free(&s->uniform_table);
+		name_table_free(&s->block_table);
 		free(s);
 	}
 }
@@ -515,14 +616,15 @@ shader_get_uniform(struct Shader *s, const char *name)
 	assert(s != NULL);
 	assert(name != NULL);
 
-	for (GLuint i = 0; i < s->uniform_count; i++) {
-		struct ShaderUniform *uniform = s->uniforms + i;
-		if (strcmp(uniform->name, name) == 0) {
-			return uniform;
-		}
+	const struct ShaderUniform *uniform = find_uniform(
+		&s->uniform_table,
+		s->uniforms,
+		name
+	);
+	if (!uniform) {
+		fprintf(stderr, "no such shader uniform '%s'\n", name);
 	}
-	fprintf(stderr, "no such shader uniform '%s'\n", name);
-	return NULL;
+	return uniform;
 }
 
 int
@@ -550,10 +652,18 @@ shader_get_uniform_block(struct Shader *s, const char *name)
 	assert(s != NULL);
 	assert(name != NULL);
 
-	for (GLuint i = 0; i < s->block_count; i++) {
-		struct ShaderUniformBlock *block = &s->blocks[i];
-		if (strcmp(block->name, name) == 0) {
-			return block;
+	if (s->block_table.size > 0) {
+		unsigned hash = string_hash(name);
+		size_t mask = s->block_table.size - 1;
+		for (size_t slot = hash & mask;
+		     s->block_table.slots[slot];
+		     slot = (slot + 1) & mask) {
+			struct ShaderUniformBlock *block = &s->blocks[
+				s->block_table.slots[slot] - 1
+			];
+			if (block->hash == hash && strcmp(block->name, name) == 0) {
+				return block;
+			}
 		}
 	}
 	fprintf(stderr, "no such shader uniform block '%s'\n", name);
@@ -585,13 +695,15 @@ shader_uniform_block_get_uniform(const struct ShaderUniformBlock *block, const c
 	assert(block != NULL);
 	assert(name != NULL);
 
-	for (size_t i = 0; i < block->uniform_count; i++) {
-		if (strcmp(block->uniforms[i].name, name) == 0) {
-			return &block->uniforms[i];
-		}
+	const struct ShaderUniform *uniform = find_uniform(
+		&block->uniform_table,
+		block->uniforms,
+		name
+	);
+	if (!uniform) {
+		fprintf(stderr, "no such uniform `%s` in uniform block `%s`\n", name, block->name);
 	}
-	fprintf(stderr, "no such uniform `%s` in uniform block `%s`\n", name, block->name);
-	return NULL;
+	return uniform;
 }
 
 int
@@ -608,6 +720,7 @@ shader_uniform_set(const struct ShaderUniform *uniform, size_t count, ...)
 	case GL_BOOL:
 	case GL_SAMPLER_2D:
 	case GL_SAMPLER_2D_RECT:
+	case GL_SAMPLER_2D_ARRAY:
 	case GL_SAMPLER_1D:
 	case GL_INT_SAMPLER_1D:
 	case GL_UNSIGNED_INT_SAMPLER_1D:
@@ -673,3 +786,20 @@ shader_uniform_set(const struct ShaderUniform *uniform, size_t count, ...)
 #endif
 	return 1;
 }
+
+int
+shader_uniform_check_type(const struct ShaderUniform *uniform, GLenum type)
+{
+	assert(uniform != NULL);
+
+	if (uniform->type != type) {
+		fprintf(stderr,
+			"shader uniform '%s' has type %d, expected %d\n",
+			uniform->name,
+			uniform->type,
+			type
+		);
+		return 0;
+	}
+	return 1;
+}
@@ -20,11 +20,23 @@ shader_source_from_file(const char *filename);
 void
 shader_source_free(struct ShaderSource *src);
 
+/**
+ * Name lookup table.
+ *
+ * Open addressing hash table which maps name hashes to 1-based indices into
+ * an array of uniforms or uniform blocks; 0 marks an empty slot.
+ */
+struct ShaderNameTable {
+	GLuint *slots;
+	size_t size;
+};
+
 /**
  * Shader uniform.
  */
 struct ShaderUniform {
 	const char *name;
+	unsigned hash;
 	GLenum type;
 	GLint loc;
 	GLuint count;
@@ -37,10 +49,12 @@ struct ShaderUniform {
  */
 struct ShaderUniformBlock {
 	const char *name;
+	unsigned hash;
 	GLuint index;
 	size_t size;
 	size_t uniform_count;
 	struct ShaderUniform *uniforms;
+	struct ShaderNameTable uniform_table;
 };
 
 /**
@@ -50,8 +64,10 @@ struct Shader {
 	GLuint prog;
 	GLuint uniform_count;
 	struct ShaderUniform *uniforms;
+	struct ShaderNameTable uniform_table;
 	GLuint block_count;
 	struct ShaderUniformBlock *blocks;
+	struct ShaderNameTable block_table;
 };
 
 struct Shader*
@@ -101,3 +117,62 @@ shader_uniform_block_get_uniform(
 
 int
 shader_uniform_set(const struct ShaderUniform *uniform, size_t count, ...);
+
+/**
+ * Check whether the uniform has given GL type.
+ *
+ * Typed setters below do no type dispatching nor validation, thus, uniforms
+ * are meant to be checked once, when the pipeline is initialized.
+ */
+int
+shader_uniform_check_type(const struct ShaderUniform *uniform, GLenum type);
+
+static inline void
+shader_uniform_set_int(const struct ShaderUniform *uniform, GLint value)
+{
+	glUniform1i(uniform->loc, value);
+}
+
+static inline void
+shader_uniform_set_uint(const struct ShaderUniform *uniform, GLuint value)
+{
+	glUniform1ui(uniform->loc, value);
+}
+
+static inline void
+shader_uniform_set_float(const struct ShaderUniform *uniform, GLfloat value)
+{
+	glUniform1f(uniform->loc, value);
+}
+
+static inline void
+shader_uniform_set_vec2(
+	const struct ShaderUniform *uniform,
+	GLfloat x,
+	GLfloat y
+) {
+	glUniform2f(uniform->loc, x, y);
+}
+
+static inline void
+shader_uniform_set_vec4(const struct ShaderUniform *uniform, const Vec *v)
+{
+	glUniform4fv(uniform->loc, 1, v->data);
+}
+
+static inline void
+shader_uniform_set_uvec4(
+	const struct ShaderUniform *uniform,
+	GLuint x,
+	GLuint y,
+	GLuint z,
+	GLuint w
+) {
+	glUniform4ui(uniform->loc, x, y, z, w);
+}
+
+static inline void
+shader_uniform_set_mat4(const struct ShaderUniform *uniform, const Mat *m)
+{
+	glUniformMatrix4fv(uniform->loc, 1, GL_TRUE, m->data);
+}
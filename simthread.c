@@ -0,0 +1,153 @@
+#include "error.h"
+#include "memory.h"
+#include "simthread.h"
+#include <SDL.h>
+#include <assert.h>
+
+struct SimThread {
+	struct World *world;
+	struct ScriptEnv *env;
+	SDL_Thread *thread;
+	SDL_sem *start;
+	SDL_sem *done;
+	int busy;
+	int quit;
+
+	// update job parameters and results
+	float dt;
+	float tick;
+	int ok;
+	int running;
+
+	// double buffered extracted frames; the worker writes into the back
+	// one while the front one is being rendered
+	struct WorldFrame frames[2];
+	int front;
+};
+
+static int
+update(struct SimThread *st)
+{
+	// update the world
+	st->running = world_update(st->world, st->dt);
+
+	// notify script environment
+	int ok = 1;
+	st->tick += st->dt;
+	while (st->tick >= TICK) {
+		st->tick -= TICK;
+		ok &= script_env_tick(st->env);
+	}
+
+	// extract the frame for rendering
+	ok &= world_extract(st->world, &st->frames[!st->front]);
+
+	return ok;
+}
+
+static int
+run(void *st_ptr)
+{
+	struct SimThread *st = st_ptr;
+	for (;;) {
+		SDL_SemWait(st->start);
+		if (st->quit) {
+			break;
+		}
+		st->ok = update(st);
+		SDL_SemPost(st->done);
+	}
+	return 0;
+}
+
+struct SimThread*
+sim_thread_new(struct World *world, struct ScriptEnv *env)
+{
+	assert(world != NULL);
+	assert(env != NULL);
+
+	struct SimThread *st = make(struct SimThread);
+	if (!st) {
+		return NULL;
+	}
+	st->world = world;
+	st->env = env;
+
+	st->start = SDL_CreateSemaphore(0);
+	st->done = SDL_CreateSemaphore(0);
+	if (!st->start || !st->done) {
+		fprintf(stderr, "failed to create semaphores: %s\n", SDL_GetError());
+		error(ERR_SDL);
+		goto error;
+	}
+
+	st->thread = SDL_CreateThread(run, "simulation", st);
+	if (!st->thread) {
+		fprintf(stderr, "failed to create thread: %s\n", SDL_GetError());
+		error(ERR_SDL);
+		goto error;
+	}
+
+	return st;
+
+error:
+	sim_thread_destroy(st);
+	return NULL;
+}
+
+void
+sim_thread_destroy(struct SimThread *st)
+{
+	if (st) {
+		if (st->thread) {
+			if (st->busy) {
+				SDL_SemWait(st->done);
+			}
+			st->quit = 1;
+			SDL_SemPost(st->start);
+			SDL_WaitThread(st->thread, NULL);
+		}
+		if (st->start) {
+			SDL_DestroySemaphore(st->start);
+		}
+		if (st->done) {
+			SDL_DestroySemaphore(st->done);
+		}
+		world_frame_release(&st->frames[0]);
+		world_frame_release(&st->frames[1]);
+		destroy(st);
+	}
+}
+
+void
+sim_thread_kick(struct SimThread *st, float dt)
+{
+	assert(st != NULL);
+	assert(!st->busy);
+
+	st->dt = dt;
+	st->busy = 1;
+	SDL_SemPost(st->start);
+}
+
+int
+sim_thread_wait(
+	struct SimThread *st,
+	int *r_running,
+	const struct WorldFrame **r_frame
+) {
+	assert(st != NULL);
+	assert(st->busy);
+
+	SDL_SemWait(st->done);
+	st->busy = 0;
+	st->front = !st->front;
+
+	if (r_running) {
+		*r_running = st->running;
+	}
+	if (r_frame) {
+		*r_frame = &st->frames[st->front];
+	}
+	return st->ok;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "game.h"
+#include "script.h"
+
+/**
+ * Simulation thread.
+ *
+ * Runs world updates and script ticks on a worker thread, so that the next
+ * frame is simulated while the current one is rendered. Each update ends with
+ * extracting the world into a frame, which stays valid until the next
+ * `sim_thread_wait()` call. The world and the script environment must not be
+ * accessed by other threads between `sim_thread_kick()` and
+ * `sim_thread_wait()` calls.
+ */
+struct SimThread;
+
+struct SimThread*
+sim_thread_new(struct World *world, struct ScriptEnv *env);
+
+/**
+ * Destroy simulation thread, waiting for the update in progress, if any.
+ */
+void
+sim_thread_destroy(struct SimThread *st);
+
+/**
+ * Start updating the world by given delta time.
+ */
+void
+sim_thread_kick(struct SimThread *st, float dt);
+
+/**
+ * Wait for the update to complete.
+ *
+ * Sets `r_running` to 0 if the game is over and `r_frame` to the extracted
+ * frame. Returns 0 if the update failed.
+ */
+int
+sim_thread_wait(
+	struct SimThread *st,
+	int *r_running,
+	const struct WorldFrame **r_frame
+);
@@ -0,0 +1,425 @@
+#include "error.h"
+#include "matlib.h"
+#include "snapshot.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPRITE_REMOVED 0xff
+
+// worst case size of an encoded entity and of a removal, in bits
+#define ENTITY_MAX_BITS (1 + 1 + 32 + 1 + 16 + 16 + 8 + SNAPSHOT_SPRITE_BITS)
+#define REMOVAL_BITS (1 + 32)
+
+static int
+reserve(struct Snapshot *snap, size_t count)
+{
+	if (count > snap->capacity) {
+		size_t capacity = count + ECS_CHUNK_SIZE;
+		void *entities = realloc(
+			snap->entities,
+			sizeof(struct SnapshotEntity) * capacity
+		);
+		if (!entities) {
+			error(ERR_NO_MEM);
+			return 0;
+		}
+		snap->entities = entities;
+		snap->capacity = capacity;
+	}
+	return 1;
+}
+
+static int
+entity_cmp(const void *a_ptr, const void *b_ptr)
+{
+	const struct SnapshotEntity *a = a_ptr, *b = b_ptr;
+	return (a->id > b->id) - (a->id < b->id);
+}
+
+static struct SnapshotEntity*
+find_entity(const struct Snapshot *snap, size_t count, Entity id)
+{
+	if (!count) {
+		return NULL;
+	}
+	struct SnapshotEntity key = { id };
+	return bsearch(
+		&key,
+		snap->entities,
+		count,
+		sizeof(struct SnapshotEntity),
+		entity_cmp
+	);
+}
+
+static int16_t
+quantize_pos(float v)
+{
+	float q = v * SNAPSHOT_POS_SCALE;
+	if (q < INT16_MIN) {
+		return INT16_MIN;
+	} else if (q > INT16_MAX) {
+		return INT16_MAX;
+	}
+	return (int16_t)(q < 0 ? q - 0.5f : q + 0.5f);
+}
+
+int
+snapshot_capture(struct Snapshot *snap, const struct WorldFrame *frame, uint32_t tick)
+{
+	if (!reserve(snap, frame->renderable_count)) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < frame->renderable_count; i++) {
+		const struct Renderable *r = &frame->renderables[i];
+		struct SnapshotEntity *e = &snap->entities[i];
+		assert(r->sprite < (1 << SNAPSHOT_SPRITE_BITS));
+		e->id = r->entity;
+		e->x = quantize_pos(r->x);
+		e->y = quantize_pos(r->y);
+		e->rot = (uint8_t)(long)(r->rot / (M_PI * 2) * 256);
+		e->sprite = r->sprite;
+	}
+	snap->count = frame->renderable_count;
+	qsort(snap->entities, snap->count, sizeof(struct SnapshotEntity), entity_cmp);
+
+	float hp = frame->hitpoints * SNAPSHOT_HP_SCALE;
+	snap->hitpoints = hp <= 0 ? 0 : (hp >= UINT16_MAX ? UINT16_MAX : hp);
+	snap->credits = frame->credits;
+	snap->tick = tick;
+	return 1;
+}
+
+int
+snapshot_copy(struct Snapshot *dst, const struct Snapshot *src)
+{
+	if (!reserve(dst, src->count)) {
+		return 0;
+	}
+	if (src->count) {
+		memcpy(
+			dst->entities,
+			src->entities,
+			sizeof(struct SnapshotEntity) * src->count
+		);
+	}
+	dst->count = src->count;
+	dst->tick = src->tick;
+	dst->hitpoints = src->hitpoints;
+	dst->credits = src->credits;
+	return 1;
+}
+
+void
+snapshot_release(struct Snapshot *snap)
+{
+	if (snap) {
+		free(snap->entities);
+		memset(snap, 0, sizeof(struct Snapshot));
+	}
+}
+
+static int
+has_room(const struct BitWriter *w, size_t bits)
+{
+	return w->bit + bits <= w->size * 8;
+}
+
+static void
+write_id(struct BitWriter *w, Entity id, Entity prev)
+{
+	// ids come mostly in ascending order, with small gaps
+	if (id > prev && id - prev <= 256) {
+		bit_write(w, 1, 1);
+		bit_write(w, id - prev - 1, 8);
+	} else {
+		bit_write(w, 0, 1);
+		bit_write(w, id, 32);
+	}
+}
+
+static Entity
+read_id(struct BitReader *r, Entity prev)
+{
+	if (bit_read(r, 1)) {
+		return prev + bit_read(r, 8) + 1;
+	}
+	return bit_read(r, 32);
+}
+
+static void
+write_pos(struct BitWriter *w, int16_t value, int16_t base)
+{
+	int delta = value - base;
+	if (delta == 0) {
+		bit_write(w, 0, 1);
+	} else if (delta >= -128 && delta < 128) {
+		bit_write(w, 1, 1);
+		bit_write(w, 1, 1);
+		bit_write(w, (uint32_t)delta, 8);
+	} else {
+		bit_write(w, 1, 1);
+		bit_write(w, 0, 1);
+		bit_write(w, (uint16_t)value, 16);
+	}
+}
+
+static int16_t
+read_pos(struct BitReader *r, int16_t base)
+{
+	if (!bit_read(r, 1)) {
+		return base;
+	} else if (bit_read(r, 1)) {
+		return base + bit_read_signed(r, 8);
+	}
+	return (int16_t)bit_read_signed(r, 16);
+}
+
+static void
+write_entity(
+	struct BitWriter *w,
+	const struct SnapshotEntity *e,
+	const struct SnapshotEntity *base
+) {
+	if (!base) {
+		bit_write(w, 1, 1);
+		bit_write(w, (uint16_t)e->x, 16);
+		bit_write(w, (uint16_t)e->y, 16);
+		bit_write(w, e->rot, 8);
+		bit_write(w, e->sprite, SNAPSHOT_SPRITE_BITS);
+		return;
+	}
+
+	bit_write(w, 0, 1);
+	write_pos(w, e->x, base->x);
+	write_pos(w, e->y, base->y);
+	bit_write(w, e->rot != base->rot, 1);
+	if (e->rot != base->rot) {
+		bit_write(w, e->rot, 8);
+	}
+	bit_write(w, e->sprite != base->sprite, 1);
+	if (e->sprite != base->sprite) {
+		bit_write(w, e->sprite, SNAPSHOT_SPRITE_BITS);
+	}
+}
+
+static int
+entity_equal(const struct SnapshotEntity *a, const struct SnapshotEntity *b)
+{
+	return (
+		a->x == b->x &&
+		a->y == b->y &&
+		a->rot == b->rot &&
+		a->sprite == b->sprite
+	);
+}
+
+int
+snapshot_encode(
+	const struct Snapshot *base,
+	const struct Snapshot *snap,
+	size_t *cursor,
+	struct BitWriter *w,
+	struct Snapshot *r_sent
+) {
+	size_t start = w->bit;
+
+	// header and HUD values
+	bit_write(w, snap->tick, 32);
+	int hud_changed = (
+		snap->hitpoints != base->hitpoints ||
+		snap->credits != base->credits
+	);
+	bit_write(w, hud_changed, 1);
+	if (hud_changed) {
+		bit_write(w, snap->hitpoints, 16);
+		bit_write(w, (uint32_t)snap->credits, 32);
+	}
+
+	// removals of baseline entities missing in the snapshot; both lists
+	// are sorted, thus, a merge finds them all in one pass, while leaving
+	// room for both list terminators
+	for (size_t bi = 0, si = 0; bi < base->count; bi++) {
+		Entity id = base->entities[bi].id;
+		while (si < snap->count && snap->entities[si].id < id) {
+			si++;
+		}
+		if (si < snap->count && snap->entities[si].id == id) {
+			continue;
+		}
+		if (!has_room(w, REMOVAL_BITS + 2)) {
+			break;
+		}
+		bit_write(w, 1, 1);
+		bit_write(w, id, 32);
+	}
+	bit_write(w, 0, 1);
+
+	// new and changed entities, round robin from where the last encoding
+	// ran out of room
+	size_t count = snap->count;
+	size_t first = count ? *cursor % count : 0;
+	Entity prev = 0;
+	for (size_t n = 0; n < count; n++) {
+		size_t i = (first + n) % count;
+		const struct SnapshotEntity *e = &snap->entities[i];
+		const struct SnapshotEntity *b = find_entity(base, base->count, e->id);
+		if (b && entity_equal(e, b)) {
+			continue;
+		}
+		if (!has_room(w, ENTITY_MAX_BITS + 1)) {
+			*cursor = i;
+			break;
+		}
+		bit_write(w, 1, 1);
+		write_id(w, e->id, prev);
+		write_entity(w, e, b);
+		prev = e->id;
+	}
+	bit_write(w, 0, 1);
+	assert(!w->overflow);
+
+	// the receiver's state is whatever it decodes
+	struct BitReader r;
+	bit_reader_init(&r, w->data, bit_writer_bytes(w));
+	r.bit = start;
+	return snapshot_decode(base, &r, r_sent);
+}
+
+int
+snapshot_decode(
+	const struct Snapshot *base,
+	struct BitReader *r,
+	struct Snapshot *r_snap
+) {
+	if (!snapshot_copy(r_snap, base)) {
+		return 0;
+	}
+	size_t base_count = base->count;
+
+	// header and HUD values
+	r_snap->tick = bit_read(r, 32);
+	if (bit_read(r, 1)) {
+		r_snap->hitpoints = bit_read(r, 16);
+		r_snap->credits = bit_read_signed(r, 32);
+	}
+
+	// mark removed entities
+	int removed = 0;
+	while (bit_read(r, 1) && !r->overflow) {
+		struct SnapshotEntity *e = find_entity(
+			r_snap,
+			base_count,
+			bit_read(r, 32)
+		);
+		if (!e || e->sprite == SPRITE_REMOVED) {
+			return 0;
+		}
+		e->sprite = SPRITE_REMOVED;
+		removed = 1;
+	}
+
+	// apply new and changed entities; new ones are appended and the
+	// baseline part of the array stays sorted for lookups
+	int added = 0;
+	Entity prev = 0;
+	while (bit_read(r, 1) && !r->overflow) {
+		Entity id = read_id(r, prev);
+		prev = id;
+		struct SnapshotEntity *e = find_entity(r_snap, base_count, id);
+		if (bit_read(r, 1)) {
+			if (e || !reserve(r_snap, r_snap->count + 1)) {
+				return 0;
+			}
+			e = &r_snap->entities[r_snap->count++];
+			e->id = id;
+			e->x = bit_read_signed(r, 16);
+			e->y = bit_read_signed(r, 16);
+			e->rot = bit_read(r, 8);
+			e->sprite = bit_read(r, SNAPSHOT_SPRITE_BITS);
+			added = 1;
+		} else {
+			if (!e || e->sprite == SPRITE_REMOVED) {
+				return 0;
+			}
+			e->x = read_pos(r, e->x);
+			e->y = read_pos(r, e->y);
+			if (bit_read(r, 1)) {
+				e->rot = bit_read(r, 8);
+			}
+			if (bit_read(r, 1)) {
+				e->sprite = bit_read(r, SNAPSHOT_SPRITE_BITS);
+			}
+		}
+	}
+	if (r->overflow) {
+		return 0;
+	}
+
+	// drop removed entities and restore the order
+	if (removed) {
+		size_t count = 0;
+		for (size_t i = 0; i < r_snap->count; i++) {
+			if (r_snap->entities[i].sprite != SPRITE_REMOVED) {
+				r_snap->entities[count++] = r_snap->entities[i];
+			}
+		}
+		r_snap->count = count;
+	}
+	if (added) {
+		qsort(
+			r_snap->entities,
+			r_snap->count,
+			sizeof(struct SnapshotEntity),
+			entity_cmp
+		);
+	}
+	return 1;
+}
+
+static void
+dequantize(
+	const struct SnapshotEntity *a,
+	const struct SnapshotEntity *b,
+	float t,
+	struct Renderable *r
+) {
+	// rotation takes the shorter way around
+	int rot_delta = (int8_t)(uint8_t)(b->rot - a->rot);
+	r->entity = a->id;
+	r->x = (a->x + (b->x - a->x) * t) / SNAPSHOT_POS_SCALE;
+	r->y = (a->y + (b->y - a->y) * t) / SNAPSHOT_POS_SCALE;
+	r->rot = (a->rot + rot_delta * t) / 256.0f * M_PI * 2;
+	r->sprite = a->sprite;
+}
+
+int
+snapshot_interpolate(
+	const struct Snapshot *a,
+	const struct Snapshot *b,
+	float t,
+	struct WorldFrame *frame
+) {
+	if (!world_frame_reserve(frame, a->count)) {
+		return 0;
+	}
+
+	size_t bi = 0;
+	for (size_t ai = 0; ai < a->count; ai++) {
+		const struct SnapshotEntity *e = &a->entities[ai];
+		while (bi < b->count && b->entities[bi].id < e->id) {
+			bi++;
+		}
+		const struct SnapshotEntity *next = e;
+		if (bi < b->count && b->entities[bi].id == e->id) {
+			next = &b->entities[bi];
+		}
+		dequantize(e, next, t, &frame->renderables[ai]);
+	}
+	frame->renderable_count = a->count;
+	frame->hitpoints = a->hitpoints / (float)SNAPSHOT_HP_SCALE;
+	frame->credits = a->credits;
+	return 1;
+}
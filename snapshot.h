@@ -0,0 +1,93 @@
+#pragma once
+
+#include "bitstream.h"
+#include "game.h"
+
+#define SNAPSHOT_POS_SCALE 4      // position units per world unit
+#define SNAPSHOT_HP_SCALE 64      // hitpoint units per hitpoint
+#define SNAPSHOT_SPRITE_BITS 4
+#define SNAPSHOT_HISTORY 32       // snapshots kept for delta compression
+
+/**
+ * Quantized entity state.
+ */
+struct SnapshotEntity {
+	Entity id;        // 0 for the player
+	int16_t x, y;     // in 1/SNAPSHOT_POS_SCALE world units
+	uint8_t rot;      // in 1/256 turns
+	uint8_t sprite;
+};
+
+/**
+ * World snapshot.
+ *
+ * Quantized copy of the world state visible to clients, entities are sorted
+ * by their id. Must be zero-initialized before first use.
+ */
+struct Snapshot {
+	uint32_t tick;
+	struct SnapshotEntity *entities;
+	size_t count;
+	size_t capacity;
+	uint16_t hitpoints;   // in 1/SNAPSHOT_HP_SCALE hitpoints
+	int32_t credits;
+};
+
+/**
+ * Capture an extracted frame into a snapshot.
+ */
+int
+snapshot_capture(struct Snapshot *snap, const struct WorldFrame *frame, uint32_t tick);
+
+int
+snapshot_copy(struct Snapshot *dst, const struct Snapshot *src);
+
+void
+snapshot_release(struct Snapshot *snap);
+
+/**
+ * Encode a snapshot as a delta against a baseline.
+ *
+ * Only the HUD values and entities which differ from the baseline are
+ * written, as small position deltas where possible. Entity updates which
+ * don't fit the writer's buffer are deferred: the next encoding starts from
+ * `cursor`, so that all entities get their turn as their number grows beyond
+ * what fits. An empty baseline encodes the full snapshot.
+ *
+ * On success `r_sent` is set to the state the receiver reconstructs from the
+ * encoded data, which is what later deltas must be based upon.
+ */
+int
+snapshot_encode(
+	const struct Snapshot *base,
+	const struct Snapshot *snap,
+	size_t *cursor,
+	struct BitWriter *w,
+	struct Snapshot *r_sent
+);
+
+/**
+ * Decode a snapshot encoded against given baseline.
+ *
+ * Returns 0 if the data is malformed.
+ */
+int
+snapshot_decode(
+	const struct Snapshot *base,
+	struct BitReader *r,
+	struct Snapshot *r_snap
+);
+
+/**
+ * Interpolate between two snapshots into a frame.
+ *
+ * Entities missing in `b` are left at their position in `a`, entities
+ * missing in `a` are not shown yet.
+ */
+int
+snapshot_interpolate(
+	const struct Snapshot *a,
+	const struct Snapshot *b,
+	float t,
+	struct WorldFrame *frame
+);
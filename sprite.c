@@ -1,46 +1,107 @@
-#include "error.h"
+#include "image.h"
 #include "memory.h"
 #include "sprite.h"
 #include "texture.h"
 #include <assert.h>
 
-struct Sprite*
-sprite_from_file(const char *filename)
+struct SpriteSet {
+	struct Sprite *sprites;
+	size_t count;
+	struct TextureArray **arrays;
+	size_t array_count;
+};
+
+struct SpriteSet*
+sprite_set_from_files(const char **filenames, size_t count)
 {
-	assert(filename != NULL);
+	assert(filenames != NULL);
 
-	// create an empty sprite struct
-	struct Sprite *spr = make(struct Sprite);
-	if (!spr) {
+	struct SpriteSet *set = make(struct SpriteSet);
+	if (!set) {
 		return NULL;
 	}
+	set->count = count;
 
-	// load the texture from image file
-	spr->texture = texture_from_file(filename);
-	if (!spr->texture) {
-		sprite_destroy(spr);
-		return NULL;
+	struct Image **images = NULL;
+	struct Image **family = NULL;
+	size_t *family_idx = NULL;
+	if (!(set->sprites = alloc0(sizeof(struct Sprite) * count)) ||
+	    !(set->arrays = alloc0(sizeof(struct TextureArray*) * count)) ||
+	    !(images = alloc0(sizeof(struct Image*) * count)) ||
+	    !(family = alloc0(sizeof(struct Image*) * count)) ||
+	    !(family_idx = alloc0(sizeof(size_t) * count))) {
+		goto error;
 	}
-	spr->width = spr->texture->width;
-	spr->height = spr->texture->height;
-
-	// generate a VAO for the sprite
-	glGenVertexArrays(1, &spr->vao);
-	if (glGetError() != GL_NO_ERROR || !spr->vao) {
-		error(ERR_OPENGL);
-		sprite_destroy(spr);
-		return NULL;
+
+	// read all the images
+	for (size_t i = 0; i < count; i++) {
+		if (!(images[i] = image_load(filenames[i]))) {
+			goto error;
+		}
+		set->sprites[i].width = images[i]->width;
+		set->sprites[i].height = images[i]->height;
+	}
+
+	// group images of the same size into families, each becoming a texture
+	// array with a layer per image
+	for (size_t i = 0; i < count; i++) {
+		if (set->sprites[i].texture) {
+			continue;
+		}
+		size_t family_len = 0;
+		for (size_t j = i; j < count; j++) {
+			if (images[j]->width == images[i]->width &&
+			    images[j]->height == images[i]->height) {
+				family[family_len] = images[j];
+				family_idx[family_len] = j;
+				family_len++;
+			}
+		}
+
+		struct TextureArray *array = texture_array_new(family, family_len);
+		if (!array) {
+			goto error;
+		}
+		set->arrays[set->array_count++] = array;
+		for (size_t f = 0; f < family_len; f++) {
+			set->sprites[family_idx[f]].texture = array;
+			set->sprites[family_idx[f]].layer = f;
+		}
 	}
 
-	return spr;
+cleanup:
+	if (images) {
+		for (size_t i = 0; i < count; i++) {
+			image_destroy(images[i]);
+		}
+	}
+	destroy(images);
+	destroy(family);
+	destroy(family_idx);
+	return set;
+
+error:
+	sprite_set_destroy(set);
+	set = NULL;
+	goto cleanup;
 }
 
 void
-sprite_destroy(struct Sprite *spr)
+sprite_set_destroy(struct SpriteSet *set)
 {
-	if (spr) {
-		glDeleteVertexArrays(1, &spr->vao);
-		texture_destroy(spr->texture);
-		destroy(spr);
+	if (set) {
+		for (size_t i = 0; i < set->array_count; i++) {
+			texture_array_destroy(set->arrays[i]);
+		}
+		destroy(set->arrays);
+		destroy(set->sprites);
+		destroy(set);
 	}
-}
\ No newline at end of file
+}
+
+struct Sprite*
+sprite_set_get(struct SpriteSet *set, size_t index)
+{
+	assert(index < set->count);
+	return &set->sprites[index];
+}
@@ -1,15 +1,35 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <stddef.h>
 
 struct Sprite {
-	GLuint vao;
-	struct Texture *texture;
+	struct TextureArray *texture;   // shared by sprites of the same size
+	unsigned layer;
 	int width, height;
 };
 
-struct Sprite*
-sprite_from_file(const char *filename);
+/**
+ * Set of sprites.
+ *
+ * Images of the same size, such as the color variants of a ship, are loaded
+ * as layers of a single texture array, thus, sprites of such families can be
+ * drawn together.
+ */
+struct SpriteSet;
+
+/**
+ * Load a sprite for each given image file.
+ */
+struct SpriteSet*
+sprite_set_from_files(const char **filenames, size_t count);
 
 void
-sprite_destroy(struct Sprite *spr);
\ No newline at end of file
+sprite_set_destroy(struct SpriteSet *set);
+
+/**
+ * Get the sprite of the image at given index of the files passed to
+ * `sprite_set_from_files()`.
+ */
+struct Sprite*
+sprite_set_get(struct SpriteSet *set, size_t index);
@@ -1,30 +1,69 @@
 #include "strutils.h"
 #include <assert.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define STRING_FMT_STACK_SIZE 256
+
 char*
 string_fmt(const char *fmt, ...)
 {
-	va_list ap, ap_copy;
+	va_list ap;
 	va_start(ap, fmt);
+	char *msg = string_vfmt(fmt, ap);
+	va_end(ap);
+	return msg;
+}
 
+char*
+string_vfmt(const char *fmt, va_list ap)
+{
+	// attempt to format into a stack buffer first, so that in the common
+	// case of short strings the format is processed only once
+	char stack_buf[STRING_FMT_STACK_SIZE];
+	va_list ap_copy;
 	va_copy(ap_copy, ap);
-	size_t msg_len = vsnprintf(NULL, 0, fmt, ap_copy) + 1;
+	int len = vsnprintf(stack_buf, sizeof(stack_buf), fmt, ap_copy);
 	va_end(ap_copy);
+	if (len < 0) {
+		return NULL;
+	}
 
-	char *msg = malloc(msg_len);
-	if (msg) {
+	char *msg = malloc(len + 1);
+	if (!msg) {
+		return NULL;
+	}
+	if ((size_t)len < sizeof(stack_buf)) {
+		memcpy(msg, stack_buf, len + 1);
+	} else {
 		va_copy(ap_copy, ap);
-		vsnprintf(msg, msg_len, fmt, ap_copy);
+		vsnprintf(msg, len + 1, fmt, ap_copy);
 		va_end(ap_copy);
 	}
-	va_end(ap);
 	return msg;
 }
 
+size_t
+string_vfmt_buf(char *buf, size_t size, const char *fmt, va_list ap)
+{
+	assert(buf != NULL || size == 0);
+
+	va_list ap_copy;
+	va_copy(ap_copy, ap);
+	int len = vsnprintf(buf, size, fmt, ap_copy);
+	va_end(ap_copy);
+	if (len < 0) {
+		if (size > 0) {
+			buf[0] = 0;
+		}
+		return 0;
+	}
+	return len;
+}
+
 char*
 string_join(const char **strings, const char *sep)
 {
@@ -195,5 +234,25 @@ out_of_mem:
 char*
 string_copy(const char *str)
 {
-	return string_fmt("%s", str);
+	assert(str != NULL);
+
+	size_t size = strlen(str) + 1;
+	char *copy = malloc(size);
+	if (copy) {
+		memcpy(copy, str, size);
+	}
+	return copy;
+}
+
+unsigned
+string_hash(const char *str)
+{
+	assert(str != NULL);
+
+	uint32_t hash = 2166136261u;
+	for (const unsigned char *c = (const unsigned char*)str; *c; c++) {
+		hash ^= *c;
+		hash *= 16777619u;
+	}
+	return hash;
 }
@@ -1,10 +1,24 @@
 #pragma once
 
+#include <stdarg.h>
 #include <stddef.h>
 
 char*
 string_fmt(const char *fmt, ...);
 
+char*
+string_vfmt(const char *fmt, va_list ap);
+
+/**
+ * Format a string into caller-provided buffer.
+ *
+ * The result is always NUL-terminated and truncated if it does not fit. The
+ * return value is the length of the full formatted string, thus, truncation
+ * happened if it's greater or equal to `size`.
+ */
+size_t
+string_vfmt_buf(char *buf, size_t size, const char *fmt, va_list ap);
+
 char*
 string_copy(const char *str);
 
@@ -19,3 +33,9 @@ string_split(const char *s, char ch, size_t *r_count);
 
 void
 string_freev(char **strv, size_t count);
+
+/**
+ * Compute 32bit FNV-1a hash of given string.
+ */
+unsigned
+string_hash(const char *str);
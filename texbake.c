@@ -0,0 +1,69 @@
+#include "error.h"
+#include "image.h"
+#include "strutils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Offline texture baker.
+ *
+ * Converts PNG images to raw containers read by `texture_from_file()`, with
+ * colors premultiplied by alpha and optionally compressed copies of pixels.
+ */
+
+static int
+bake(const char *filename, int compress)
+{
+	const char *ext = strrchr(filename, '.');
+	if (!ext || strcmp(ext, ".png") != 0) {
+		fprintf(stderr, "`%s` is not a PNG file\n", filename);
+		return 0;
+	}
+
+	char *out = string_fmt(
+		"%.*s" IMAGE_FILE_EXT,
+		(int)(ext - filename),
+		filename
+	);
+	struct Image *image = NULL;
+	int ok = (
+		out &&
+		(image = image_from_png(filename)) &&
+		(!compress || image_compress_bc3(image)) &&
+		image_write(image, out)
+	);
+	if (ok) {
+		printf("%s -> %s\n", filename, out);
+	} else {
+		fprintf(stderr, "failed to bake `%s`\n", filename);
+	}
+	image_destroy(image);
+	free(out);
+	return ok;
+}
+
+int
+main(int argc, char *argv[])
+{
+	int compress = 0;
+	int i = 1;
+	if (i < argc && strcmp(argv[i], "-c") == 0) {
+		compress = 1;
+		i++;
+	}
+	if (i == argc) {
+		fprintf(stderr, "usage: %s [-c] FILE.png...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int ok = 1;
+	for (; i < argc; i++) {
+		ok &= bake(argv[i], compress);
+	}
+	if (!ok) {
+		error_dump(stderr);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
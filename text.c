@@ -1,12 +1,14 @@
 #include "font.h"
+#include "strutils.h"
 #include "text.h"
-#include <GL/glew.h>
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define TEXT_FMT_BUF_SIZE 128
+
 struct Text*
 text_new(struct Font *font)
 {
@@ -18,41 +20,11 @@ text_new(struct Font *font)
 	}
 	text->font = font;
 	text->len = 0;
+	text->size = 0;
+	text->chars = NULL;
+	text->coords = NULL;
 	text->width = 0;
 	text->height = 0;
-	text->vao = text->coords = text->chars = 0;
-
-	// generate vertex array
-	glGenVertexArrays(1, &text->vao);
-	glBindVertexArray(text->vao);
-
-	// generate vertex buffers
-	// NOTE: buffers are initialized when `text_set_string()` is called
-	glGenBuffers(1, &text->coords);
-	glGenBuffers(1, &text->chars);
-
-	// setup coords attribute array
-	glBindBuffer(GL_ARRAY_BUFFER, text->coords);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)0);
-	glVertexAttribDivisor(0, 1);
-
-	// setup character indices attribute array
-	// NOTE: each index is one byte long (the character itself), thus,
-	// anything except ASCII is not supported
-	glBindBuffer(GL_ARRAY_BUFFER, text->chars);
-	glEnableVertexAttribArray(1);
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, 0, (GLvoid*)0);
-	glVertexAttribDivisor(1, 1);
-
-	if (!text->vao || !text->chars || !text->coords ||
-	    glGetError() != GL_NO_ERROR) {
-		text_destroy(text);
-		text = NULL;
-	}
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
 
 	return text;
 }
@@ -63,16 +35,29 @@ text_set_string(struct Text *text, const char *str)
 	assert(text != NULL);
 	assert(str != NULL);
 
-	text->len = strlen(str);
+	// grow the arrays if the string doesn't fit
+	size_t len = strlen(str);
+	if (len > text->size) {
+		char *chars = realloc(text->chars, len);
+		if (!chars) {
+			return 0;
+		}
+		text->chars = chars;
+		float (*coords)[2] = realloc(text->coords, sizeof(float) * len * 2);
+		if (!coords) {
+			return 0;
+		}
+		text->coords = coords;
+		text->size = len;
+	}
+	text->len = len;
 
-	// setup the buffer of character indices, which in turn are character
-	// themselves
+	// keep the characters, which are indices of glyphs in the font atlas
 	// NOTE: this doesn't support anything except ASCII
-	glBindBuffer(GL_ARRAY_BUFFER, text->chars);
-	glBufferData(GL_ARRAY_BUFFER, text->len, str, GL_STATIC_DRAW);
+	memcpy(text->chars, str, len);
 
 	// compute character coords relative to the baseline
-	GLfloat coords[text->len][2];
+	float (*coords)[2] = text->coords;
 	text->width = text->height = 0;
 	for (size_t c = 0; c < text->len; c++) {
 		const struct Character *ch = font_get_char(
@@ -97,39 +82,30 @@ text_set_string(struct Text *text, const char *str)
 		coords[c][1] -= offset;
 	}
 
-	// update the character coordinates buffer
-	glBindBuffer(GL_ARRAY_BUFFER, text->coords);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		sizeof(float) * text->len * 2,
-		coords,
-		GL_STATIC_DRAW
-	);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	return glGetError() == GL_NO_ERROR;
+	return 1;
 }
 
 int
 text_set_fmt(struct Text *text, const char *fmt, ...)
 {
-	va_list ap, ap_copy;
+	// format into a stack buffer and fall back to heap for long strings
+	char buf[TEXT_FMT_BUF_SIZE];
+	va_list ap;
 	va_start(ap, fmt);
-
-	va_copy(ap_copy, ap);
-	size_t len = vsnprintf(NULL, 0, fmt, ap_copy) + 1;
-	va_end(ap_copy);
-	char str[len + 1];
-	str[len] = 0;
-
-	int ok = 1;
-	va_copy(ap_copy, ap);
-	if (vsnprintf(str, len, fmt, ap)) {
-		ok = text_set_string(text, str);
+	size_t len = string_vfmt_buf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	if (len < sizeof(buf)) {
+		return text_set_string(text, buf);
 	}
-	va_end(ap_copy);
 
+	va_start(ap, fmt);
+	char *str = string_vfmt(fmt, ap);
 	va_end(ap);
+	if (!str) {
+		return 0;
+	}
+	int ok = text_set_string(text, str);
+	free(str);
 	return ok;
 }
 
@@ -137,9 +113,8 @@ void
 text_destroy(struct Text *text)
 {
 	if (text) {
-		glDeleteBuffers(1, &text->chars);
-		glDeleteBuffers(1, &text->coords);
-		glDeleteVertexArrays(1, &text->vao);
+		free(text->chars);
+		free(text->coords);
 		free(text);
 	}
 }
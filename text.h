@@ -3,9 +3,9 @@
 struct Text {
 	struct Font *font;
 	size_t len;
-	GLuint vao;
-	GLuint coords;
-	GLuint chars;
+	size_t size;          // of the arrays below, in characters
+	char *chars;          // ASCII only
+	float (*coords)[2];   // of the bottom-left corner of each glyph
 	unsigned width;
 	unsigned height;
 };
@@ -1,142 +1,191 @@
 #include "error.h"
+#include "image.h"
 #include "memory.h"
 #include "sprite.h"
 #include "texture.h"
 #include <assert.h>
-#include <png.h>
-#include <setjmp.h>
 #include <stdlib.h>
 
-static void*
-read_image(const char *filename, unsigned int *r_width, unsigned int *r_height)
-{
-	assert(filename != NULL);
+static int filter = TEXTURE_FILTER_NEAREST;
 
-	void *data = NULL;
-	png_structp png_ptr = NULL;
-	png_infop info_ptr = NULL;
-	png_bytepp rows = NULL;
-
-	// open the given file
-	FILE *fp = fopen(filename, "rb");
-	if (!fp) {
-		error(ERR_FILE_READ);
-		return NULL;
-	}
+void
+texture_set_filter(int new_filter)
+{
+	filter = new_filter;
+}
 
-	// attempt to read 8 bytes and check whether we're reading a PNG file
-	size_t hdr_size = 8;
-	unsigned char hdr[hdr_size];
-	if (fread(hdr, 1, hdr_size, fp) < hdr_size ||
-	    png_sig_cmp(hdr, 0, hdr_size) != 0) {
-		error(ERR_FILE_BAD);
-		goto error;
+void
+texture_apply_filter(GLenum target)
+{
+	if (filter == TEXTURE_FILTER_TRILINEAR) {
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(
+			target,
+			GL_TEXTURE_MIN_FILTER,
+			GL_LINEAR_MIPMAP_LINEAR
+		);
+		glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 1000);
+		glGenerateMipmap(target);
+	} else {
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
 	}
+}
 
-	// allocate libpng structs
-	png_ptr = png_create_read_struct(
-		PNG_LIBPNG_VER_STRING,
-		NULL,
-		NULL,
-		NULL
+/**
+ * Whether to upload compressed pixels of an image.
+ */
+static int
+use_compressed(const struct Image *image)
+{
+	return (
+		image->pixels[IMAGE_FORMAT_BC3] &&
+		GLEW_EXT_texture_compression_s3tc &&
+		filter == TEXTURE_FILTER_NEAREST
 	);
-	if (!png_ptr) {
-		error(ERR_LIBPNG);
-		goto error;
-	}
-
-	info_ptr = png_create_info_struct(png_ptr);
-	if (!info_ptr) {
-		error(ERR_LIBPNG);
-
-	}
-
-	// set the error handling longjmp point
-	if (setjmp(png_jmpbuf(png_ptr))) {
-		error(ERR_FILE_BAD);
-		goto error;
-	}
-
-	// init file reading IO
-	png_init_io(png_ptr, fp);
-	png_set_sig_bytes(png_ptr, hdr_size);
-
-	// read image information
-	png_read_info(png_ptr, info_ptr);
-
-	// get image info
-	int color_type = info_ptr->color_type;
-	int bit_depth = info_ptr->bit_depth;
+}
 
-	// transform paletted images to RGB
-	if (color_type == PNG_COLOR_TYPE_PALETTE) {
-		png_set_palette_to_rgb(png_ptr);
-	}
+/**
+ * Upload the pixels of a layer in given format.
+ */
+static int
+upload_layer(const struct Image *image, unsigned layer, int format)
+{
+	if (format == IMAGE_FORMAT_BC3) {
+		glCompressedTexSubImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			0,
+			0,
+			0,
+			layer,
+			image->width,
+			image->height,
+			1,
+			GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+			image->sizes[IMAGE_FORMAT_BC3],
+			image->pixels[IMAGE_FORMAT_BC3]
+		);
+	} else {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			0,
+			0,
+			0,
+			layer,
+			image->width,
+			image->height,
+			1,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			image->pixels[IMAGE_FORMAT_RGBA8]
+		);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+	return glGetError() == GL_NO_ERROR;
+}
 
-	// transform packed grayscale images to 8bit
-	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
-		png_set_gray_1_2_4_to_8(png_ptr);
-	} else if (color_type == PNG_COLOR_TYPE_GRAY ||
-	           color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
-		png_set_gray_to_rgb(png_ptr);
+/**
+ * Create a texture array with given images as layers.
+ *
+ * Returns the handle of the texture, or 0 on failure.
+ */
+static GLuint
+new_array_texture(struct Image **images, size_t count)
+{
+	unsigned width = images[0]->width;
+	unsigned height = images[0]->height;
+
+	// use compressed storage only if all the layers have compressed pixels
+	int format = IMAGE_FORMAT_BC3;
+	for (size_t i = 0; i < count; i++) {
+		assert(images[i]->width == width);
+		assert(images[i]->height == height);
+		if (!use_compressed(images[i])) {
+			format = IMAGE_FORMAT_RGBA8;
+		}
+	}
+
+	GLuint hnd = 0;
+	glGenTextures(1, &hnd);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, hnd);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	if (format == IMAGE_FORMAT_BC3) {
+		glCompressedTexImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			0,
+			GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+			width,
+			height,
+			count,
+			0,
+			images[0]->sizes[IMAGE_FORMAT_BC3] * count,
+			NULL
+		);
+	} else {
+		glTexImage3D(
+			GL_TEXTURE_2D_ARRAY,
+			0,
+			GL_RGBA8,
+			width,
+			height,
+			count,
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			NULL
+		);
+	}
+
+	int ok = hnd && glGetError() == GL_NO_ERROR;
+	for (size_t i = 0; ok && i < count; i++) {
+		ok = upload_layer(images[i], i, format);
+	}
+	if (ok) {
+		texture_apply_filter(GL_TEXTURE_2D_ARRAY);
+		ok = glGetError() == GL_NO_ERROR;
+	}
+	if (!ok) {
+		error(ERR_OPENGL);
+		glDeleteTextures(1, &hnd);
+		return 0;
 	}
+	return hnd;
+}
 
-	// strip 16bit images down to 8bit
-	else if (bit_depth == 16) {
-		png_set_strip_16(png_ptr);
-	}
-	// expand 1-byte packed pixels
-	else if (bit_depth < 8) {
-		png_set_packing(png_ptr);
-	}
+struct TextureArray*
+texture_array_new(struct Image **images, size_t count)
+{
+	assert(images != NULL);
+	assert(count > 0);
 
-	// add full alpha channel
-	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
-		png_set_tRNS_to_alpha(png_ptr);
+	struct TextureArray *array = make(struct TextureArray);
+	if (!array) {
+		return NULL;
 	}
+	array->width = images[0]->width;
+	array->height = images[0]->height;
+	array->layers = count;
 
-	// retrieve image size
-	int width = png_get_image_width(png_ptr, info_ptr);
-	int height = png_get_image_height(png_ptr, info_ptr);
-
-	if (r_width) {
-		*r_width = width;
-	}
-	if (r_height) {
-		*r_height = height;
+	if (!(array->hnd = new_array_texture(images, count))) {
+		texture_array_destroy(array);
+		return NULL;
 	}
 
-	// allocate space for image data
-	size_t rowbytes = png_get_rowbytes(png_ptr, info_ptr);
-	data = malloc(height * rowbytes);
-	if (!data) {
-		error(ERR_NO_MEM);
-		goto error;
-	}
+	return array;
+}
 
-	// setup an array of image row pointers
-	rows = malloc(height * sizeof(png_bytep));
-	if (!rows) {
-		error(ERR_NO_MEM);
-		goto error;
-	}
-	for (size_t r = 0; r < height; r++) {
-		rows[r] = data + rowbytes * r;
+void
+texture_array_destroy(struct TextureArray *array)
+{
+	if (array) {
+		glDeleteTextures(1, &array->hnd);
+		destroy(array);
 	}
-
-	// read image data
-	png_read_image(png_ptr, rows);
-
-cleanup:
-	free(rows);
-	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-	fclose(fp);
-	return data;
-
-error:
-	free(data);
-	data = NULL;
-	goto cleanup;
 }
 
 struct Texture*
@@ -150,45 +199,21 @@ texture_from_file(const char *filename)
 		return NULL;
 	}
 
-	// read PNG image
-	void *image_data = read_image(
-		filename,
-		&texture->width,
-		&texture->height
-	);
-	if (!image_data) {
+	// read the image
+	struct Image *image = image_load(filename);
+	if (!image) {
 		goto error;
 	}
+	texture->width = image->width;
+	texture->height = image->height;
 
 	// create and initialize OpenGL texture
-	glGenTextures(1, &texture->hnd);
-	glBindTexture(GL_TEXTURE_RECTANGLE, texture->hnd);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_BASE_LEVEL, 0);
-	glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAX_LEVEL, 0);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glTexImage2D(
-		GL_TEXTURE_RECTANGLE,
-		0,
-		GL_RGBA8,
-		texture->width,
-		texture->height,
-		0,
-		GL_RGBA,
-		GL_UNSIGNED_BYTE,
-		image_data
-	);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-	if (glGetError() != GL_NO_ERROR || !texture->hnd) {
-		error(ERR_OPENGL);
+	if (!(texture->hnd = new_array_texture(&image, 1))) {
 		goto error;
 	}
 
 cleanup:
-	free(image_data);
+	image_destroy(image);
 	return texture;
 
 error:
@@ -204,4 +229,4 @@ texture_destroy(struct Texture *texture)
 		glDeleteTextures(1, &texture->hnd);
 		destroy(texture);
 	}
-}
\ No newline at end of file
+}
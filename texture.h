@@ -1,12 +1,66 @@
 #pragma once
 
+#include <GL/glew.h>
+#include <stddef.h>
+
+struct Image;
+
+/**
+ * Texture, sampled as the single layer of a `GL_TEXTURE_2D_ARRAY`, the same
+ * way as texture arrays are.
+ */
 struct Texture {
 	GLuint hnd;
 	unsigned width, height;
 };
 
+/**
+ * Array of equally sized textures, sampled as layers of a single
+ * `GL_TEXTURE_2D_ARRAY`.
+ */
+struct TextureArray {
+	GLuint hnd;
+	unsigned width, height;
+	unsigned layers;
+};
+
+/**
+ * Texture filters.
+ */
+enum {
+	TEXTURE_FILTER_NEAREST,     // texels as they are, for unscaled images
+	TEXTURE_FILTER_TRILINEAR,   // mipmapped, for scaled ones
+};
+
+/**
+ * Set the filter of textures created from now on.
+ *
+ * Trilinear filtering requires mipmaps, which are generated from
+ * uncompressed pixels, thus, compressed ones are not used with it.
+ */
+void
+texture_set_filter(int filter);
+
+/**
+ * Configure the filtering of the texture bound to given target, once its
+ * pixels are uploaded.
+ */
+void
+texture_apply_filter(GLenum target);
+
 struct Texture*
 texture_from_file(const char *filename);
 
 void
-texture_destroy(struct Texture *texture);
\ No newline at end of file
+texture_destroy(struct Texture *texture);
+
+/**
+ * Create a texture array with given images as layers, in the same order.
+ *
+ * All images must have the same size.
+ */
+struct TextureArray*
+texture_array_new(struct Image **images, size_t count);
+
+void
+texture_array_destroy(struct TextureArray *array);
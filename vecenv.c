@@ -0,0 +1,389 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "error.h"
+#include "game.h"
+#include "memory.h"
+#include "script.h"
+#include "vecenv.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct Env {
+	struct World *world;
+	struct ScriptEnv *script;
+	struct WorldSnapshot initial; // world state episodes start from
+	unsigned long steps;
+	float hitpoints;              // player hitpoints after the last step
+	int credits;                  // player credits after the last step
+};
+
+/**
+ * Worker stepping a contiguous range of environments.
+ */
+struct Worker {
+	struct VecEnv *venv;
+	pthread_t thread;
+	size_t first;
+	size_t count;
+	int ok;
+};
+
+struct VecEnv {
+	struct Env *envs;
+	size_t count;
+	char *script;
+	unsigned long max_steps;
+	uint64_t seed;
+
+	// the first worker runs on the calling thread
+	struct Worker *workers;
+	unsigned worker_count;
+	unsigned thread_count;        // worker threads actually started
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	unsigned long job;            // incremented for each job
+	unsigned busy;                // workers yet to finish the job
+	int quit;
+
+	// job parameters
+	int reset;
+	const int *actions;
+	float *obs;
+	float *rewards;
+	uint8_t *dones;
+};
+
+/**
+ * Create the world and the script of an environment.
+ */
+static int
+init_env(struct VecEnv *venv, struct Env *env)
+{
+	if (!(env->world = world_new())) {
+		return 0;
+	}
+	env->world->quiet = 1;
+	if (!(env->script = script_env_new()) ||
+	    !script_env_init(env->script, env->world)) {
+		return 0;
+	}
+	script_env_seed(env->script, venv->seed + (env - venv->envs));
+	return (
+		script_env_load_file(env->script, venv->script) &&
+		world_save(env->world, &env->initial)
+	);
+}
+
+static int
+reset_env(struct VecEnv *venv, struct Env *env)
+{
+	// the world is restored to its initial state and the script run anew,
+	// without reading it again
+	if (!env->world) {
+		if (!init_env(venv, env)) {
+			return 0;
+		}
+	} else {
+		world_restore(env->world, &env->initial);
+		if (!script_env_restart(env->script)) {
+			return 0;
+		}
+	}
+	if (!script_env_tick(env->script)) {
+		return 0;
+	}
+	env->steps = 0;
+	env->hitpoints = env->world->player.hitpoints;
+	env->credits = env->world->player.credits;
+	return 1;
+}
+
+static int
+step_env(
+	struct VecEnv *venv,
+	struct Env *env,
+	int actions,
+	float *r_reward,
+	uint8_t *r_done
+) {
+	struct World *world = env->world;
+	const struct Player *plr = &world->player;
+
+	// the world stops updating either when the game is over or on failure
+	world_set_actions(world, actions);
+	int running = world_update(world, SIMULATION_STEP);
+	if (!running && plr->hitpoints > 0) {
+		return 0;
+	}
+	env->steps++;
+	if (running &&
+	    env->steps % STEPS_PER_TICK == 0 &&
+	    !script_env_tick(env->script)) {
+		return 0;
+	}
+
+	*r_reward = (
+		(float)(plr->credits - env->credits) / ENEMY_CREDIT_YIELD -
+		(env->hitpoints - plr->hitpoints) / PLAYER_INITIAL_HITPOINTS
+	);
+	env->credits = plr->credits;
+	env->hitpoints = plr->hitpoints;
+
+	*r_done = !running || (venv->max_steps && env->steps >= venv->max_steps);
+	if (*r_done) {
+		return reset_env(venv, env);
+	}
+	return 1;
+}
+
+static void
+observe(struct Env *env, float *obs)
+{
+	const float half_w = SCREEN_WIDTH / 2;
+	const float half_h = SCREEN_HEIGHT / 2;
+	const struct Player *plr = &env->world->player;
+
+	*obs++ = plr->x / half_w;
+	*obs++ = plr->y / half_h;
+	*obs++ = plr->hitpoints / PLAYER_INITIAL_HITPOINTS;
+	*obs++ = plr->shoot_cooldown * PLAYER_ACTION_SHOOT_RATE;
+
+	struct Body *nearest[VEC_ENV_NEAREST];
+	size_t count = sim_query_nearest(
+		env->world->sim,
+		scalar_from_float(plr->x),
+		scalar_from_float(plr->y),
+		BODY_TYPE_ENEMY | BODY_TYPE_ASTEROID,
+		nearest,
+		VEC_ENV_NEAREST
+	);
+	for (size_t i = 0; i < count; i++) {
+		const struct Body *body = nearest[i];
+		*obs++ = (scalar_to_float(body->x) - plr->x) / half_w;
+		*obs++ = (scalar_to_float(body->y) - plr->y) / half_h;
+		*obs++ = scalar_to_float(body->xvel) / PLAYER_INITIAL_SPEED;
+		*obs++ = scalar_to_float(body->yvel) / PLAYER_INITIAL_SPEED;
+		*obs++ = body->type == BODY_TYPE_ENEMY;
+		*obs++ = body->type == BODY_TYPE_ASTEROID;
+	}
+	memset(
+		obs,
+		0,
+		sizeof(float) * (VEC_ENV_NEAREST - count) * VEC_ENV_ENTITY_FEATURES
+	);
+}
+
+static int
+run_job(struct Worker *w)
+{
+	struct VecEnv *venv = w->venv;
+	for (size_t i = w->first; i < w->first + w->count; i++) {
+		struct Env *env = &venv->envs[i];
+		if (venv->reset) {
+			if (!reset_env(venv, env)) {
+				return 0;
+			}
+		} else if (!step_env(
+			venv,
+			env,
+			venv->actions[i],
+			&venv->rewards[i],
+			&venv->dones[i]
+		)) {
+			return 0;
+		}
+		observe(env, &venv->obs[i * VEC_ENV_OBS_SIZE]);
+	}
+	return 1;
+}
+
+static void*
+run(void *w_ptr)
+{
+	struct Worker *w = w_ptr;
+	struct VecEnv *venv = w->venv;
+	unsigned long job = 0;
+	for (;;) {
+		pthread_mutex_lock(&venv->lock);
+		while (venv->job == job && !venv->quit) {
+			pthread_cond_wait(&venv->start, &venv->lock);
+		}
+		if (venv->quit) {
+			pthread_mutex_unlock(&venv->lock);
+			break;
+		}
+		job = venv->job;
+		pthread_mutex_unlock(&venv->lock);
+
+		w->ok = run_job(w);
+
+		pthread_mutex_lock(&venv->lock);
+		if (--venv->busy == 0) {
+			pthread_cond_signal(&venv->done);
+		}
+		pthread_mutex_unlock(&venv->lock);
+	}
+	return NULL;
+}
+
+/**
+ * Run the current job on all workers and wait for it to finish.
+ */
+static int
+dispatch(struct VecEnv *venv)
+{
+	pthread_mutex_lock(&venv->lock);
+	venv->busy = venv->worker_count - 1;
+	venv->job++;
+	pthread_cond_broadcast(&venv->start);
+	pthread_mutex_unlock(&venv->lock);
+
+	int ok = run_job(&venv->workers[0]);
+
+	pthread_mutex_lock(&venv->lock);
+	while (venv->busy > 0) {
+		pthread_cond_wait(&venv->done, &venv->lock);
+	}
+	pthread_mutex_unlock(&venv->lock);
+
+	for (unsigned i = 1; i < venv->worker_count; i++) {
+		ok &= venv->workers[i].ok;
+	}
+	return ok;
+}
+
+struct VecEnv*
+vec_env_new(
+	size_t count,
+	unsigned threads,
+	const char *script,
+	unsigned long max_steps,
+	uint64_t seed
+) {
+	assert(count > 0);
+	assert(script != NULL);
+
+	struct VecEnv *venv = make(struct VecEnv);
+	if (!venv) {
+		return NULL;
+	}
+	pthread_mutex_init(&venv->lock, NULL);
+	pthread_cond_init(&venv->start, NULL);
+	pthread_cond_init(&venv->done, NULL);
+	venv->count = count;
+	venv->max_steps = max_steps;
+	venv->seed = seed;
+
+	if (!(venv->script = copy(script, strlen(script) + 1))) {
+		goto error;
+	}
+
+	// the worlds are created on first reset
+	if (!(venv->envs = alloc0(sizeof(struct Env) * count))) {
+		goto error;
+	}
+
+	// split environments evenly among workers
+	if (threads == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? cpus : 1;
+	}
+	if (threads > count) {
+		threads = count;
+	}
+	if (!(venv->workers = alloc0(sizeof(struct Worker) * threads))) {
+		goto error;
+	}
+	venv->worker_count = threads;
+	for (unsigned i = 0; i < threads; i++) {
+		struct Worker *w = &venv->workers[i];
+		w->venv = venv;
+		w->first = count * i / threads;
+		w->count = count * (i + 1) / threads - w->first;
+	}
+
+	for (unsigned i = 1; i < threads; i++) {
+		struct Worker *w = &venv->workers[i];
+		if (pthread_create(&w->thread, NULL, run, w) != 0) {
+			error(ERR_THREAD);
+			goto error;
+		}
+		venv->thread_count++;
+	}
+
+	return venv;
+
+error:
+	vec_env_destroy(venv);
+	return NULL;
+}
+
+void
+vec_env_destroy(struct VecEnv *venv)
+{
+	if (venv) {
+		pthread_mutex_lock(&venv->lock);
+		venv->quit = 1;
+		pthread_cond_broadcast(&venv->start);
+		pthread_mutex_unlock(&venv->lock);
+		for (unsigned i = 0; i < venv->thread_count; i++) {
+			pthread_join(venv->workers[i + 1].thread, NULL);
+		}
+		pthread_cond_destroy(&venv->done);
+		pthread_cond_destroy(&venv->start);
+		pthread_mutex_destroy(&venv->lock);
+
+		if (venv->envs) {
+			for (size_t i = 0; i < venv->count; i++) {
+				script_env_destroy(venv->envs[i].script);
+				world_destroy(venv->envs[i].world);
+				world_snapshot_release(&venv->envs[i].initial);
+			}
+		}
+		destroy(venv->envs);
+		destroy(venv->workers);
+		destroy(venv->script);
+		destroy(venv);
+	}
+}
+
+int
+vec_env_reset(struct VecEnv *venv, float *r_obs)
+{
+	assert(r_obs != NULL);
+	venv->reset = 1;
+	venv->obs = r_obs;
+	return dispatch(venv);
+}
+
+int
+vec_env_step(
+	struct VecEnv *venv,
+	const int *actions,
+	float *r_obs,
+	float *r_rewards,
+	uint8_t *r_dones
+) {
+	assert(actions != NULL);
+	assert(r_obs != NULL);
+	assert(r_rewards != NULL);
+	assert(r_dones != NULL);
+	assert(venv->envs[0].world != NULL);
+
+	venv->reset = 0;
+	venv->actions = actions;
+	venv->obs = r_obs;
+	venv->rewards = r_rewards;
+	venv->dones = r_dones;
+	return dispatch(venv);
+}
+
+size_t
+vec_env_count(const struct VecEnv *venv)
+{
+	return venv->count;
+}
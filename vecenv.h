@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VEC_ENV_NEAREST 8          // entities observed around the player
+#define VEC_ENV_PLAYER_FEATURES 4  // x, y, hitpoints, shoot cooldown
+#define VEC_ENV_ENTITY_FEATURES 6  // dx, dy, xvel, yvel, enemy, asteroid
+#define VEC_ENV_OBS_SIZE ( \
+	VEC_ENV_PLAYER_FEATURES + \
+	VEC_ENV_NEAREST * VEC_ENV_ENTITY_FEATURES \
+)
+
+/**
+ * Batch of headless game environments, for training agents.
+ *
+ * Each environment runs its own world and script; a step applies an action
+ * bitmask (`ACTION_*` bits) to each of them and advances all of them by one
+ * `SIMULATION_STEP`, spread over worker threads.
+ *
+ * Observations are written into a contiguous `count * VEC_ENV_OBS_SIZE`
+ * float tensor, one row per environment: player position and hitpoints,
+ * followed by features of the nearest enemies and asteroids, nearest first,
+ * as found by `sim_query_nearest()`. Positions and velocities are relative
+ * to the player and scaled to roughly [-1, 1]; missing entities are zeros.
+ *
+ * The reward is the number of enemies killed minus the fraction of initial
+ * hitpoints lost during the step. Environments whose episode is done are
+ * reset right away, and the observation written for them is the first one
+ * of the next episode. Worlds are reset in place and scripts run anew,
+ * without being read again, and neither of them prints anything.
+ *
+ * Nothing here depends on SDL or OpenGL.
+ */
+struct VecEnv;
+
+/**
+ * Create a batch of environments running given game script.
+ *
+ * Episodes are cut after `max_steps` steps, unless it is 0. With `threads`
+ * 0, as many threads as there are processors are used.
+ *
+ * The script of environment `i` draws random numbers from a generator of its
+ * own, seeded by `seed + i`, which goes on over its episodes; thus, given the
+ * same seed and actions, environments play out the same.
+ */
+struct VecEnv*
+vec_env_new(
+	size_t count,
+	unsigned threads,
+	const char *script,
+	unsigned long max_steps,
+	uint64_t seed
+);
+
+void
+vec_env_destroy(struct VecEnv *venv);
+
+/**
+ * Reset all environments and write their initial observations.
+ */
+int
+vec_env_reset(struct VecEnv *venv, float *r_obs);
+
+/**
+ * Advance all environments by one step.
+ *
+ * Takes an action bitmask per environment and writes an observation row,
+ * a reward and a done flag per environment.
+ */
+int
+vec_env_step(
+	struct VecEnv *venv,
+	const int *actions,
+	float *r_obs,
+	float *r_rewards,
+	uint8_t *r_dones
+);
+
+size_t
+vec_env_count(const struct VecEnv *venv);
@@ -1,30 +1,14 @@
-#include "error.h"
 #include "memory.h"
 #include "widget.h"
 
 struct Widget*
 widget_new(void)
 {
-	struct Widget *widget = make(struct Widget);
-	if (!widget) {
-		return NULL;
-	}
-
-	glGenVertexArrays(1, &widget->vao);
-	if (glGetError() != GL_NO_ERROR || !widget->vao) {
-		error(ERR_OPENGL);
-		widget_destroy(widget);
-		return NULL;
-	}
-
-	return widget;
+	return make(struct Widget);
 }
 
 void
 widget_destroy(struct Widget *widget)
 {
-	if (widget) {
-		glDeleteVertexArrays(1, &widget->vao);
-		destroy(widget);
-	}
+	destroy(widget);
 }
\ No newline at end of file